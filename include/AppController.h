@@ -1,14 +1,24 @@
 #pragma once
 
 #include "WindowManager.h"
+#include "BindlessResources.h"
 #include "DeviceManager.h"
 #include "Renderer.h"
 #include "Constants.h"
 #include "Descriptors.h"
 #include "Entity.h"
 #include "EntityComponents.h"
+#include "FrameAllocator.h"
+#include "FrameReadback.h"
+#include "GeometryArena.h"
+#include "ModelRegistry.h"
+#include "ParallelCommandRecorder.h"
+#include "PipelineCompiler.h"
+#include "ShaderWatcher.h"
+#include "ThreadPool.h"
 
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace Vulkan3DEngine
@@ -17,23 +27,54 @@ namespace Vulkan3DEngine
 	class AppController
 	{
 	private:
-		WindowManager winManager{ AppConstants::DEFAULT_WINDOW_WIDTH, AppConstants::DEFAULT_WINDOW_HEIGHT, AppConstants::APP_NAME };
+		int framesInFlight;		// sizes every per-frame resource below
+		bool headless;			// render offscreen without a window or surface
+
+		WindowManager winManager{
+			AppConstants::DEFAULT_WINDOW_WIDTH,
+			AppConstants::DEFAULT_WINDOW_HEIGHT,
+			AppConstants::APP_NAME,
+			headless
+		};
 		DeviceManager devManager{ winManager };
-		Renderer renderer{ winManager, devManager };
+		Renderer renderer{ winManager, devManager, framesInFlight };
+		FrameAllocator frameAllocator{ devManager, framesInFlight, AppConstants::FRAME_ALLOCATOR_CAPACITY };
+		GeometryArena geometryArena{
+			devManager,
+			AppConstants::GEOMETRY_ARENA_VERTEX_CAPACITY,
+			AppConstants::GEOMETRY_ARENA_INDEX_CAPACITY,
+			renderer.getDeletionQueue()
+		};
+		ModelRegistry modelRegistry{ devManager, geometryArena, renderer.getDeletionQueue() };
+
+		std::unique_ptr<DescriptorSetCache> descriptorSetCache{};
+		std::vector<std::unique_ptr<DescriptorAllocator>> frameDescriptorAllocators;	// reset every frame
+		std::unique_ptr<BindlessResources> bindlessResources{};	// null without descriptor indexing
+		std::unique_ptr<ShaderWatcher> shaderWatcher{};	// null when the shader sources are not available
 
-		std::unique_ptr<DescriptorPoolManager> globalPoolManager{};
+		// declared after the resources tasks may use, so the workers are joined before those are destroyed
+		ThreadPool threadPool{};
+		PipelineCompiler pipelineCompiler{ devManager, threadPool };
+		ParallelCommandRecorder commandRecorder{ devManager, threadPool, framesInFlight };
 
 		EntityMap entities;
 		Entity::id_t nextEntityId = 1;
 
 	public:
-		AppController();
+		AppController(int framesInFlight = AppConstants::DEFAULT_FRAMES_IN_FLIGHT, bool headless = false);
 		~AppController();
 
 		AppController(const AppController&) = delete;
 		AppController& operator=(const AppController&) = delete;
 
-		void run();
+		// a frameLimit of 0 renders until the window is closed; frames are exported as an image sequence
+		// to exportDirectory unless it is empty
+		void run(
+			uint64_t frameLimit = 0,
+			const std::string& exportDirectory = {},
+			FrameReadback::Format exportFormat = FrameReadback::Format::Png
+		);
+		void benchmarkDescriptors();
 
 	private:
 		void loadEntities();
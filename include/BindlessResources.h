@@ -0,0 +1,112 @@
+#pragma once
+
+#include "DeferredDeletionQueue.h"
+#include "Descriptors.h"
+#include "DeviceManager.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Vulkan3DEngine
+{
+
+	// One global descriptor set with large partially bound arrays of storage buffers, sampled images and
+	// samplers. Resources are registered once and addressed from shaders by their slot index, so per draw
+	// data only carries integers and the set is bound once per command buffer. Needs descriptor indexing,
+	// see DeviceManager::isDescriptorIndexingSupported.
+	class BindlessResources
+	{
+	public:
+		enum class Kind
+		{
+			StorageBuffer,
+			SampledImage,
+			Sampler
+		};
+		static constexpr size_t KIND_COUNT = 3;
+
+		// binding of each array, matching the order of Kind
+		static constexpr uint32_t STORAGE_BUFFER_BINDING = 0;
+		static constexpr uint32_t SAMPLED_IMAGE_BINDING = 1;
+		static constexpr uint32_t SAMPLER_BINDING = 2;
+
+		// upper bounds, lowered to the device's update after bind limits
+		static constexpr uint32_t MAX_STORAGE_BUFFERS = 16384;
+		static constexpr uint32_t MAX_SAMPLED_IMAGES = 16384;
+		static constexpr uint32_t MAX_SAMPLERS = 256;
+
+		struct Statistics
+		{
+			uint32_t capacity[KIND_COUNT];
+			uint32_t used[KIND_COUNT];
+			size_t pendingReleases;
+		};
+
+	private:
+		// Hands out array indices, reusing released ones before growing
+		class SlotAllocator
+		{
+		private:
+			std::vector<uint32_t> freeSlots;
+			uint32_t nextSlot = 0;
+			uint32_t capacity;
+
+		public:
+			explicit SlotAllocator(uint32_t capacity);
+
+			bool allocate(uint32_t& slot);
+			void free(uint32_t slot);
+			uint32_t getUsed() const;
+			uint32_t getCapacity() const;
+		};
+
+		DeviceManager& devManager;
+		std::unique_ptr<DescriptorSetLayoutManager> setLayoutManager;
+		std::unique_ptr<DescriptorPoolManager> poolManager;
+		VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+
+		mutable std::mutex mutex;
+		std::vector<SlotAllocator> slots;	// indexed by Kind
+		size_t pendingReleaseCount = 0;
+		DeferredDeletionQueue& deletionQueue;
+
+	public:
+		BindlessResources(DeviceManager& devManager, DeferredDeletionQueue& deletionQueue);
+		~BindlessResources();
+
+		BindlessResources(const BindlessResources&) = delete;
+		BindlessResources& operator=(const BindlessResources&) = delete;
+
+		uint32_t registerStorageBuffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+		uint32_t registerSampledImage(
+			VkImageView imageView,
+			VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+		);
+		uint32_t registerSampler(VkSampler sampler);
+		void release(Kind kind, uint32_t slot);
+
+		void bind(
+			VkCommandBuffer commandBuffer,
+			VkPipelineLayout pipelineLayout,
+			uint32_t setIndex,
+			VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS
+		) const;
+
+		VkDescriptorSetLayout getDescriptorSetLayout() const;
+		Statistics getStatistics() const;
+
+	private:
+		uint32_t allocateSlot(Kind kind);
+		void writeDescriptor(
+			Kind kind,
+			uint32_t slot,
+			const VkDescriptorBufferInfo* bufferInfo,
+			const VkDescriptorImageInfo* imageInfo
+		);
+		static uint32_t getBinding(Kind kind);
+		static VkDescriptorType getDescriptorType(Kind kind);
+	};
+
+}
\ No newline at end of file
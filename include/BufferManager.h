@@ -11,7 +11,7 @@ namespace Vulkan3DEngine
         DeviceManager& deviceManager;
         void* mapped = nullptr;
         VkBuffer buffer = VK_NULL_HANDLE;
-        VkDeviceMemory memory = VK_NULL_HANDLE;
+        MemoryAllocator::Allocation allocation;
 
         VkDeviceSize bufferSize;
         uint32_t instanceCount;
@@ -20,6 +20,9 @@ namespace Vulkan3DEngine
         VkBufferUsageFlags usageFlags;
         VkMemoryPropertyFlags memoryPropertyFlags;
 
+        bool hostCoherent;
+        VkDeviceSize nonCoherentAtomSize;
+
 	public:
         BufferManager(
             DeviceManager& deviceManager,
@@ -27,7 +30,9 @@ namespace Vulkan3DEngine
             uint32_t instanceCount,
             VkBufferUsageFlags usageFlags,
             VkMemoryPropertyFlags memoryPropertyFlags,
-            VkDeviceSize minOffsetAlignment = 1
+            VkDeviceSize minOffsetAlignment = 1,
+            MemoryAllocator::Category category = MemoryAllocator::Category::Other,
+            VkMemoryPropertyFlags preferredMemoryPropertyFlags = 0
         );
         ~BufferManager();
 
@@ -55,8 +60,11 @@ namespace Vulkan3DEngine
         VkBufferUsageFlags getUsageFlags() const;
         VkMemoryPropertyFlags getMemoryPropertyFlags() const;
         VkDeviceSize getBufferSize() const;
+        bool isHostCoherent() const;
 
     private:
+        VkMappedMemoryRange getMappedRange(VkDeviceSize size, VkDeviceSize offset) const;
+
         static VkDeviceSize getAlignment(VkDeviceSize instanceSize, VkDeviceSize minOffsetAlignment);
 	};
 
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 namespace Vulkan3DEngine
 {
 	struct AppConstants
@@ -17,8 +19,30 @@ namespace Vulkan3DEngine
 		static constexpr int DEFAULT_WINDOW_WIDTH = 800;
 		static constexpr int DEFAULT_WINDOW_HEIGHT = 600;
 
-		static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
+		// frames the CPU may record ahead of the GPU, chosen at startup with --frames-in-flight
+		static constexpr int MIN_FRAMES_IN_FLIGHT = 1;
+		static constexpr int MAX_FRAMES_IN_FLIGHT = 4;
+		static constexpr int DEFAULT_FRAMES_IN_FLIGHT = 2;
+
+		// headless runs have no window to close, they stop after this many frames unless told otherwise
+		static constexpr uint64_t DEFAULT_HEADLESS_FRAME_COUNT = 1000;
 
 		static constexpr int MAX_LIGHTS = 10;
+
+		// baked into the lit shaders as specialization constants
+		static constexpr float SPECULAR_EXPONENT = 512.0f;
+		static constexpr bool ENABLE_SPECULAR = true;
+
+		static constexpr uint32_t GEOMETRY_ARENA_VERTEX_CAPACITY = 1u << 20;
+		static constexpr uint32_t GEOMETRY_ARENA_INDEX_CAPACITY = 1u << 22;
+
+		// shares of the geometry arena: models are evicted once all resident ones exceed the first, or
+		// the ones nobody references anymore exceed the second
+		static constexpr double MODEL_RESIDENT_BUDGET_FRACTION = 0.75;
+		static constexpr double MODEL_CACHE_BUDGET_FRACTION = 0.25;
+
+		static constexpr uint64_t FRAME_ALLOCATOR_CAPACITY = 16ull * 1024 * 1024;	// per frame in flight
+
+		static constexpr const char* PIPELINE_CACHE_PATH = "pipeline_cache.bin";
 	};
 }
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Vulkan3DEngine
+{
+
+	// Defers releasing anything frames in flight may still use. A release queued while frame N is the
+	// latest one runs once frame N + framesInFlight has waited on its fence, i.e. once frame N is done.
+	// The renderer owns the queue and advances it, so every user counts the same frames.
+	class DeferredDeletionQueue
+	{
+	private:
+		struct PendingRelease
+		{
+			std::function<void()> release;
+			uint64_t frame;
+		};
+
+		std::mutex mutex;
+		std::vector<PendingRelease> pendingReleases;
+		uint64_t frameCounter = 0;
+		int framesInFlight;
+
+	public:
+		explicit DeferredDeletionQueue(int framesInFlight);
+		~DeferredDeletionQueue();
+
+		DeferredDeletionQueue(const DeferredDeletionQueue&) = delete;
+		DeferredDeletionQueue& operator=(const DeferredDeletionQueue&) = delete;
+
+		// may be called from any thread; the release runs on the thread advancing the queue
+		void enqueue(std::function<void()> release);
+
+		// keeps the object alive until no frame in flight can use it
+		template<typename T>
+		void retire(std::shared_ptr<T> object)
+		{
+			enqueue([object = std::move(object)]() mutable { object.reset(); });
+		}
+
+		void nextFrame();
+		void flush();		// only while the device is idle
+	};
+
+}
\ No newline at end of file
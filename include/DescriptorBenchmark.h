@@ -0,0 +1,21 @@
+#pragma once
+
+#include "DeviceManager.h"
+#include "FrameAllocator.h"
+
+#include <cstdint>
+
+namespace Vulkan3DEngine
+{
+
+	// Times the ways of pointing a two binding set at new buffer ranges: DescriptorWriter, an update
+	// template and, when the device supports them, push descriptors. Run with --bench-descriptors.
+	class DescriptorBenchmark
+	{
+	public:
+		static constexpr uint32_t DEFAULT_ITERATIONS = 100000;
+
+		static void run(DeviceManager& devManager, FrameAllocator& frameAllocator, uint32_t iterations = DEFAULT_ITERATIONS);
+	};
+
+}
\ No newline at end of file
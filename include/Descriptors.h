@@ -1,13 +1,60 @@
 #pragma once
 
 #include "DeviceManager.h"
+#include "HashUtils.h"
 
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 #include <vector>
 
 namespace Vulkan3DEngine
 {
+    // Flattened description of a layout or of a set's contents, compared in full on lookup
+    using DescriptorKey = std::vector<uint64_t>;
+
+    struct DescriptorKeyHash
+    {
+        size_t operator()(const DescriptorKey& key) const
+        {
+            return static_cast<size_t>(HashUtils::hashBytes(key.data(), key.size() * sizeof(uint64_t)));
+        }
+    };
+
+    // Owns every descriptor set layout of the device, so identical binding lists share one layout
+    class DescriptorLayoutCache
+    {
+    public:
+        struct Statistics
+        {
+            size_t layoutCount = 0;
+            size_t hitCount = 0;
+        };
+
+    private:
+        DeviceManager& devManager;
+
+        mutable std::mutex mutex;
+        std::unordered_map<DescriptorKey, VkDescriptorSetLayout, DescriptorKeyHash> layouts;
+        size_t hitCount = 0;
+
+    public:
+        DescriptorLayoutCache(DeviceManager& devManager);
+        ~DescriptorLayoutCache();
+
+        DescriptorLayoutCache(const DescriptorLayoutCache&) = delete;
+        DescriptorLayoutCache& operator=(const DescriptorLayoutCache&) = delete;
+
+        VkDescriptorSetLayout getLayout(
+            std::vector<VkDescriptorSetLayoutBinding> bindings,
+            const std::unordered_map<uint32_t, VkDescriptorBindingFlags>& bindingFlags = {},
+            VkDescriptorSetLayoutCreateFlags layoutFlags = 0
+        );
+
+        Statistics getStatistics() const;
+    };
+
     class DescriptorSetLayoutManager 
     {
     public:
@@ -16,6 +63,8 @@ namespace Vulkan3DEngine
         private:
             DeviceManager& devManager;
             std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings{};
+            std::unordered_map<uint32_t, VkDescriptorBindingFlags> bindingFlags{};
+            VkDescriptorSetLayoutCreateFlags layoutFlags = 0;
 
         public:
             Builder(DeviceManager& devManager);
@@ -24,8 +73,10 @@ namespace Vulkan3DEngine
                 uint32_t binding,
                 VkDescriptorType descriptorType,
                 VkShaderStageFlags stageFlags,
-                uint32_t count = 1
+                uint32_t count = 1,
+                VkDescriptorBindingFlags flags = 0
             );
+            Builder& setLayoutFlags(VkDescriptorSetLayoutCreateFlags flags);
             std::unique_ptr<DescriptorSetLayoutManager> build() const;
         };
 
@@ -35,12 +86,16 @@ namespace Vulkan3DEngine
         std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings;
 
         friend class DescriptorWriter;
+        friend class DescriptorSetCache;
+        friend class DescriptorUpdateTemplate;
 
     public:
         DescriptorSetLayoutManager(
             DeviceManager& devManager, 
             std::unordered_map<uint32_t, 
-            VkDescriptorSetLayoutBinding> bindings
+            VkDescriptorSetLayoutBinding> bindings,
+            const std::unordered_map<uint32_t, VkDescriptorBindingFlags>& bindingFlags = {},
+            VkDescriptorSetLayoutCreateFlags layoutFlags = 0
         );
         ~DescriptorSetLayoutManager();
 
@@ -97,15 +152,76 @@ namespace Vulkan3DEngine
         void resetPool();
     };
 
+    // Allocates descriptor sets from a chain of pools, creating a larger pool whenever the current one
+    // runs out. reset() recycles every pool at once, for sets that only live for one frame.
+    class DescriptorAllocator
+    {
+    public:
+        struct PoolSizeRatio
+        {
+            VkDescriptorType descriptorType;
+            float ratio;    // descriptors of this type per set
+        };
+
+        struct Statistics
+        {
+            uint32_t poolCount = 0;
+            uint32_t fullPoolCount = 0;
+            uint32_t allocationCount = 0;           // sets allocated since the last reset
+            uint64_t totalAllocationCount = 0;
+            uint32_t resetCount = 0;
+        };
+
+        static constexpr uint32_t DEFAULT_SETS_PER_POOL = 64;
+        static constexpr uint32_t MAX_SETS_PER_POOL = 4096;
+
+    private:
+        DeviceManager& devManager;
+        std::vector<PoolSizeRatio> poolSizeRatios;
+        uint32_t setsPerPool;
+
+        mutable std::mutex mutex;
+        std::vector<VkDescriptorPool> readyPools;
+        std::vector<VkDescriptorPool> fullPools;
+        uint32_t allocationCount = 0;
+        uint64_t totalAllocationCount = 0;
+        uint32_t resetCount = 0;
+
+    public:
+        DescriptorAllocator(
+            DeviceManager& devManager,
+            const std::vector<PoolSizeRatio>& poolSizeRatios,
+            uint32_t initialSetsPerPool = DEFAULT_SETS_PER_POOL
+        );
+        ~DescriptorAllocator();
+
+        DescriptorAllocator(const DescriptorAllocator&) = delete;
+        DescriptorAllocator& operator=(const DescriptorAllocator&) = delete;
+
+        VkDescriptorSet allocate(VkDescriptorSetLayout descriptorSetLayout);
+        void reset();
+
+        Statistics getStatistics() const;
+
+    private:
+        VkDescriptorPool getPool();
+        VkDescriptorPool createPool(uint32_t maxSets);
+    };
+
     class DescriptorWriter 
     {
     private:
         DescriptorSetLayoutManager& setLayout;
-        DescriptorPoolManager& pool;
+        DescriptorPoolManager* pool = nullptr;
+        DescriptorAllocator* allocator = nullptr;
         std::vector<VkWriteDescriptorSet> writes;
 
+        friend class DescriptorSetCache;
+
     public:
         DescriptorWriter(DescriptorSetLayoutManager& setLayout, DescriptorPoolManager& pool);
+        DescriptorWriter(DescriptorSetLayoutManager& setLayout, DescriptorAllocator& allocator);
+        explicit DescriptorWriter(DescriptorSetLayoutManager& setLayout);	// for DescriptorSetCache::get
 
         DescriptorWriter& writeBuffer(uint32_t binding, VkDescriptorBufferInfo* bufferInfo);
         DescriptorWriter& writeImage(uint32_t binding, VkDescriptorImageInfo* imageInfo);
@@ -114,4 +230,120 @@ namespace Vulkan3DEngine
         void overwrite(VkDescriptorSet& set);
     };
 
+    // Update template generated from a layout's bindings. The caller fills one Entry per descriptor,
+    // laid out in binding order (see getEntryIndex), and the driver reads them in a single call instead
+    // of walking a list of VkWriteDescriptorSet. The push variant records the descriptors straight into
+    // a command buffer (VK_KHR_push_descriptor), which needs a layout with the push descriptor flag.
+    class DescriptorUpdateTemplate
+    {
+    public:
+        union Entry
+        {
+            VkDescriptorBufferInfo buffer;
+            VkDescriptorImageInfo image;
+            VkBufferView texelBufferView;
+        };
+
+    private:
+        DeviceManager& devManager;
+        VkDescriptorUpdateTemplate updateTemplate = VK_NULL_HANDLE;
+        VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+        uint32_t set = 0;
+        std::unordered_map<uint32_t, uint32_t> firstEntries;    // binding -> index of its first entry
+        uint32_t entryCount = 0;
+
+    public:
+        DescriptorUpdateTemplate(DeviceManager& devManager, const DescriptorSetLayoutManager& setLayout);
+        DescriptorUpdateTemplate(
+            DeviceManager& devManager,
+            const DescriptorSetLayoutManager& setLayout,
+            VkPipelineLayout pipelineLayout,
+            uint32_t set,
+            VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS
+        );
+        ~DescriptorUpdateTemplate();
+
+        DescriptorUpdateTemplate(const DescriptorUpdateTemplate&) = delete;
+        DescriptorUpdateTemplate& operator=(const DescriptorUpdateTemplate&) = delete;
+
+        uint32_t getEntryCount() const;
+        uint32_t getEntryIndex(uint32_t binding, uint32_t arrayElement = 0) const;
+
+        void update(VkDescriptorSet descriptorSet, const Entry* entries) const;
+        void push(VkCommandBuffer commandBuffer, const Entry* entries) const;
+
+    private:
+        void create(
+            const DescriptorSetLayoutManager& setLayout,
+            VkDescriptorUpdateTemplateType templateType,
+            VkPipelineBindPoint bindPoint
+        );
+    };
+
+
+    // Reuses descriptor sets whose layout and written resources match a set built before. Each frame in
+    // flight has its own sets, so a set is never rewritten or freed while the GPU may still read it.
+    // Sets are keyed on the raw buffer, image view and sampler handles, and the driver may hand out the
+    // handle of a destroyed resource again: whoever destroys a resource that may have been written
+    // through the cache has to invalidate it first, or a new resource would hit the stale set.
+    class DescriptorSetCache
+    {
+    public:
+        struct Statistics
+        {
+            size_t cachedSets = 0;
+            uint64_t hitCount = 0;
+            uint64_t missCount = 0;
+            uint32_t flushCount = 0;
+        };
+
+        // A frame's sets are all dropped at the start of the frame once it holds this many
+        static constexpr size_t MAX_SETS_PER_FRAME = 1024;
+
+    private:
+        struct CachedSet
+        {
+            VkDescriptorSet set;
+            std::vector<uint64_t> resources;    // handles written to the set, for invalidation
+        };
+
+        struct FrameSets
+        {
+            std::unique_ptr<DescriptorAllocator> allocator;
+            std::unordered_map<DescriptorKey, CachedSet, DescriptorKeyHash> sets;
+            size_t allocatedSets = 0;   // invalidated sets stay allocated until the allocator is reset
+        };
+
+        std::vector<FrameSets> frames;
+        int currentFrame = 0;
+        uint64_t hitCount = 0;
+        uint64_t missCount = 0;
+        uint32_t flushCount = 0;
+
+    public:
+        DescriptorSetCache(
+            DeviceManager& devManager,
+            int frameCount,
+            const std::vector<DescriptorAllocator::PoolSizeRatio>& poolSizeRatios
+        );
+        ~DescriptorSetCache();
+
+        DescriptorSetCache(const DescriptorSetCache&) = delete;
+        DescriptorSetCache& operator=(const DescriptorSetCache&) = delete;
+
+        void beginFrame(int frameIndex);
+        VkDescriptorSet get(DescriptorWriter& writer);
+        void invalidateBuffer(VkBuffer buffer);
+        void invalidateImageView(VkImageView imageView);
+        void invalidateSampler(VkSampler sampler);
+        void clear();
+
+        Statistics getStatistics() const;
+
+    private:
+        void invalidate(uint64_t handle);
+        static DescriptorKey makeKey(const DescriptorWriter& writer);
+        static std::vector<uint64_t> collectResources(const DescriptorWriter& writer);
+    };
+
 }
\ No newline at end of file
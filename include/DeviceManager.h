@@ -1,13 +1,20 @@
 #pragma once
 
+#include "MemoryAllocator.h"
+#include "StagingRing.h"
+#include "UploadBatcher.h"
 #include "WindowManager.h"
 
+#include <memory>
 #include <string>
 #include <vector>
 #include <optional>
 
 namespace Vulkan3DEngine
 {
+	class DescriptorLayoutCache;
+	class ShaderModuleCache;
+	class PipelineStateCache;
 
 	struct SwapChainSupportDetails
 	{
@@ -20,9 +27,18 @@ namespace Vulkan3DEngine
 	{
 		std::optional<uint32_t> graphicsFamily;
 		std::optional<uint32_t> presentFamily;
+		std::optional<uint32_t> transferFamily;		// family without graphics support, if the device has one
 		bool isComplete() { return graphicsFamily.has_value() && presentFamily.has_value(); }
 	};
 
+	struct HeapBudget
+	{
+		VkDeviceSize size;
+		VkDeviceSize budget;	// how much the process can use before allocations may fail or degrade
+		VkDeviceSize usage;		// current usage, including other resources of the process when reported by the driver
+		bool deviceLocal;
+	};
+
 	class DeviceManager
 	{
 	public:
@@ -33,20 +49,44 @@ namespace Vulkan3DEngine
 #endif
 		VkPhysicalDeviceProperties physicalDeviceProperties;
 
+		// Fraction of a heap treated as the budget when VK_EXT_memory_budget is not available
+		static constexpr float FALLBACK_HEAP_BUDGET = 0.8f;
+
 	private:
 		const std::vector<const char*> validationLayers = { "VK_LAYER_KHRONOS_validation" };
 		const std::vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
 
+		uint32_t instanceApiVersion = VK_API_VERSION_1_0;
+		bool memoryBudgetSupported = false;
+		bool descriptorIndexingSupported = false;
+		bool descriptorIndexingExtension = false;	// true when it comes from VK_EXT_descriptor_indexing rather than 1.2
+		VkPhysicalDeviceDescriptorIndexingProperties descriptorIndexingProperties{};
+		bool pushDescriptorSupported = false;
+		uint32_t maxPushDescriptors = 0;
+		PFN_vkCmdPushDescriptorSetWithTemplateKHR pushDescriptorSetWithTemplate = nullptr;
+		VkPhysicalDeviceMemoryProperties memoryProperties;
+
 		VkInstance instance;
 		VkDebugUtilsMessengerEXT debugMessenger;
 		VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
 		WindowManager& windowManager;
 		VkCommandPool commandPool;
+		VkPipelineCache pipelineCache = VK_NULL_HANDLE;
 
 		VkDevice device;
-		VkSurfaceKHR surface;
+		VkSurfaceKHR surface = VK_NULL_HANDLE;	// null when headless
 		VkQueue graphicsQueue;
 		VkQueue presentQueue;
+		VkQueue transferQueue;
+		uint32_t transferQueueFamily;
+		std::vector<uint32_t> bufferQueueFamilies;	// families sharing buffers when transfers use their own queue
+
+		std::unique_ptr<MemoryAllocator> memoryAllocator;
+		std::unique_ptr<StagingRing> stagingRing;
+		std::unique_ptr<UploadBatcher> uploadBatcher;
+		std::unique_ptr<DescriptorLayoutCache> descriptorLayoutCache;
+		std::unique_ptr<ShaderModuleCache> shaderModuleCache;
+		std::unique_ptr<PipelineStateCache> pipelineStateCache;
 
 	public:
 		DeviceManager(WindowManager& windowManager);
@@ -58,13 +98,45 @@ namespace Vulkan3DEngine
 		DeviceManager& operator=(DeviceManager&&) = delete;
 
 		VkCommandPool getCommandPoolHandle() const;
+		VkPipelineCache getPipelineCacheHandle() const;
 		VkDevice getDeviceHandle() const;
 		VkSurfaceKHR getSurfaceHandle() const;
 		VkQueue getGraphicsQueueHandle() const;
 		VkQueue getPresentQueueHandle() const;
+		VkQueue getTransferQueueHandle() const;
+		MemoryAllocator& getMemoryAllocator() const;
+		StagingRing& getStagingRing() const;
+		UploadBatcher& getUploadBatcher() const;
+		DescriptorLayoutCache& getDescriptorLayoutCache() const;
+		ShaderModuleCache& getShaderModuleCache() const;
+		PipelineStateCache& getPipelineStateCache() const;
 
 		SwapChainSupportDetails getSwapChainSupport();
-		uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+		uint32_t findMemoryType(
+			uint32_t typeFilter,
+			VkMemoryPropertyFlags properties,
+			VkDeviceSize size = 0,
+			VkMemoryPropertyFlags preferredProperties = 0
+		) const;
+		VkMemoryPropertyFlags getMemoryTypeProperties(uint32_t memoryTypeIndex) const;
+		std::vector<HeapBudget> getMemoryBudget() const;
+		bool isMemoryBudgetSupported() const;
+		void printMemoryReport() const;
+		const VkPhysicalDeviceProperties& getPhysicalDeviceProperties() const;
+		bool isDescriptorIndexingSupported() const;
+		const VkPhysicalDeviceDescriptorIndexingProperties& getDescriptorIndexingProperties() const;
+		bool isApiVersion11Supported() const;
+		bool isDescriptorUpdateTemplateSupported() const;
+		bool isDedicatedAllocationSupported() const;
+		bool isPushDescriptorSupported() const;
+		uint32_t getMaxPushDescriptors() const;
+		void cmdPushDescriptorSetWithTemplate(
+			VkCommandBuffer commandBuffer,
+			VkDescriptorUpdateTemplate descriptorUpdateTemplate,
+			VkPipelineLayout pipelineLayout,
+			uint32_t set,
+			const void* data
+		) const;
 		QueueFamilyIndices getQueueFamilies();
 		VkFormat findSupportedFormat(
 			const std::vector<VkFormat>& candidates, 
@@ -77,19 +149,25 @@ namespace Vulkan3DEngine
 			VkBufferUsageFlags usage,
 			VkMemoryPropertyFlags properties,
 			VkBuffer& buffer,
-			VkDeviceMemory& bufferMemory
+			MemoryAllocator::Allocation& bufferAllocation,
+			MemoryAllocator::Category category = MemoryAllocator::Category::Other,
+			VkMemoryPropertyFlags preferredProperties = 0
 		);
+		void destroyBuffer(VkBuffer buffer, MemoryAllocator::Allocation& bufferAllocation);
 		VkCommandBuffer beginSingleTimeCommands();
-		void endSingleTimeCommands(VkCommandBuffer commandBuffer);
-		void copyBuffer(VkBuffer src, VkBuffer dst, VkDeviceSize size);
+		void endSingleTimeCommands(VkCommandBuffer commandBuffer, VkFence fence = VK_NULL_HANDLE);
+		void copyBuffer(VkBuffer src, VkBuffer dst, VkDeviceSize size, VkDeviceSize srcOffset = 0, VkDeviceSize dstOffset = 0);
 		void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount);
 
 		void createImageWithInfo(
 			const VkImageCreateInfo& createInfo,
 			VkMemoryPropertyFlags properties,
 			VkImage& image,
-			VkDeviceMemory& imageMemory
+			MemoryAllocator::Allocation& imageAllocation,
+			MemoryAllocator::Category category = MemoryAllocator::Category::Other,
+			VkMemoryPropertyFlags preferredProperties = 0
 		);
+		void destroyImage(VkImage image, MemoryAllocator::Allocation& imageAllocation);
 
 	private:
 		void createInstance();
@@ -98,14 +176,27 @@ namespace Vulkan3DEngine
 		void selectPhysicalDevice();
 		void createLogicalDevice();
 		void createCommandPool();
+		void createPipelineCache();
+		void savePipelineCache();
+		void createMemoryAllocator();
+		void createStagingRing();
+		void createUploadBatcher();
+		void createDescriptorLayoutCache();
+		void createShaderCaches();
 
 		bool isDeviceSuitable(VkPhysicalDevice device);
 		std::vector<const char*> getRequiredExtensions();
+		std::vector<const char*> getRequiredDeviceExtensions() const;
 		bool checkValidationLayerSupport();
 		QueueFamilyIndices queryQueueFamilies(VkPhysicalDevice device);
 		void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo);
 		void hasGflwRequiredInstanceExtensions();
 		bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+		bool isDeviceExtensionAvailable(VkPhysicalDevice device, const char* extensionName);
+		bool isPipelineCacheCompatible(const std::vector<char>& cacheData) const;
+		void queryDescriptorIndexingSupport();
+		void queryPushDescriptorSupport();
+		static VkPhysicalDeviceDescriptorIndexingFeatures getRequiredDescriptorIndexingFeatures();
 		SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
 	};
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <string>
 #include <vector>
 
@@ -9,7 +10,35 @@ namespace Vulkan3DEngine
 	class FileUtils
 	{
 	public:
+		// Read-only memory mapping of a whole file, unmapped on destruction
+		class MappedFile
+		{
+		private:
+			const unsigned char* data = nullptr;
+			size_t size = 0;
+#ifdef _WIN32
+			void* fileHandle = nullptr;
+			void* mappingHandle = nullptr;
+#else
+			int fileDescriptor = -1;
+#endif
+
+		public:
+			explicit MappedFile(const std::string& filePath);
+			~MappedFile();
+
+			MappedFile(const MappedFile&) = delete;
+			MappedFile& operator=(const MappedFile&) = delete;
+
+			const unsigned char* getData() const;
+			size_t getSize() const;
+
+		private:
+			void close();
+		};
+
 		static std::vector<char> readBinaryFile(const std::string& filePath);
+		static void writeBinaryFile(const std::string& filePath, const void* data, size_t size);
 	};
 
 }
\ No newline at end of file
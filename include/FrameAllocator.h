@@ -0,0 +1,66 @@
+#pragma once
+
+#include "BufferManager.h"
+#include "DeviceManager.h"
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace Vulkan3DEngine
+{
+
+	// One persistently mapped uniform/storage buffer per frame in flight, handed out in aligned slices by bumping
+	// an offset. Slices are bound through dynamic offsets and recycled when their frame comes around again.
+	// Device local host visible memory is preferred when the device exposes it.
+	class FrameAllocator
+	{
+	public:
+		struct Slice
+		{
+			VkBuffer buffer;
+			uint32_t offset;		// dynamic offset to bind the slice with
+			VkDeviceSize size;
+			void* mapped;
+		};
+
+	private:
+		std::vector<std::unique_ptr<BufferManager>> frameBuffers;
+		VkDeviceSize capacity;
+		VkDeviceSize alignment;
+
+		int currentFrame = 0;
+		std::atomic<VkDeviceSize> head{ 0 };
+		VkDeviceSize peakBytes = 0;
+
+	public:
+		FrameAllocator(DeviceManager& devManager, int frameCount, VkDeviceSize capacity);
+		~FrameAllocator();
+
+		FrameAllocator(const FrameAllocator&) = delete;
+		FrameAllocator& operator=(const FrameAllocator&) = delete;
+
+		void beginFrame(int frameIndex);
+		Slice allocate(VkDeviceSize size);
+		VkResult flush();
+
+		template<typename T>
+		Slice push(const T& data)
+		{
+			Slice slice = allocate(sizeof(T));
+			std::memcpy(slice.mapped, &data, sizeof(T));
+			return slice;
+		}
+
+		VkDescriptorBufferInfo descriptorInfo(int frameIndex, VkDeviceSize range) const;
+		VkBuffer getBuffer(int frameIndex) const;
+		int getFrameCount() const;
+
+		VkDeviceSize getAlignment() const;
+		VkDeviceSize getCapacity() const;
+		VkDeviceSize getUsedBytes() const;
+		VkDeviceSize getPeakBytes() const;
+	};
+
+}
\ No newline at end of file
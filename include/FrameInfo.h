@@ -2,7 +2,11 @@
 
 #include "Camera.h"
 #include "Constants.h"
+#include "Descriptors.h"
 #include "Entity.h"
+#include "FrameAllocator.h"
+#include "GeometryArena.h"
+#include "ParallelCommandRecorder.h"
 
 #include <vulkan/vulkan.h>
 
@@ -28,10 +32,15 @@ namespace Vulkan3DEngine
 	{
 		int frameIndex;
 		float frameTime;
-		VkCommandBuffer cmdBuffer;
+		VkCommandBuffer cmdBuffer;		// primary, inside the render pass only secondaries from commandRecorder are executed
 		Camera& camera;
 		VkDescriptorSet globalDescSet;
 		const EntityMap& entities;
+		const GeometryArena& geometryArena;
+		FrameAllocator& frameAllocator;
+		DescriptorAllocator& frameDescriptorAllocator;	// sets allocated here are freed when the frame index comes around again
+		uint32_t globalUboOffset;		// dynamic offset of this frame's GlobalUbo within globalDescSet
+		ParallelCommandRecorder& commandRecorder;
 	};
 
 }
\ No newline at end of file
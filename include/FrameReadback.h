@@ -0,0 +1,104 @@
+#pragma once
+
+#include "BufferManager.h"
+#include "DeviceManager.h"
+#include "ThreadPool.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Vulkan3DEngine
+{
+
+	// Exports rendered frames as an image sequence without stalling the GPU. The final color image is
+	// copied into one of a ring of host visible buffers at the end of the frame, and the buffer is only
+	// read once the renderer has waited for that frame's fence again, a few frames later. Encoding and
+	// writing the file happens on the thread pool; rendering only waits when every buffer of the ring is
+	// still being written out, i.e. when the disk cannot keep up.
+	class FrameReadback
+	{
+	public:
+		enum class Format
+		{
+			Png,	// 8 bit RGB, deflate stored blocks, so bigger files but cheap to encode
+			Raw		// tightly packed 8 bit RGBA rows, top row first, extent in the file name
+		};
+
+		struct Statistics
+		{
+			uint64_t capturedFrames = 0;
+			uint64_t writtenFrames = 0;
+			uint64_t failedFrames = 0;
+			uint64_t writtenBytes = 0;
+			uint64_t stallCount = 0;		// captures that had to wait for a buffer to be written out
+			double stallSeconds = 0.0;
+		};
+
+	private:
+		enum class SlotState { Free, Copying, Encoding };
+
+		struct Slot
+		{
+			std::unique_ptr<BufferManager> buffer{};
+			SlotState state = SlotState::Free;
+			int frameIndex = 0;			// the frame whose fence guards the copy
+			uint64_t frameNumber = 0;
+			VkExtent2D extent{};
+			bool swapRedBlue = false;	// copied from a BGRA image
+		};
+
+		DeviceManager& devManager;
+		ThreadPool& threadPool;
+		std::string outputDirectory;
+		Format format;
+
+		std::vector<Slot> slots;
+		size_t nextSlot = 0;
+		uint64_t nextFrameNumber = 0;
+
+		// guards the slot states, the statistics and pendingEncodes, which the encode tasks update
+		mutable std::mutex mutex;
+		std::condition_variable slotFreed;
+		uint32_t pendingEncodes = 0;
+		Statistics statistics{};
+
+	public:
+		FrameReadback(
+			DeviceManager& devManager,
+			ThreadPool& threadPool,
+			int framesInFlight,
+			const std::string& outputDirectory,
+			Format format
+		);
+		~FrameReadback();
+
+		FrameReadback(const FrameReadback&) = delete;
+		FrameReadback& operator=(const FrameReadback&) = delete;
+
+		// call once the frame's fence has been waited for, hands the copies it guarded to the encoder
+		void beginFrame(int frameIndex);
+
+		// image has to be in TRANSFER_SRC_OPTIMAL with the frame's writes visible to transfers
+		void record(VkCommandBuffer commandBuffer, VkImage image, VkFormat imageFormat, VkExtent2D extent, int frameIndex);
+
+		// call after the device is idle, writes out the remaining frames and waits for all of them
+		void finish();
+
+		Statistics getStatistics() const;
+
+		static bool isFormatSupported(VkFormat imageFormat);
+
+	private:
+		void dispatch(int frameIndex);
+		void encode(Slot& slot);
+		void waitForEncodes();
+
+		static std::vector<unsigned char> encodePng(const unsigned char* pixels, VkExtent2D extent, bool swapRedBlue);
+		static std::vector<unsigned char> encodeRaw(const unsigned char* pixels, VkExtent2D extent, bool swapRedBlue);
+	};
+
+}
\ No newline at end of file
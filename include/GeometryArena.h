@@ -0,0 +1,90 @@
+#pragma once
+
+#include "BufferManager.h"
+#include "DeferredDeletionQueue.h"
+#include "DeviceManager.h"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace Vulkan3DEngine
+{
+
+	// One vertex buffer and one index buffer shared by all models, sub-allocated in element ranges
+	class GeometryArena
+	{
+	public:
+		struct Range
+		{
+			uint32_t offset = 0;	// in elements
+			uint32_t count = 0;
+		};
+
+		// thrown when a range does not fit; callers can free ranges and retry
+		class OutOfSpaceError : public std::runtime_error
+		{
+		public:
+			using std::runtime_error::runtime_error;
+		};
+
+		struct Statistics
+		{
+			uint32_t vertexCapacity;
+			uint32_t verticesUsed;
+			uint32_t indexCapacity;
+			uint32_t indicesUsed;
+		};
+
+	private:
+		// First fit free list keyed by offset, merging neighbours on free
+		class FreeList
+		{
+		private:
+			std::map<uint32_t, uint32_t> freeRanges;	// offset -> count
+			uint32_t used = 0;
+
+		public:
+			explicit FreeList(uint32_t capacity);
+
+			bool allocate(uint32_t count, Range& range);
+			void free(const Range& range);
+			uint32_t getUsed() const;
+		};
+
+		std::unique_ptr<BufferManager> vertBufferManager;
+		std::unique_ptr<BufferManager> idxBufferManager;
+
+		mutable std::mutex mutex;
+		FreeList vertexRanges;
+		FreeList indexRanges;
+		DeferredDeletionQueue& deletionQueue;
+
+	public:
+		GeometryArena(
+			DeviceManager& devManager,
+			uint32_t vertexCapacity,
+			uint32_t indexCapacity,
+			DeferredDeletionQueue& deletionQueue
+		);
+		~GeometryArena();
+
+		GeometryArena(const GeometryArena&) = delete;
+		GeometryArena& operator=(const GeometryArena&) = delete;
+
+		Range allocateVertices(uint32_t count);
+		Range allocateIndices(uint32_t count);
+		void freeVertices(const Range& range);
+		void freeIndices(const Range& range);
+
+		void bind(VkCommandBuffer commandBuffer) const;
+
+		VkBuffer getVertexBuffer() const;
+		VkBuffer getIndexBuffer() const;
+		Statistics getStatistics() const;
+	};
+
+}
\ No newline at end of file
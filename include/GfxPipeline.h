@@ -3,12 +3,53 @@
 #include "DeviceManager.h"
 #include "Model.h"
 
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace Vulkan3DEngine
 {
 
+	// Specialization constant values for one shader stage, baked into the pipeline when it is created
+	class SpecializationConstants
+	{
+	private:
+		std::vector<VkSpecializationMapEntry> mapEntries;
+		std::vector<uint8_t> data;
+
+	public:
+		// Booleans must be passed as VkBool32, SPIR-V booleans are 32 bits wide
+		template<typename T>
+		SpecializationConstants& set(uint32_t constantId, const T& value)
+		{
+			static_assert(std::is_trivially_copyable_v<T> && !std::is_same_v<T, bool>);
+			for (auto& entry : mapEntries) {
+				if (entry.constantID == constantId) {
+					assert(entry.size == sizeof(T) && "Specialization constant set again with a different type");
+					std::memcpy(data.data() + entry.offset, &value, sizeof(T));
+					return *this;
+				}
+			}
+			uint32_t offset = static_cast<uint32_t>(data.size());
+			mapEntries.push_back({ constantId, offset, sizeof(T) });
+			data.resize(offset + sizeof(T));
+			std::memcpy(data.data() + offset, &value, sizeof(T));
+			return *this;
+		}
+
+		bool empty() const;
+		VkSpecializationInfo getInfo() const;	// points into this object
+		const std::vector<VkSpecializationMapEntry>& getMapEntries() const;
+		const std::vector<uint8_t>& getData() const;
+	};
+
 	struct PipelineConfigInfo
 	{
 		std::vector<VkVertexInputBindingDescription> bindingDescriptions{};
@@ -25,6 +66,8 @@ namespace Vulkan3DEngine
 		VkPipelineLayout pipelineLayout = nullptr;
 		VkRenderPass renderPass = nullptr;
 		uint32_t subpass = 0;
+		SpecializationConstants vertSpecialization;
+		SpecializationConstants fragSpecialization;
 
 		PipelineConfigInfo() = default;
 		PipelineConfigInfo(const PipelineConfigInfo&) = delete;
@@ -36,18 +79,25 @@ namespace Vulkan3DEngine
 	private:
 		DeviceManager& deviceManager;
 		VkPipeline pipeline;
-		VkShaderModule vertShaderModule;
-		VkShaderModule fragShaderModule;
 
 	public:
 		static void defaultPipelineConfigInfo(PipelineConfigInfo& configInfo);
 		static void enableAlphaBlending(PipelineConfigInfo& configInfo);
 
+		// Shader modules come from the device's ShaderModuleCache, the pipeline does not need them once created
 		GfxPipeline(
 			DeviceManager& deviceManager,
 			const std::string& vertShaderPath, 
 			const std::string& fragShaderPath,
-			const PipelineConfigInfo& configInfo
+			const PipelineConfigInfo& configInfo,
+			VkPipelineCache pipelineCache = VK_NULL_HANDLE	// the device cache when null
+		);
+		GfxPipeline(
+			DeviceManager& deviceManager,
+			VkShaderModule vertShaderModule,
+			VkShaderModule fragShaderModule,
+			const PipelineConfigInfo& configInfo,
+			VkPipelineCache pipelineCache = VK_NULL_HANDLE
 		);
 		~GfxPipeline();
 
@@ -58,12 +108,100 @@ namespace Vulkan3DEngine
 
 	private:
 		void createGraphicsPipeline(
-			const std::string& vertShaderPath, 
+			VkShaderModule vertShaderModule,
+			VkShaderModule fragShaderModule,
+			const PipelineConfigInfo& configInfo,
+			VkPipelineCache pipelineCache
+		);
+	};
+
+	// Shader modules keyed by a hash of their SPIR-V, so pipelines built from the same code share one
+	// module. Modules are owned by the cache; the PipelineStateCache releases those no pipeline uses.
+	class ShaderModuleCache
+	{
+	public:
+		struct Statistics
+		{
+			size_t moduleCount = 0;
+			uint64_t hitCount = 0;
+		};
+
+	private:
+		struct CachedModule
+		{
+			std::vector<char> code;		// compared on lookup, a matching hash alone is not trusted
+			VkShaderModule module;
+		};
+
+		DeviceManager& devManager;
+
+		mutable std::mutex mutex;
+		std::unordered_map<uint64_t, std::vector<CachedModule>> modules;	// SPIR-V hash -> modules
+		uint64_t hitCount = 0;
+
+	public:
+		ShaderModuleCache(DeviceManager& devManager);
+		~ShaderModuleCache();
+
+		ShaderModuleCache(const ShaderModuleCache&) = delete;
+		ShaderModuleCache& operator=(const ShaderModuleCache&) = delete;
+
+		VkShaderModule getModule(const std::vector<char>& code);
+		VkShaderModule getModule(const std::string& filePath);
+		void releaseUnused(const std::unordered_set<VkShaderModule>& inUse);
+
+		Statistics getStatistics() const;
+	};
+
+	// Pipelines keyed by their shader modules, every field of PipelineConfigInfo, the layout and the
+	// render pass. Requesting a pipeline identical to one still in use returns that pipeline; the
+	// cache only holds weak references, so a pipeline is destroyed with its last user.
+	class PipelineStateCache
+	{
+	public:
+		struct Statistics
+		{
+			size_t livePipelineCount = 0;
+			uint64_t hitCount = 0;
+			uint64_t missCount = 0;
+		};
+
+	private:
+		using Key = std::vector<uint64_t>;
+
+		struct KeyHash
+		{
+			size_t operator()(const Key& key) const;
+		};
+
+		DeviceManager& devManager;
+
+		mutable std::mutex mutex;
+		std::unordered_map<Key, std::weak_ptr<GfxPipeline>, KeyHash> pipelines;
+		std::unordered_map<VkShaderModule, uint32_t> buildingModules;	// modules of pipelines being compiled
+		uint64_t hitCount = 0;
+		uint64_t missCount = 0;
+
+	public:
+		PipelineStateCache(DeviceManager& devManager);
+		~PipelineStateCache();
+
+		PipelineStateCache(const PipelineStateCache&) = delete;
+		PipelineStateCache& operator=(const PipelineStateCache&) = delete;
+
+		std::shared_ptr<GfxPipeline> getPipeline(
+			const std::string& vertShaderPath,
 			const std::string& fragShaderPath,
-			const PipelineConfigInfo& configInfo
+			const PipelineConfigInfo& configInfo,
+			VkPipelineCache pipelineCache = VK_NULL_HANDLE
 		);
+		void releaseUnusedShaderModules();
 
-		void createShaderModule(const std::vector<char> codeBytes, VkShaderModule* shaderModule);
+		Statistics getStatistics() const;
+
+	private:
+		void unpinModules(VkShaderModule vertShaderModule, VkShaderModule fragShaderModule);
+		static Key makeKey(VkShaderModule vertShaderModule, VkShaderModule fragShaderModule, const PipelineConfigInfo& configInfo);
 	};
 
 }
\ No newline at end of file
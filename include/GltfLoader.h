@@ -0,0 +1,26 @@
+#pragma once
+
+#include "DeviceManager.h"
+#include "GeometryArena.h"
+#include "Model.h"
+
+#include <memory>
+#include <string>
+
+namespace Vulkan3DEngine
+{
+
+	// Loads the triangle primitives of every mesh in a glTF 2.0 asset (.glb, or .gltf with external buffers)
+	// into a single model. Node transforms, materials and sparse accessors are not supported.
+	class GltfLoader
+	{
+	public:
+		static bool isGltfFile(const std::string& filePath);
+		static std::unique_ptr<Model> loadModel(
+			DeviceManager& devManager,
+			GeometryArena& geometryArena,
+			const std::string& filePath
+		);
+	};
+
+}
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 
 namespace Vulkan3DEngine
@@ -13,5 +15,16 @@ namespace Vulkan3DEngine
 			(hashCombine(seed, rest), ...);
 		};
 
+		// 64-bit FNV-1a over a raw byte range (stable across runs, unlike std::hash)
+		static uint64_t hashBytes(const void* data, std::size_t size, uint64_t seed = 0xcbf29ce484222325ull) {
+			auto bytes = static_cast<const unsigned char*>(data);
+			uint64_t hash = seed;
+			for (std::size_t i = 0; i < size; ++i) {
+				hash ^= bytes[i];
+				hash *= 0x100000001b3ull;
+			}
+			return hash;
+		}
+
 	};
 }
\ No newline at end of file
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+namespace Vulkan3DEngine
+{
+
+	// Sub-allocates buffers and images from large VkDeviceMemory blocks using a buddy allocator
+	class MemoryAllocator
+	{
+	public:
+		// Linear resources (buffers, linear images) and optimal images never share a block,
+		// so bufferImageGranularity never has to be considered between neighbours
+		enum class ResourceKind { Linear, Optimal };
+
+		// What a resource is used for, only used for usage reporting
+		enum class Category { Mesh, Texture, Uniform, Depth, Staging, Other };
+		static constexpr size_t CATEGORY_COUNT = 6;
+
+		// From VkMemoryDedicatedRequirements. The resource is only set where dedicated allocations are
+		// supported (core since 1.1) and is then passed to the driver with VkMemoryDedicatedAllocateInfo.
+		struct DedicatedRequest
+		{
+			VkBuffer buffer = VK_NULL_HANDLE;
+			VkImage image = VK_NULL_HANDLE;
+			bool prefersDedicated = false;
+			bool requiresDedicated = false;
+		};
+
+		static constexpr VkDeviceSize MIN_ALLOCATION_SIZE = 256;
+		static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+		static constexpr VkDeviceSize SMALL_HEAP_SIZE = 1024ull * 1024 * 1024;
+
+	private:
+		struct Block
+		{
+			VkDeviceMemory memory = VK_NULL_HANDLE;
+			VkDeviceSize size = 0;
+			void* mapped = nullptr;
+			std::vector<std::set<VkDeviceSize>> freeLists;	// free offsets per order
+			VkDeviceSize allocatedBytes = 0;
+			uint32_t allocationCount = 0;
+		};
+
+		struct Pool
+		{
+			uint32_t memoryTypeIndex;
+			ResourceKind kind;
+			VkDeviceSize blockSize;
+			std::vector<std::unique_ptr<Block>> blocks;
+		};
+
+	public:
+		struct Allocation
+		{
+			VkDeviceMemory memory = VK_NULL_HANDLE;
+			VkDeviceSize offset = 0;
+			VkDeviceSize size = 0;				// size reserved for the resource, at least the requested size
+			void* mapped = nullptr;				// persistently mapped pointer to offset, null if not host visible
+			uint32_t memoryTypeIndex = 0;
+
+		private:
+			friend class MemoryAllocator;
+			Block* block = nullptr;				// null for dedicated allocations
+			VkDeviceSize requestedSize = 0;
+			ResourceKind kind = ResourceKind::Linear;
+			Category category = Category::Other;
+		};
+
+		struct BlockStatistics
+		{
+			uint32_t memoryTypeIndex;
+			ResourceKind kind;
+			VkDeviceSize size;
+			VkDeviceSize allocatedBytes;
+			VkDeviceSize largestFreeRange;
+			uint32_t allocationCount;
+		};
+
+		struct Statistics
+		{
+			uint32_t blockCount = 0;
+			uint32_t dedicatedAllocationCount = 0;
+			uint32_t allocationCount = 0;			// sub-allocations plus dedicated allocations
+			VkDeviceSize blockBytes = 0;			// device memory reserved by blocks
+			VkDeviceSize dedicatedBytes = 0;
+			VkDeviceSize allocatedBytes = 0;		// sub-allocated bytes after power of two rounding
+			VkDeviceSize requestedBytes = 0;		// sub-allocated bytes as requested
+			VkDeviceSize largestFreeRange = 0;
+			float internalFragmentation = 0.0f;		// share of allocated bytes lost to rounding
+			float externalFragmentation = 0.0f;		// share of free block memory not in the largest free range
+			std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> heapUsage{};		// device memory allocated per heap
+			std::array<VkDeviceSize, CATEGORY_COUNT> categoryBytes{};		// bytes reserved per category
+			std::vector<BlockStatistics> blocks;
+		};
+
+	private:
+		VkDevice device;
+		VkPhysicalDeviceMemoryProperties memoryProperties;
+
+		mutable std::mutex mutex;
+		std::vector<Pool> pools;
+		uint32_t dedicatedAllocationCount = 0;
+		VkDeviceSize dedicatedBytes = 0;
+		VkDeviceSize requestedBytes = 0;
+		std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> heapUsage{};
+		std::array<VkDeviceSize, CATEGORY_COUNT> categoryBytes{};
+
+	public:
+		MemoryAllocator(VkDevice device, const VkPhysicalDeviceMemoryProperties& memoryProperties);
+		~MemoryAllocator();
+
+		MemoryAllocator(const MemoryAllocator&) = delete;
+		MemoryAllocator& operator=(const MemoryAllocator&) = delete;
+
+		Allocation allocate(
+			const VkMemoryRequirements& requirements,
+			uint32_t memoryTypeIndex,
+			ResourceKind kind,
+			Category category = Category::Other,
+			const DedicatedRequest* dedicated = nullptr
+		);
+		void free(Allocation& allocation);
+
+		Statistics getStatistics() const;
+		VkDeviceSize getHeapUsage(uint32_t heapIndex) const;
+
+		static const char* getCategoryName(Category category);
+
+	private:
+		Pool& getPool(uint32_t memoryTypeIndex, ResourceKind kind);
+		VkDeviceSize getBlockSize(uint32_t memoryTypeIndex) const;
+		bool isHostVisible(uint32_t memoryTypeIndex) const;
+		bool isLazilyAllocated(uint32_t memoryTypeIndex) const;
+		uint32_t getHeapIndex(uint32_t memoryTypeIndex) const;
+
+		VkDeviceMemory allocateDeviceMemory(
+			VkDeviceSize size,
+			uint32_t memoryTypeIndex,
+			void** mapped,
+			const DedicatedRequest* dedicated = nullptr
+		);
+		void freeDeviceMemory(VkDeviceMemory memory, void* mapped, VkDeviceSize size, uint32_t memoryTypeIndex);
+
+		bool allocateFromBlock(Block& block, uint32_t order, VkDeviceSize& offset);
+		void freeToBlock(Block& block, VkDeviceSize offset, uint32_t order);
+
+		static uint32_t getOrder(VkDeviceSize size);
+		static VkDeviceSize getOrderSize(uint32_t order);
+		static VkDeviceSize getLargestFreeRange(const Block& block);
+	};
+
+}
\ No newline at end of file
@@ -1,10 +1,12 @@
 #pragma once
 
 #include "DeviceManager.h"
-#include "BufferManager.h"
+#include "GeometryArena.h"
 #include "MathUtils.h"
 
+#include <functional>
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace Vulkan3DEngine
@@ -34,31 +36,64 @@ namespace Vulkan3DEngine
 			void load(const std::string& objPath);
 		};
 
+		// Index range of one draw; indices are relative to vertexOffset
+		struct Primitive
+		{
+			uint32_t firstIndex = 0;
+			uint32_t indexCount = 0;
+			int32_t vertexOffset = 0;
+		};
+
+		// Fills the mapped staging memory for all vertices and indices of the model in place
+		using StagingWriter = std::function<void(Vertex* vertices, uint32_t* indices)>;
+
 	private:
 		DeviceManager& deviceManager;
+		GeometryArena& geometryArena;
 
-		std::unique_ptr<BufferManager> vertBufferManager;
-		uint32_t vertexCount;
+		GeometryArena::Range vertexRange;
+		GeometryArena::Range indexRange;
 
-		bool hasIndexBuffer = false;
-		std::unique_ptr<BufferManager> idxBufferManager;
-		uint32_t indexCount;
+		std::vector<Primitive> primitives;
 
-	public:
-		static std::unique_ptr<Model> createModelFromFile(DeviceManager& devManager, const std::string& filePath);
+		UploadBatcher::Ticket uploadTicket = 0;
+		mutable bool uploaded = false;
 
-		Model(DeviceManager& deviceManager, const Model::Data& modelData);
+	public:
+		static std::unique_ptr<Model> createModelFromFile(
+			DeviceManager& devManager,
+			GeometryArena& geometryArena,
+			const std::string& filePath
+		);
+
+		Model(DeviceManager& deviceManager, GeometryArena& geometryArena, const Model::Data& modelData);
+		Model(
+			DeviceManager& deviceManager,
+			GeometryArena& geometryArena,
+			uint32_t vertexCount,
+			uint32_t indexCount,
+			std::vector<Primitive> primitives,
+			const StagingWriter& writeStaging
+		);
 		~Model();
 
 		Model(const Model&) = delete;
 		Model& operator=(const Model&) = delete;
 
+		// Binds the shared arena buffers; only needed once for any number of models
 		void bind(VkCommandBuffer commandBuffer);
-		void draw(VkCommandBuffer commandBuffer);
+		void draw(VkCommandBuffer commandBuffer, uint32_t firstInstance = 0);
+		void appendDrawCommands(std::vector<VkDrawIndexedIndirectCommand>& commands, uint32_t firstInstance = 0) const;
+
+		// False until the upload of the vertex and index data has finished on the GPU
+		bool isReady() const;
+
+		VkDeviceSize getDeviceMemorySize() const;
+
+		const std::vector<Primitive>& getPrimitives() const;
 
 	private:
-		void createVertexBuffers(const std::vector<Vertex>& vertices);
-		void createIndexBuffer(const std::vector<uint32_t>& indices);
+		void upload(const StagingWriter& writeStaging);
 	};
 
 }
\ No newline at end of file
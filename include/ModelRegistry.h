@@ -0,0 +1,92 @@
+#pragma once
+
+#include "DeferredDeletionQueue.h"
+#include "DeviceManager.h"
+#include "GeometryArena.h"
+#include "Model.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Vulkan3DEngine
+{
+
+	// Loads models once per unique file content. Models nobody references anymore stay cached for reuse
+	// up to the cache budget; beyond that, or once all resident models exceed the resident budget, the
+	// least recently used unreferenced ones are evicted. A load that does not fit into the geometry
+	// arena evicts unreferenced models until it does.
+	class ModelRegistry
+	{
+	public:
+		struct AssetInfo
+		{
+			std::string path;
+			uint64_t contentHash;
+			VkDeviceSize deviceMemorySize;
+			long useCount;		// handles held outside the registry
+			uint64_t lastUsed;
+		};
+
+		struct Statistics
+		{
+			size_t loadedAssets = 0;
+			size_t cachedAssets = 0;			// resident but not referenced by anyone, first to be evicted
+			size_t loads = 0;
+			size_t cacheHits = 0;
+			size_t evictions = 0;
+			VkDeviceSize deviceMemorySize = 0;
+			VkDeviceSize cachedMemorySize = 0;		// held by unreferenced models
+			VkDeviceSize residentBudget = 0;
+			VkDeviceSize cacheBudget = 0;
+		};
+
+	private:
+		struct Entry
+		{
+			std::shared_ptr<Model> model;
+			std::string path;
+			VkDeviceSize deviceMemorySize = 0;
+			uint64_t lastUsed = 0;
+		};
+
+		DeviceManager& devManager;
+		GeometryArena& geometryArena;
+		DeferredDeletionQueue& deletionQueue;
+
+		std::unordered_map<uint64_t, Entry> entries;			// keyed by content hash
+		std::unordered_map<std::string, uint64_t> pathToHash;	// keyed by normalized path
+
+		VkDeviceSize residentBudget;
+		VkDeviceSize cacheBudget;
+		uint64_t currentTick = 0;
+		size_t loadCount = 0;
+		size_t cacheHitCount = 0;
+		size_t evictionCount = 0;
+
+	public:
+		ModelRegistry(DeviceManager& devManager, GeometryArena& geometryArena, DeferredDeletionQueue& deletionQueue);
+		~ModelRegistry();
+
+		ModelRegistry(const ModelRegistry&) = delete;
+		ModelRegistry& operator=(const ModelRegistry&) = delete;
+
+		std::shared_ptr<Model> acquire(const std::string& filePath);
+		void enforceBudget();
+
+		void setResidentBudget(VkDeviceSize budget);
+		void setCacheBudget(VkDeviceSize budget);	// 0 unloads models as soon as their last user is gone
+
+		Statistics getStatistics() const;
+		std::vector<AssetInfo> getLoadedAssets() const;
+
+	private:
+		void evict(uint64_t contentHash);
+		bool evictLeastRecentlyUsed();
+		static bool isReferenced(const Entry& entry);
+		static std::string normalizePath(const std::string& filePath);
+	};
+
+}
\ No newline at end of file
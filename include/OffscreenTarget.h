@@ -0,0 +1,71 @@
+#pragma once
+
+#include "DeviceManager.h"
+#include "RenderTarget.h"
+
+#include <vector>
+
+namespace Vulkan3DEngine
+{
+
+	// Render target for headless runs: one color and depth image per frame in flight instead of a swap
+	// chain. Acquiring waits for the frame's fence and hands out the frame's own image, submitting signals
+	// it again; nothing is presented. Color images are left in TRANSFER_SRC_OPTIMAL so they can be read back.
+	class OffscreenTarget : public RenderTarget
+	{
+	public:
+		static constexpr VkFormat COLOR_FORMAT = VK_FORMAT_R8G8B8A8_SRGB;
+
+	private:
+		DeviceManager& devManager;
+		VkExtent2D extent;
+		VkFormat depthFormat;
+
+		std::vector<VkImage> colorImages;
+		std::vector<MemoryAllocator::Allocation> colorImageAllocations;
+		std::vector<VkImageView> colorImageViews;
+		std::vector<VkImage> depthImages;
+		std::vector<MemoryAllocator::Allocation> depthImageAllocations;
+		std::vector<VkImageView> depthImageViews;
+
+		VkRenderPass renderPass = VK_NULL_HANDLE;	// only for pipeline compatibility
+
+		std::vector<VkFence> inFlightFences;
+		uint32_t currentFrame = 0;
+
+	public:
+		OffscreenTarget(DeviceManager& devManager, VkExtent2D extent, int framesInFlight);
+		~OffscreenTarget();
+
+		OffscreenTarget(const OffscreenTarget&) = delete;
+		OffscreenTarget& operator=(const OffscreenTarget&) = delete;
+
+		VkRenderPass getRenderPass() override;
+		VkImage getImage(int index) override;
+		VkImageView getImageView(int index) override;
+		VkImage getDepthImage(int frameIndex) override;
+		VkImageView getDepthImageView(int frameIndex) override;
+		size_t getImageCount() override;
+		VkFormat getSwapChainImageFormat() override;
+		VkFormat getSwapChainDepthFormat() override;
+		VkExtent2D getSwapChainExtent() override;
+		float extentAspectRatio() override;
+		VkImageLayout getOutputLayout() override;
+		bool supportsReadback() override;
+
+		VkResult acquireNextImage(uint32_t* imageIndex) override;
+		VkResult submitCommandBuffers(
+			const VkCommandBuffer* buffers,
+			uint32_t* imageIndex,
+			const std::vector<VkSemaphore>& uploadSemaphores
+		) override;
+
+	private:
+		void createImages(int count);
+		void createRenderPass();
+		void createSyncObjects(int count);
+
+		VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectMask);
+	};
+
+}
\ No newline at end of file
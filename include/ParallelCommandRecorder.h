@@ -0,0 +1,78 @@
+#pragma once
+
+#include "DeviceManager.h"
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Vulkan3DEngine
+{
+
+	// Records the contents of a render pass into secondary command buffers, splitting each batch of draws
+	// into chunks recorded concurrently on the thread pool and the calling thread. Every chunk slot has its
+	// own command pool per frame in flight, so no pool is ever used by two threads at once. The buffers are
+	// executed in recording order, so draw order is preserved.
+	class ParallelCommandRecorder
+	{
+	public:
+		// Records items [begin, end) into a secondary command buffer that has already been begun inside the
+		// render pass, with viewport and scissor set. May be called from any thread.
+		using RecordFunction = std::function<void(VkCommandBuffer commandBuffer, size_t begin, size_t end)>;
+
+		static constexpr size_t DEFAULT_ITEMS_PER_CHUNK = 256;
+
+	private:
+		struct ChunkSlot
+		{
+			VkCommandPool commandPool = VK_NULL_HANDLE;
+			std::vector<VkCommandBuffer> commandBuffers;
+			size_t usedCount = 0;	// buffers handed out since the pool was last reset
+		};
+
+		struct Job
+		{
+			VkCommandBufferInheritanceInfo inheritanceInfo;
+			VkExtent2D extent;
+			std::vector<VkCommandBuffer> commandBuffers;	// one per chunk
+			std::atomic<size_t> nextChunk{ 0 };
+			size_t completedChunks = 0;
+			std::exception_ptr error;
+			std::mutex mutex;
+			std::condition_variable finished;
+		};
+
+		DeviceManager& devManager;
+		ThreadPool& threadPool;
+
+		std::vector<std::vector<ChunkSlot>> frameSlots;	// [frame in flight][chunk slot]
+		int currentFrame = 0;
+
+		VkCommandBufferInheritanceInfo inheritanceInfo{};
+		VkExtent2D extent{};
+		std::vector<VkCommandBuffer> recordedBuffers;	// this frame's buffers, in execution order
+
+	public:
+		ParallelCommandRecorder(DeviceManager& devManager, ThreadPool& threadPool, int frameCount);
+		~ParallelCommandRecorder();
+
+		ParallelCommandRecorder(const ParallelCommandRecorder&) = delete;
+		ParallelCommandRecorder& operator=(const ParallelCommandRecorder&) = delete;
+
+		void beginFrame(int frameIndex, VkRenderPass renderPass, VkFramebuffer framebuffer, VkExtent2D extent);
+		void record(size_t itemCount, const RecordFunction& recordChunk, size_t minItemsPerChunk = DEFAULT_ITEMS_PER_CHUNK);
+		void execute(VkCommandBuffer primaryCommandBuffer);
+
+		size_t getSlotCount() const;
+
+	private:
+		VkCommandBuffer acquireCommandBuffer(size_t slot);
+		static void recordChunks(Job& job, size_t itemCount, size_t itemsPerChunk, const RecordFunction& recordChunk);
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "DeviceManager.h"
+#include "ThreadPool.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Vulkan3DEngine
+{
+
+	// Collects pipeline builds described by render systems and runs them on the thread pool. Each worker
+	// compiles into a pipeline cache of its own, seeded from the device cache, and the worker caches are
+	// merged back into the device cache once every pipeline is built.
+	class PipelineCompiler
+	{
+	public:
+		using Job = std::function<void(VkPipelineCache pipelineCache)>;
+
+		struct Timing
+		{
+			std::string name;
+			double milliseconds;
+		};
+
+	private:
+		struct PendingJob
+		{
+			std::string name;
+			Job job;
+		};
+
+		DeviceManager& devManager;
+		ThreadPool& threadPool;
+		std::vector<PendingJob> pendingJobs;
+		std::vector<Timing> timings;
+
+	public:
+		PipelineCompiler(DeviceManager& devManager, ThreadPool& threadPool);
+		~PipelineCompiler();
+
+		PipelineCompiler(const PipelineCompiler&) = delete;
+		PipelineCompiler& operator=(const PipelineCompiler&) = delete;
+
+		void enqueue(const std::string& name, Job job);
+		void compileAll();
+
+		const std::vector<Timing>& getTimings() const;
+
+	private:
+		std::vector<char> getDeviceCacheData() const;
+	};
+
+}
\ No newline at end of file
@@ -12,6 +12,7 @@ namespace Vulkan3DEngine
 			DeviceManager& devManager,
 			VkRenderPass renderPass,
 			VkDescriptorSetLayout globalSetLayout,
+			PipelineCompiler* pipelineCompiler = nullptr,
 			const std::string& vertexShaderPath = "shaders/point_light_vert.spv",
 			const std::string& fragmentShaderPath = "shaders/point_light_frag.spv"
 		);
@@ -29,11 +30,7 @@ namespace Vulkan3DEngine
 
 		void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
 
-		void createPipeline(
-			VkRenderPass renderPass,
-			const std::string& vertexShaderPath,
-			const std::string& fragmentShaderPath
-		);
+		void configurePipeline(PipelineConfigInfo& pipelineConfig);
 
 	};
 
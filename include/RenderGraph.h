@@ -0,0 +1,213 @@
+#pragma once
+
+#include "DeviceManager.h"
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Vulkan3DEngine
+{
+
+	// Frame graph of passes that declare the images they read and write. compile() culls passes whose
+	// results are never used, derives the layout transitions and barriers between the remaining passes,
+	// creates render passes for passes with attachments and places transient images whose lifetimes do
+	// not overlap in the same memory. Passes run in declaration order, which is always a valid dependency
+	// order since a pass can only read what earlier passes wrote.
+	//
+	// The graph is compiled once and executed every frame. Imported images, such as the swap chain image,
+	// are set before each execution; transient images are owned by the graph.
+	class RenderGraph
+	{
+	public:
+		using ResourceHandle = uint32_t;
+		using PassHandle = uint32_t;
+
+		enum class Access
+		{
+			ColorAttachment,
+			DepthAttachment,
+			DepthRead,			// depth testing without depth writes
+			SampledRead,		// sampled in fragment shaders
+			StorageRead,		// storage image in compute shaders
+			StorageWrite,
+			TransferRead,
+			TransferWrite
+		};
+
+		struct ImageDesc
+		{
+			VkFormat format;
+			VkExtent2D extent;
+			VkImageUsageFlags extraUsage = 0;	// usage implied by the declared accesses is added automatically
+		};
+
+		// State an imported image is in before the graph runs, or has to be left in afterwards. A final
+		// layout of VK_IMAGE_LAYOUT_UNDEFINED means the contents are not needed after the graph.
+		struct ImageState
+		{
+			VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+			VkPipelineStageFlags stageMask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+			VkAccessFlags accessMask = 0;
+		};
+
+		struct PassContext
+		{
+			VkCommandBuffer commandBuffer;
+			VkRenderPass renderPass;	// already begun; null for passes without attachments
+			VkFramebuffer framebuffer;
+			VkExtent2D extent;
+		};
+		using ExecuteFunction = std::function<void(const PassContext& context)>;
+
+		struct Statistics
+		{
+			uint32_t passCount = 0;
+			uint32_t culledPassCount = 0;
+			uint32_t barrierCount = 0;			// image barriers recorded per execution
+			uint32_t transientImageCount = 0;
+			uint32_t memoryBlockCount = 0;		// memory ranges shared by the transient images
+			VkDeviceSize transientBytes = 0;	// memory reserved for transient images
+			VkDeviceSize unaliasedBytes = 0;	// memory they would need without aliasing
+		};
+
+		class PassBuilder
+		{
+		private:
+			RenderGraph& graph;
+			PassHandle pass;
+
+		public:
+			PassBuilder(RenderGraph& graph, PassHandle pass);
+
+			PassBuilder& read(ResourceHandle resource, Access access);
+			PassBuilder& write(ResourceHandle resource, Access access);
+			PassBuilder& clearColor(ResourceHandle resource, VkClearColorValue value);
+			PassBuilder& clearDepth(ResourceHandle resource, VkClearDepthStencilValue value);
+			PassBuilder& setSubpassContents(VkSubpassContents contents);
+			PassBuilder& setSideEffects();		// never culled, e.g. when writing buffers the graph does not track
+		};
+
+	private:
+		struct ResourceAccess
+		{
+			ResourceHandle resource;
+			Access access;
+			bool clear = false;				// attachment contents are cleared instead of loaded
+			VkClearValue clearValue{};
+		};
+
+		struct Barrier
+		{
+			ResourceHandle resource;
+			VkImageLayout oldLayout;
+			VkImageLayout newLayout;
+			VkAccessFlags srcAccessMask;
+			VkAccessFlags dstAccessMask;
+		};
+
+		struct BarrierBatch
+		{
+			std::vector<Barrier> barriers;
+			VkPipelineStageFlags srcStageMask = 0;
+			VkPipelineStageFlags dstStageMask = 0;
+		};
+
+		struct Pass
+		{
+			std::string name;
+			std::vector<ResourceAccess> accesses;
+			ExecuteFunction execute;
+			VkSubpassContents subpassContents = VK_SUBPASS_CONTENTS_INLINE;
+			bool hasSideEffects = false;
+
+			// filled in by compile
+			bool culled = false;
+			BarrierBatch barriers;		// recorded before the pass
+			VkRenderPass renderPass = VK_NULL_HANDLE;
+			std::vector<ResourceHandle> attachments;
+			std::vector<VkClearValue> clearValues;
+			VkExtent2D extent{};
+			std::map<std::vector<VkImageView>, VkFramebuffer> framebuffers;	// imported views may change
+		};
+
+		struct Resource
+		{
+			std::string name;
+			ImageDesc desc;
+			bool imported = false;
+			ImageState initialState;	// imported only
+			ImageState finalState;
+			VkImage image = VK_NULL_HANDLE;
+			VkImageView view = VK_NULL_HANDLE;
+			VkImageUsageFlags usage = 0;
+
+			// transient only, indices into the execution order
+			uint32_t firstUse = UINT32_MAX;
+			uint32_t lastUse = 0;
+			int memoryBlock = -1;
+		};
+
+		struct MemoryBlock
+		{
+			VkMemoryRequirements requirements{};
+			std::vector<ResourceHandle> resources;
+			MemoryAllocator::Allocation allocation{};
+		};
+
+		DeviceManager& devManager;
+		std::vector<Resource> resources;
+		std::vector<Pass> passes;
+		std::vector<PassHandle> executionOrder;		// passes that survived culling
+		std::vector<MemoryBlock> memoryBlocks;
+		BarrierBatch finalBarriers;					// leave imported images in their final state
+		bool compiled = false;
+		Statistics statistics{};
+
+	public:
+		RenderGraph(DeviceManager& devManager);
+		~RenderGraph();
+
+		RenderGraph(const RenderGraph&) = delete;
+		RenderGraph& operator=(const RenderGraph&) = delete;
+
+		ResourceHandle createImage(const std::string& name, const ImageDesc& desc);
+		ResourceHandle importImage(
+			const std::string& name,
+			const ImageDesc& desc,
+			const ImageState& initialState,
+			const ImageState& finalState
+		);
+		void setImportedImage(ResourceHandle resource, VkImage image, VkImageView view);
+
+		PassHandle addPass(
+			const std::string& name,
+			const std::function<void(PassBuilder& builder)>& setup,
+			ExecuteFunction execute
+		);
+
+		void compile();
+		void execute(VkCommandBuffer commandBuffer);
+
+		VkRenderPass getRenderPass(PassHandle pass) const;
+		VkImageView getImageView(ResourceHandle resource) const;
+		Statistics getStatistics() const;
+
+	private:
+		void cullPasses();
+		void computeBarriers();
+		void allocateTransientImages();
+		void createRenderPasses();
+		VkFramebuffer getFramebuffer(Pass& pass);
+		void recordBarriers(VkCommandBuffer commandBuffer, const BarrierBatch& batch) const;
+
+		static ImageState getAccessState(Access access);
+		static bool isWriteAccess(Access access);
+		static bool isAttachmentAccess(Access access);
+		static VkImageUsageFlags getUsage(Access access);
+		static VkImageAspectFlags getAspectMask(VkFormat format);
+	};
+
+}
\ No newline at end of file
@@ -1,11 +1,16 @@
 #pragma once
 
 #include "GfxPipeline.h"
+#include "DeferredDeletionQueue.h"
 #include "DeviceManager.h"
 #include "FrameInfo.h"
+#include "PipelineCompiler.h"
+#include "ThreadPool.h"
 
+#include <future>
 #include <string>
 #include <memory>
+#include <vector>
 
 namespace Vulkan3DEngine
 {
@@ -13,9 +18,17 @@ namespace Vulkan3DEngine
 	{
 	protected:
 		DeviceManager& devManager;
-		std::unique_ptr<GfxPipeline> gfxPipeline;
+		std::shared_ptr<GfxPipeline> gfxPipeline;	// may be shared with other systems, see PipelineStateCache
 		VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
 
+	private:
+		VkRenderPass renderPass = VK_NULL_HANDLE;
+		std::string vertexShaderPath;
+		std::string fragmentShaderPath;
+
+		// shader reloads build the new pipeline on a worker and swap it in at the next frame boundary
+		std::future<std::shared_ptr<GfxPipeline>> pendingPipeline;
+
 	public:
 		~RenderSystem();
 
@@ -25,6 +38,9 @@ namespace Vulkan3DEngine
 		virtual void render(FrameData& frameData) = 0;
 		virtual void update(FrameData& frameData, GlobalUbo& ubo) = 0;
 
+		bool reloadShaders(const std::vector<std::string>& changedShaders, ThreadPool& threadPool);
+		void nextFrame(DeferredDeletionQueue& deletionQueue);
+
 	protected:
 		RenderSystem(DeviceManager& devManager);
 
@@ -32,16 +48,17 @@ namespace Vulkan3DEngine
 			VkRenderPass renderPass, 
 			VkDescriptorSetLayout globalSetLayout,
 			const std::string& vertexShaderPath,
-			const std::string& fragmentShaderPath
+			const std::string& fragmentShaderPath,
+			PipelineCompiler* pipelineCompiler = nullptr
 		);
 
 		virtual void createPipelineLayout(VkDescriptorSetLayout globalSetLayout) = 0;
 
-		virtual void createPipeline(
-			VkRenderPass renderPass, 
-			const std::string& vertexShaderPath, 
-			const std::string& fragmentShaderPath
-		) = 0;
+		// Fills in everything but the render pass and pipeline layout, may be called from any thread
+		virtual void configurePipeline(PipelineConfigInfo& pipelineConfig) = 0;
+
+	private:
+		std::unique_ptr<PipelineConfigInfo> createPipelineConfig();
 	};
 
 }
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace Vulkan3DEngine
+{
+
+	// What the renderer draws into: the window's swap chain, or offscreen images when running headless.
+	// Each frame acquires one of the target's images and submits the frame's command buffer for it.
+	class RenderTarget
+	{
+	public:
+		virtual ~RenderTarget() = default;
+
+		// a render pass compatible with the frame graph's, which pipelines are built against
+		virtual VkRenderPass getRenderPass() = 0;
+		virtual VkImage getImage(int index) = 0;
+		virtual VkImageView getImageView(int index) = 0;
+		// depth is only needed while a frame renders, so there is one depth image per frame in flight rather
+		// than per color image; the frame graph pairs it with whichever color image was acquired
+		virtual VkImage getDepthImage(int frameIndex) = 0;
+		virtual VkImageView getDepthImageView(int frameIndex) = 0;
+		virtual size_t getImageCount() = 0;
+		virtual VkFormat getSwapChainImageFormat() = 0;
+		virtual VkFormat getSwapChainDepthFormat() = 0;
+		virtual VkExtent2D getSwapChainExtent() = 0;
+		virtual float extentAspectRatio() = 0;
+
+		// layout the color image has to be left in at the end of the frame
+		virtual VkImageLayout getOutputLayout() = 0;
+		// color images can be copied out with transfers, e.g. to export the rendered frames
+		virtual bool supportsReadback() = 0;
+
+		virtual VkResult acquireNextImage(uint32_t* imageIndex) = 0;
+		// uploadSemaphores are waited for before vertex input, see UploadBatcher::takeCompletedSemaphores
+		virtual VkResult submitCommandBuffers(
+			const VkCommandBuffer* buffers,
+			uint32_t* imageIndex,
+			const std::vector<VkSemaphore>& uploadSemaphores
+		) = 0;
+	};
+
+}
\ No newline at end of file
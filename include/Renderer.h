@@ -1,9 +1,12 @@
 #pragma once
 
 #include "WindowManager.h"
+#include "DeferredDeletionQueue.h"
 #include "DeviceManager.h"
+#include "OffscreenTarget.h"
 #include "SwapChainManager.h"
 
+#include <chrono>
 #include <memory>
 #include <vector>
 
@@ -12,20 +15,41 @@ namespace Vulkan3DEngine
 
 	class Renderer
 	{
+	public:
+		// accumulated over all frames to tell how well CPU recording and GPU execution overlap
+		struct FrameStatistics
+		{
+			uint64_t frameCount = 0;
+			double wallSeconds = 0.0;
+			double waitSeconds = 0.0;		// CPU blocked on a frame in flight or on the swap chain
+			double gpuSeconds = 0.0;		// command buffer execution, measured with timestamps
+			uint64_t gpuFrameCount = 0;		// frames with timestamp results
+		};
+
 	private:
 		WindowManager& winManager;
 		DeviceManager& devManager;
+		int framesInFlight;
+		DeferredDeletionQueue deletionQueue;	// advanced every frame, also holds replaced swap chains
 
 		std::unique_ptr<SwapChainManager> swapManager;
+		std::unique_ptr<OffscreenTarget> offscreenTarget;	// replaces the swap chain when headless
+		RenderTarget* renderTarget = nullptr;				// whichever of the two is in use
 
 		std::vector<VkCommandBuffer> commandBuffers;
 
+		VkQueryPool timestampQueryPool = VK_NULL_HANDLE;	// two per frame in flight, null without timestamp support
+		std::vector<bool> timestampsPending;
+		std::chrono::steady_clock::time_point firstFrameStart{};
+		FrameStatistics frameStatistics{};
+
 		uint32_t currentImageIndex = 0;
 		int currentFrameIndex = 0;
 		bool isFrameStarted = false;
+		uint32_t swapChainGeneration = 0;	// incremented whenever the swap chain is recreated
 
 	public:
-		Renderer(WindowManager& winManager, DeviceManager& devManager);
+		Renderer(WindowManager& winManager, DeviceManager& devManager, int framesInFlight);
 		~Renderer();
 
 		Renderer(const Renderer&) = delete;
@@ -36,18 +60,34 @@ namespace Vulkan3DEngine
 		bool isFrameInProgress() const;
 
 		int getCurrentFrameIndex() const;
+		int getFramesInFlight() const;
+		DeferredDeletionQueue& getDeletionQueue();
+		FrameStatistics getFrameStatistics() const;
 
 		VkCommandBuffer getCurrentCommandBuffer() const;
 
-		void beginSwapChainRenderPass(VkCommandBuffer cmdBuffer);
-		void endSwapChainRenderPass(VkCommandBuffer cmdBuffer);
+		// only for pipeline compatibility, the frame graph creates the render passes it records
 		VkRenderPass getSwapChainRenderPass() const;
+		VkExtent2D getSwapChainExtent() const;
+		VkFormat getSwapChainImageFormat() const;
+		VkFormat getSwapChainDepthFormat() const;
+		VkImageLayout getOutputLayout() const;	// layout the color image is left in for presenting or readback
+		bool supportsReadback() const;
+		uint32_t getSwapChainGeneration() const;
+
+		// the images rendered to this frame, for passes that manage the attachments themselves
+		VkImage getCurrentImage() const;
+		VkImageView getCurrentImageView() const;
+		VkImage getCurrentDepthImage() const;
+		VkImageView getCurrentDepthImageView() const;
 
 		float getAspectRatio() const;
 
 	private:
 		void createCommandBuffers();
 		void destroyCommandBuffers();
+		void createTimestampQueryPool();
+		void readTimestamps();
 		void recreateSwapChain();
 	};
 
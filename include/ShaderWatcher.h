@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace Vulkan3DEngine
+{
+
+	// Watches a directory of GLSL sources and recompiles changed shaders with glslc on a background
+	// thread. Uses inotify on Linux and polls modification times elsewhere. Successfully compiled
+	// SPIR-V replaces the old file atomically; the render loop picks up the paths through
+	// takeCompiledShaders and rebuilds the affected pipelines, see RenderSystem::reloadShaders.
+	class ShaderWatcher
+	{
+	private:
+		std::string sourceDirectory;
+		std::string outputDirectory;
+		std::string compilerPath;
+
+		std::mutex mutex;
+		std::vector<std::string> compiledShaders;	// output paths, in the form the render systems load them
+
+		std::atomic<bool> running{ true };
+		std::thread thread;
+
+#ifdef __linux__
+		int inotifyFd = -1;
+#else
+		std::unordered_map<std::string, std::filesystem::file_time_type> writeTimes;
+#endif
+
+	public:
+		ShaderWatcher(
+			const std::string& sourceDirectory,
+			const std::string& outputDirectory = "shaders",
+			const std::string& compilerPath = "glslc"
+		);
+		~ShaderWatcher();
+
+		ShaderWatcher(const ShaderWatcher&) = delete;
+		ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+		std::vector<std::string> takeCompiledShaders();
+
+	private:
+		void watch();
+		std::vector<std::string> waitForChanges();
+		void compile(const std::string& fileName);
+
+		// simple.frag -> simple_frag.spv, matching the CMake shader step; empty for other files
+		static std::string getOutputName(const std::string& fileName);
+	};
+
+}
\ No newline at end of file
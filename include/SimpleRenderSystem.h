@@ -1,9 +1,15 @@
 #pragma once
 
 #include "RenderSystem.h"
+#include "BindlessResources.h"
+#include "Descriptors.h"
+#include "FrameAllocator.h"
+
+#include <vector>
 
 namespace Vulkan3DEngine
 {
+	struct SimpleDrawItem;
 
 	class SimpleRenderSystem : public RenderSystem
 	{
@@ -12,8 +18,12 @@ namespace Vulkan3DEngine
 			DeviceManager& devManager,
 			VkRenderPass renderPass,
 			VkDescriptorSetLayout globalSetLayout,
+			FrameAllocator& frameAllocator,
+			BindlessResources* bindlessResources = nullptr,
+			PipelineCompiler* pipelineCompiler = nullptr,
 			const std::string& vertexShaderPath = "shaders/simple_vert.spv",
-			const std::string& fragmentShaderPath = "shaders/simple_frag.spv"
+			const std::string& fragmentShaderPath = "shaders/simple_frag.spv",
+			const std::string& bindlessVertexShaderPath = "shaders/simple_bindless_vert.spv"
 		);
 
 		~SimpleRenderSystem();
@@ -25,15 +35,23 @@ namespace Vulkan3DEngine
 		void update(FrameData& frameData, GlobalUbo& ubo) override;
 
 	private:
-		SimpleRenderSystem(DeviceManager& devManager);
+		// per draw data lives in the frame allocator, bound at set 1 through a dynamic offset
+		std::unique_ptr<DescriptorSetLayoutManager> drawSetLayoutManager;
+		std::unique_ptr<DescriptorPoolManager> drawPoolManager;
+		std::vector<VkDescriptorSet> drawDescriptorSets;	// one per frame in flight
+
+		// with bindless resources all draws of a frame are packed into one array, read through the frame's
+		// storage buffer slot and indexed by gl_InstanceIndex, so nothing is rebound between draws
+		BindlessResources* bindlessResources;
+		std::vector<uint32_t> drawBufferSlots;	// one per frame in flight
+
+		SimpleRenderSystem(DeviceManager& devManager, FrameAllocator& frameAllocator, BindlessResources* bindlessResources);
+
+		void renderBindless(FrameData& frameData, const std::vector<SimpleDrawItem>& draws);
 
 		void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
 
-		void createPipeline(
-			VkRenderPass renderPass,
-			const std::string& vertexShaderPath,
-			const std::string& fragmentShaderPath
-		);
+		void configurePipeline(PipelineConfigInfo& pipelineConfig);
 		
 	};
 
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "MemoryAllocator.h"
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Vulkan3DEngine
+{
+
+	class DeviceManager;
+	class BufferManager;
+
+	// Persistently mapped host visible ring buffer for uploads. Regions handed out since the last commit
+	// are recycled once the fence returned by commit has signalled.
+	class StagingRing
+	{
+	public:
+		static constexpr VkDeviceSize DEFAULT_CAPACITY = 32ull * 1024 * 1024;
+
+		struct Region
+		{
+			VkBuffer buffer = VK_NULL_HANDLE;
+			VkDeviceSize offset = 0;
+			VkDeviceSize size = 0;
+			void* mapped = nullptr;
+		};
+
+		struct Submission
+		{
+			VkFence fence = VK_NULL_HANDLE;		// must be signalled by the submission consuming the regions
+			uint64_t serial = 0;
+		};
+
+	private:
+		struct Batch
+		{
+			VkFence fence;
+			uint64_t serial;
+			VkDeviceSize bytes;
+			std::vector<std::unique_ptr<BufferManager>> overflowBuffers;
+		};
+
+		DeviceManager& deviceManager;
+
+		VkBuffer buffer = VK_NULL_HANDLE;
+		MemoryAllocator::Allocation allocation;
+		VkDeviceSize capacity;
+
+		mutable std::mutex mutex;
+		VkDeviceSize head = 0;
+		VkDeviceSize usedBytes = 0;		// bytes held by pending and in flight regions, including wrap padding
+		VkDeviceSize pendingBytes = 0;	// bytes handed out since the last commit
+		std::vector<std::unique_ptr<BufferManager>> pendingOverflowBuffers;
+
+		std::deque<Batch> inFlight;
+		std::vector<VkFence> freeFences;
+		uint64_t nextSerial = 1;
+		uint64_t completedSerial = 0;
+
+	public:
+		StagingRing(DeviceManager& deviceManager, VkDeviceSize capacity = DEFAULT_CAPACITY);
+		~StagingRing();
+
+		StagingRing(const StagingRing&) = delete;
+		StagingRing& operator=(const StagingRing&) = delete;
+
+		Region allocate(VkDeviceSize size, VkDeviceSize alignment = 16);
+		Submission commit();
+
+		bool isComplete(uint64_t serial);
+		void wait(uint64_t serial);
+
+		VkDeviceSize getCapacity() const;
+		VkDeviceSize getUsedBytes() const;
+
+	private:
+		Region allocateOverflow(VkDeviceSize size);
+		void reclaim();
+		void waitOldest();
+		VkFence acquireFence();
+	};
+
+}
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "DeviceManager.h"
+#include "RenderTarget.h"
 
 #include <string>
 #include <vector>
@@ -9,24 +10,25 @@
 namespace Vulkan3DEngine
 {
 
-	class SwapChainManager
+	class SwapChainManager : public RenderTarget
 	{
 	private:
 		VkFormat swapChainImageFormat;
 		VkFormat swapChainDepthFormat;
+		bool transferSource = false;	// images were created with TRANSFER_SRC usage
 		VkExtent2D swapChainExtent;
 
-		std::vector<VkFramebuffer> swapChainFramebuffers;
 		VkRenderPass renderPass;
 
 		std::vector<VkImage> depthImages;
-		std::vector<VkDeviceMemory> depthImageMemorys;
+		std::vector<MemoryAllocator::Allocation> depthImageAllocations;
 		std::vector<VkImageView> depthImageViews;
 		std::vector<VkImage> swapChainImages;
 		std::vector<VkImageView> swapChainImageViews;
 
 		DeviceManager& deviceManager;
 		VkExtent2D windowExtent;
+		int framesInFlight;
 
 		VkSwapchainKHR swapChain;
 
@@ -39,10 +41,11 @@ namespace Vulkan3DEngine
 		size_t currentFrame = 0;
 
 	public:
-		SwapChainManager(DeviceManager& deviceManager, VkExtent2D windowExtent);
+		SwapChainManager(DeviceManager& deviceManager, VkExtent2D windowExtent, int framesInFlight);
 		SwapChainManager(
 			DeviceManager& deviceManager, 
 			VkExtent2D windowExtent, 
+			int framesInFlight,
 			std::shared_ptr<SwapChainManager> oldSwapChainManager
 		);
 		~SwapChainManager();
@@ -50,20 +53,29 @@ namespace Vulkan3DEngine
 		SwapChainManager(const SwapChainManager&) = delete;
 		void operator=(const SwapChainManager&) = delete;
 
-		VkFramebuffer getFrameBuffer(int index);
-		VkRenderPass getRenderPass();
-		VkImageView getImageView(int index);
-		size_t getImageCount();
-		VkFormat getSwapChainImageFormat();
-		VkExtent2D getSwapChainExtent();
+		VkRenderPass getRenderPass() override;
+		VkImageView getImageView(int index) override;
+		VkImage getImage(int index) override;
+		VkImage getDepthImage(int frameIndex) override;
+		VkImageView getDepthImageView(int frameIndex) override;
+		size_t getImageCount() override;
+		VkFormat getSwapChainImageFormat() override;
+		VkFormat getSwapChainDepthFormat() override;
+		VkExtent2D getSwapChainExtent() override;
 		uint32_t width();
 		uint32_t height();
 
-		float extentAspectRatio();
+		float extentAspectRatio() override;
+		VkImageLayout getOutputLayout() override;
+		bool supportsReadback() override;
 		VkFormat findDepthFormat();
 
-		VkResult acquireNextImage(uint32_t* imageIndex);
-		VkResult submitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex);
+		VkResult acquireNextImage(uint32_t* imageIndex) override;
+		VkResult submitCommandBuffers(
+			const VkCommandBuffer* buffers,
+			uint32_t* imageIndex,
+			const std::vector<VkSemaphore>& uploadSemaphores
+		) override;
 
 		bool areSwapChainFormatsEqual(const SwapChainManager& swapChainManager) const;
 
@@ -73,7 +85,6 @@ namespace Vulkan3DEngine
 		void createImageViews();
 		void createDepthResources();
 		void createRenderPass();
-		void createFramebuffers();
 		void createSyncObjects();
 
 		VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
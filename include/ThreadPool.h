@@ -0,0 +1,58 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace Vulkan3DEngine
+{
+
+	// Fixed set of worker threads running submitted tasks in FIFO order. Queued tasks still run when the
+	// pool is destroyed; the destructor returns once all of them have finished.
+	class ThreadPool
+	{
+	private:
+		std::vector<std::thread> workers;
+		std::queue<std::function<void()>> tasks;
+		std::mutex mutex;
+		std::condition_variable condition;
+		bool stopping = false;
+
+	public:
+		explicit ThreadPool(uint32_t threadCount = getDefaultThreadCount());
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		template<typename F>
+		auto submit(F&& task) -> std::future<std::invoke_result_t<F>>
+		{
+			using Result = std::invoke_result_t<F>;
+			auto packagedTask = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+			std::future<Result> result = packagedTask->get_future();
+			{
+				std::lock_guard<std::mutex> lock{ mutex };
+				tasks.emplace([packagedTask]() { (*packagedTask)(); });
+			}
+			condition.notify_one();
+			return result;
+		}
+
+		uint32_t getThreadCount() const;
+
+		// One thread per hardware thread, leaving one for the main thread
+		static uint32_t getDefaultThreadCount();
+
+	private:
+		void workerLoop();
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "StagingRing.h"
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace Vulkan3DEngine
+{
+
+	class DeviceManager;
+
+	// Collects buffer copies and submits them together in one command buffer, on the dedicated transfer
+	// queue when the device has one. Completion is tracked per batch through the staging ring fences.
+	// The fence only tells the host that a batch is done; its writes become visible to the graphics
+	// queue through a semaphore each batch signals, which the next frame submitted after the batch was
+	// seen complete waits for, see takeCompletedSemaphores.
+	class UploadBatcher
+	{
+	public:
+		using Ticket = uint64_t;
+
+		// Queued staging data above capacity / AUTO_FLUSH_DIVISOR submits the batch early
+		static constexpr VkDeviceSize AUTO_FLUSH_DIVISOR = 2;
+
+	private:
+		struct PendingCopy
+		{
+			VkBuffer src;
+			VkBuffer dst;
+			VkBufferCopy region;
+		};
+
+		struct Submission
+		{
+			Ticket ticket;
+			uint64_t stagingSerial;
+			VkCommandBuffer commandBuffer;
+			VkSemaphore semaphore;
+		};
+
+		DeviceManager& deviceManager;
+		StagingRing& stagingRing;
+		VkQueue queue;
+		VkCommandPool commandPool = VK_NULL_HANDLE;
+
+		std::mutex mutex;
+		std::vector<PendingCopy> pendingCopies;
+		VkDeviceSize pendingStagingBytes = 0;
+		std::deque<Submission> submitted;
+		Ticket nextTicket = 1;
+		Ticket completedTicket = 0;
+
+		std::vector<VkSemaphore> semaphores;			// all created, destroyed with the batcher
+		std::vector<VkSemaphore> freeSemaphores;
+		std::vector<VkSemaphore> completedSemaphores;	// signaled by completed batches, not waited for yet
+
+	public:
+		UploadBatcher(DeviceManager& deviceManager, StagingRing& stagingRing, VkQueue queue, uint32_t queueFamilyIndex);
+		~UploadBatcher();
+
+		UploadBatcher(const UploadBatcher&) = delete;
+		UploadBatcher& operator=(const UploadBatcher&) = delete;
+
+		StagingRing::Region allocateStaging(VkDeviceSize size, VkDeviceSize alignment = 16);
+		Ticket copyBuffer(VkBuffer src, VkBuffer dst, VkDeviceSize size, VkDeviceSize srcOffset = 0, VkDeviceSize dstOffset = 0);
+		Ticket flush();
+
+		bool isComplete(Ticket ticket);
+		void wait(Ticket ticket);
+
+		std::vector<VkSemaphore> takeCompletedSemaphores();
+		void recycleSemaphores(const std::vector<VkSemaphore>& waitedSemaphores);
+
+	private:
+		Ticket submitPending();
+		VkSemaphore acquireSemaphore();
+		void retireCompleted();
+	};
+
+}
\ No newline at end of file
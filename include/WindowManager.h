@@ -14,21 +14,25 @@ namespace Vulkan3DEngine
 		int width;
 		int height;
 		bool windowResized = false;
+		bool headless;
 
 		std::string windowTitle;
 
-		GLFWwindow* window;
+		GLFWwindow* window = nullptr;
 
 	public:
-		WindowManager(int width, int height, std::string windowTitle);
+		// a headless manager opens no window and does not initialize GLFW, it only provides the extent
+		WindowManager(int width, int height, std::string windowTitle, bool headless = false);
 		~WindowManager();
 
 		WindowManager(const WindowManager&) = delete;
 		WindowManager& operator=(const WindowManager&) = delete;
 
 		GLFWwindow* getWindow() const;
+		bool isHeadless() const;
 
 		bool windowShouldClose() const;
+		void pollEvents();
 		
 		bool windowWasResized() const;
 		void resetWindowResizedFlag();
@@ -1,6 +1,11 @@
 #version 450
 
-#define MAX_LIGHTS 10
+#define MAX_LIGHTS 10	// size of the light array in GlobalUbo, must match AppConstants::MAX_LIGHTS
+
+// set per pipeline by SimpleRenderSystem, constant loop bounds and branches let the driver unroll and strip code
+layout(constant_id = 0) const int LIGHT_COUNT = MAX_LIGHTS;	// at most MAX_LIGHTS
+layout(constant_id = 1) const float SPECULAR_EXPONENT = 512.0;	// higher value = sharper highlights
+layout(constant_id = 2) const bool ENABLE_SPECULAR = true;
 
 layout(location = 0) in vec3 fragColor;
 layout(location = 1) in vec3 fragPosWorld;
@@ -22,11 +27,6 @@ layout(set = 0, binding = 0) uniform GlobalUbo {
 	int numLights;
 } ubo;
 
-layout(push_constant) uniform Push {
-	mat4 modelMatrix;
-	mat4 normalMatrix;
-} push;
-
 void main() {
 	vec3 diffuseLight = ubo.ambientLightColor.xyz * ubo.ambientLightColor.w;
 	vec3 specularLight = vec3(0.0);
@@ -35,7 +35,10 @@ void main() {
 	vec3 cameraPosWorld = ubo.invViewMatrix[3].xyz;
 	vec3 viewDirection = normalize(cameraPosWorld - fragPosWorld);
 
-	for (int i = 0; i < ubo.numLights; ++i) {
+	for (int i = 0; i < LIGHT_COUNT; ++i) {
+		if (i >= ubo.numLights) {
+			break;
+		}
 		PointLight light = ubo.pointLights[i];
 		vec3 directionToLight = light.position.xyz - fragPosWorld;
 		float attenuation = 1.0 / dot(directionToLight, directionToLight); // distance^2
@@ -47,11 +50,13 @@ void main() {
 		diffuseLight += intensity * cosIncidenceAngle;
 
 		// specular lighting
-		vec3 halfAngle = normalize(directionToLight + viewDirection);
-		float blinnTerm = dot(surfaceNormal, halfAngle);
-		blinnTerm = clamp(blinnTerm, 0, 1);
-		blinnTerm = pow(blinnTerm, 512.0); // higher value = sharper highlights
-		specularLight += intensity * blinnTerm;
+		if (ENABLE_SPECULAR) {
+			vec3 halfAngle = normalize(directionToLight + viewDirection);
+			float blinnTerm = dot(surfaceNormal, halfAngle);
+			blinnTerm = clamp(blinnTerm, 0, 1);
+			blinnTerm = pow(blinnTerm, SPECULAR_EXPONENT);
+			specularLight += intensity * blinnTerm;
+		}
 	}
 
 	outColor = vec4(diffuseLight * fragColor + specularLight * fragColor, 1.0);
@@ -25,16 +25,16 @@ layout(set = 0, binding = 0) uniform GlobalUbo {
 	int numLights;
 } ubo;
 
-layout(push_constant) uniform Push {
+layout(set = 1, binding = 0) uniform DrawUbo {
 	mat4 modelMatrix;
 	mat4 normalMatrix;
-} push;
+} draw;
 
 void main() {
-	vec4 positionWorld = push.modelMatrix * vec4(position, 1.0);
+	vec4 positionWorld = draw.modelMatrix * vec4(position, 1.0);
 	gl_Position = ubo.projectionMatrix * (ubo.viewMatrix * positionWorld);
 
 	fragPosWorld = positionWorld.xyz;
-	fragNormalWorld = normalize(mat3(push.normalMatrix) * normal);
+	fragNormalWorld = normalize(mat3(draw.normalMatrix) * normal);
 	fragColor = color;
 }
\ No newline at end of file
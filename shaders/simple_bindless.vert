@@ -0,0 +1,52 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+#define MAX_LIGHTS 10
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 color;
+layout(location = 2) in vec3 normal;
+layout(location = 3) in vec2 texCoords;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec3 fragPosWorld;
+layout(location = 2) out vec3 fragNormalWorld;
+
+struct PointLight {
+	vec4 position;
+	vec4 color;
+};
+
+layout(set = 0, binding = 0) uniform GlobalUbo {
+	mat4 projectionMatrix;
+	mat4 viewMatrix;
+	mat4 invViewMatrix;
+	vec4 ambientLightColor;
+	PointLight pointLights[MAX_LIGHTS];
+	int numLights;
+} ubo;
+
+struct DrawData {
+	mat4 modelMatrix;
+	mat4 normalMatrix;
+};
+
+// bindless storage buffer array; the draw's entry is selected by firstInstance
+layout(set = 1, binding = 0) readonly buffer DrawDataBuffer {
+	DrawData draws[];
+} drawBuffers[];
+
+layout(push_constant) uniform Push {
+	uint drawBufferIndex;
+} push;
+
+void main() {
+	DrawData draw = drawBuffers[push.drawBufferIndex].draws[gl_InstanceIndex];
+
+	vec4 positionWorld = draw.modelMatrix * vec4(position, 1.0);
+	gl_Position = ubo.projectionMatrix * (ubo.viewMatrix * positionWorld);
+
+	fragPosWorld = positionWorld.xyz;
+	fragNormalWorld = normalize(mat3(draw.normalMatrix) * normal);
+	fragColor = color;
+}
\ No newline at end of file
@@ -6,6 +6,8 @@
 #include "Camera.h"
 #include "CameraMovementHandler.h"
 #include "BufferManager.h"
+#include "DescriptorBenchmark.h"
+#include "RenderGraph.h"
 #include "Entity.h"
 #include "EntityComponents.h"
 
@@ -16,63 +18,73 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <stdexcept>
+#include <algorithm>
 #include <array>
 #include <chrono>
+#include <filesystem>
+#include <iostream>
 #include <numeric>
 
 namespace Vulkan3DEngine
 {
-	AppController::AppController()
+	AppController::AppController(int framesInFlight, bool headless) : framesInFlight{ framesInFlight }, headless{ headless }
 	{
-		globalPoolManager = DescriptorPoolManager::Builder(devManager)
-			.setMaxSets(AppConstants::MAX_FRAMES_IN_FLIGHT)
-			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, AppConstants::MAX_FRAMES_IN_FLIGHT)
-			.build();
+		std::vector<DescriptorAllocator::PoolSizeRatio> frameRatios{
+			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1.f },
+			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.f },
+			{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1.f },
+			{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2.f }
+		};
+		for (int i = 0; i < framesInFlight; ++i) {
+			frameDescriptorAllocators.push_back(std::make_unique<DescriptorAllocator>(devManager, frameRatios));
+		}
+		descriptorSetCache = std::make_unique<DescriptorSetCache>(devManager, framesInFlight, frameRatios);
+		if (devManager.isDescriptorIndexingSupported()) {
+			bindlessResources = std::make_unique<BindlessResources>(devManager, renderer.getDeletionQueue());
+		}
+#ifdef SHADER_SOURCE_DIR
+		if (std::filesystem::is_directory(SHADER_SOURCE_DIR)) {
+			shaderWatcher = std::make_unique<ShaderWatcher>(SHADER_SOURCE_DIR, "shaders", GLSLC_PATH);
+		}
+#endif
 		loadEntities();
+		devManager.getUploadBatcher().flush();
 	}
 
 	AppController::~AppController()
 	{
-		globalPoolManager = nullptr;
+		shaderWatcher = nullptr;
+		bindlessResources = nullptr;
+		descriptorSetCache = nullptr;
+		frameDescriptorAllocators.clear();
 	}
 
-	void AppController::run()
+	void AppController::run(uint64_t frameLimit, const std::string& exportDirectory, FrameReadback::Format exportFormat)
 	{
-		std::vector<std::unique_ptr<BufferManager>> uboManagers(AppConstants::MAX_FRAMES_IN_FLIGHT);
-		for (int i = 0; i < uboManagers.size(); ++i) {
-			uboManagers[i] = std::make_unique<BufferManager>(
-				devManager,
-				sizeof(GlobalUbo),
-				1,
-				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
-			);
-			uboManagers[i]->map();
-		}
-
+		// the global UBO is written into the frame allocator each frame and bound at its dynamic offset
 		auto globalSetLayoutManager = DescriptorSetLayoutManager::Builder(devManager)
-			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_ALL_GRAPHICS)
 			.build();
 
-		std::vector<VkDescriptorSet> globalDescriptorSets(AppConstants::MAX_FRAMES_IN_FLIGHT);
-		for (int i = 0; i < globalDescriptorSets.size(); ++i) {
-			auto bufferInfo = uboManagers[i]->descriptorInfo();
-			DescriptorWriter(*globalSetLayoutManager, *globalPoolManager)
-				.writeBuffer(0, &bufferInfo)
-				.build(globalDescriptorSets[i]);
-		}
-
 		auto simpleRenderSystem = SimpleRenderSystem::create(
 			devManager, 
 			renderer.getSwapChainRenderPass(), 
-			globalSetLayoutManager->getDescriptorSetLayout()
+			globalSetLayoutManager->getDescriptorSetLayout(),
+			frameAllocator,
+			bindlessResources.get(),
+			&pipelineCompiler
 		);
 
 		auto pointLightRenderSystem = PointLightRenderSystem::create(
 			devManager,
 			renderer.getSwapChainRenderPass(),
-			globalSetLayoutManager->getDescriptorSetLayout()
+			globalSetLayoutManager->getDescriptorSetLayout(),
+			&pipelineCompiler
 		);
+
+		// the render systems above only described their pipelines, build them all concurrently
+		pipelineCompiler.compileAll();
+		RenderSystem* renderSystems[] = { simpleRenderSystem.get(), pointLightRenderSystem.get() };
 		
 		Camera camera{};
 		camera.setViewTarget(glm::vec3(-1.f, -2.f, 2.f), glm::vec3(0.f, 0.f, 2.5f));
@@ -88,10 +100,103 @@ namespace Vulkan3DEngine
 
 		CameraMovementHandler camMovementHandler{};
 
+		std::unique_ptr<FrameReadback> frameReadback{};
+		if (!exportDirectory.empty()) {
+			if (!renderer.supportsReadback() || !FrameReadback::isFormatSupported(renderer.getSwapChainImageFormat())) {
+				throw std::runtime_error("Failed to start frame export: the rendered images cannot be read back");
+			}
+			frameReadback = std::make_unique<FrameReadback>(devManager, threadPool, framesInFlight, exportDirectory, exportFormat);
+		}
+
+		// the frame graph imports the swap chain images, so it is rebuilt along with the swap chain. The
+		// replaced graph is kept until the frames in flight that recorded it have finished.
+		std::unique_ptr<RenderGraph> frameGraph{};
+		uint64_t frameCount = 0;
+		RenderGraph::ResourceHandle swapChainColor = 0;
+		RenderGraph::ResourceHandle swapChainDepth = 0;
+		uint32_t frameGraphGeneration = 0;
+		FrameData* currentFrameData = nullptr;
+
+		auto buildFrameGraph = [&]() {
+			if (frameGraph) {
+				renderer.getDeletionQueue().retire(std::shared_ptr<RenderGraph>(std::move(frameGraph)));
+			}
+			frameGraph = std::make_unique<RenderGraph>(devManager);
+			VkExtent2D extent = renderer.getSwapChainExtent();
+
+			// presented, or copied out when rendering offscreen
+			VkImageLayout outputLayout = renderer.getOutputLayout();
+			RenderGraph::ImageState outputState = outputLayout == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
+				? RenderGraph::ImageState{ outputLayout, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0 }
+				: RenderGraph::ImageState{ outputLayout, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT };
+
+			swapChainColor = frameGraph->importImage(
+				"swap chain color",
+				{ renderer.getSwapChainImageFormat(), extent },
+				{ VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0 },	// acquire semaphore wait
+				outputState
+			);
+			swapChainDepth = frameGraph->importImage(
+				"swap chain depth",
+				{ renderer.getSwapChainDepthFormat(), extent },
+				{
+					VK_IMAGE_LAYOUT_UNDEFINED,
+					VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+					VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT	// written by the previous frame using this image
+				},
+				{}	// not kept: the graph stores nothing, so lazily allocated depth memory is never committed
+			);
+
+			// the render pass is compatible with the swap chain's one the pipelines were built against
+			frameGraph->addPass(
+				"scene",
+				[&](RenderGraph::PassBuilder& builder) {
+					builder.clearColor(swapChainColor, { { 0.01f, 0.01f, 0.01f, 1.0f } })
+						.clearDepth(swapChainDepth, { 1.0f, 0 })
+						.setSubpassContents(VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+				},
+				[&](const RenderGraph::PassContext& context) {
+					FrameData& frameData = *currentFrameData;
+					commandRecorder.beginFrame(frameData.frameIndex, context.renderPass, context.framebuffer, context.extent);
+
+					// systems record into secondary command buffers, executed in order inside the pass
+					simpleRenderSystem->render(frameData);
+					pointLightRenderSystem->render(frameData);
+					commandRecorder.execute(context.commandBuffer);
+				}
+			);
+
+			// the graph moves the image to TRANSFER_SRC for the copy and on to its output layout afterwards
+			if (frameReadback) {
+				frameGraph->addPass(
+					"readback",
+					[&](RenderGraph::PassBuilder& builder) {
+						builder.read(swapChainColor, RenderGraph::Access::TransferRead)
+							.setSideEffects();
+					},
+					[&, extent](const RenderGraph::PassContext& context) {
+						frameReadback->record(
+							context.commandBuffer,
+							renderer.getCurrentImage(),
+							renderer.getSwapChainImageFormat(),
+							extent,
+							currentFrameData->frameIndex
+						);
+					}
+				);
+			}
+
+			frameGraph->compile();
+			frameGraphGeneration = renderer.getSwapChainGeneration();
+		};
+
 		auto time1 = std::chrono::high_resolution_clock::now();
 
-		while (!winManager.windowShouldClose()) {
-			glfwPollEvents();
+		while (!winManager.windowShouldClose() && (frameLimit == 0 || frameCount < frameLimit)) {
+			winManager.pollEvents();
+
+			// submit uploads queued since the last frame, e.g. by models loaded at runtime
+			devManager.getUploadBatcher().flush();
 
 			auto time2 = std::chrono::high_resolution_clock::now();
 			float frameTime = std::chrono::duration<float, std::chrono::seconds::period>(time2 - time1).count();
@@ -101,7 +206,9 @@ namespace Vulkan3DEngine
 			auto& viewerEntity = entities.at(viewerId);
 			auto* viewerTransform = viewerEntity.getComponent<TransformComponent>();
 			if (viewerTransform) {
-				camMovementHandler.moveInPlaneXZ(winManager.getWindow(), frameTime, *viewerTransform);
+				if (!winManager.isHeadless()) {
+					camMovementHandler.moveInPlaneXZ(winManager.getWindow(), frameTime, *viewerTransform);
+				}
 				camera.setViewYXZ(viewerTransform->translation, viewerTransform->rotation);
 			}
 
@@ -109,14 +216,40 @@ namespace Vulkan3DEngine
 			camera.setPerspectiveProjection(glm::radians(50.f), aspectRatio, 0.1f, 1000.0f);
 
 			if (auto cmdBuffer = renderer.beginFrame()) {
+				modelRegistry.enforceBudget();
+
+				// edited shaders are rebuilt in the background and their pipelines swapped in at a later frame
+				auto changedShaders = shaderWatcher ? shaderWatcher->takeCompiledShaders() : std::vector<std::string>{};
+				for (RenderSystem* renderSystem : renderSystems) {
+					renderSystem->reloadShaders(changedShaders, threadPool);
+					renderSystem->nextFrame(renderer.getDeletionQueue());
+				}
+
 				int frameIndex = renderer.getCurrentFrameIndex();
+				frameAllocator.beginFrame(frameIndex);
+				if (frameReadback) {
+					frameReadback->beginFrame(frameIndex);
+				}
+				frameDescriptorAllocators[frameIndex]->reset();
+				descriptorSetCache->beginFrame(frameIndex);
+
+				// only written the first time each frame index is seen, later frames hit the cache
+				auto globalBufferInfo = frameAllocator.descriptorInfo(frameIndex, sizeof(GlobalUbo));
+				DescriptorWriter globalWriter{ *globalSetLayoutManager };
+				globalWriter.writeBuffer(0, &globalBufferInfo);
+
 				FrameData frameData{
 					frameIndex,
 					frameTime,
 					cmdBuffer,
 					camera,
-					globalDescriptorSets[frameIndex],
-					entities
+					descriptorSetCache->get(globalWriter),
+					entities,
+					geometryArena,
+					frameAllocator,
+					*frameDescriptorAllocators[frameIndex],
+					0,
+					commandRecorder
 				};
 
 				// update
@@ -125,28 +258,92 @@ namespace Vulkan3DEngine
 				ubo.viewMatrix = camera.getViewMatrix();
 				ubo.invViewMatrix = camera.getInverseViewMatrix();
 				pointLightRenderSystem->update(frameData, ubo);
-				uboManagers[frameIndex]->writeToBuffer(&ubo);
-				uboManagers[frameIndex]->flush();
+				frameData.globalUboOffset = frameAllocator.push(ubo).offset;
 
 				// render
-				renderer.beginSwapChainRenderPass(cmdBuffer);
-				simpleRenderSystem->render(frameData);
-				pointLightRenderSystem->render(frameData);
-				renderer.endSwapChainRenderPass(cmdBuffer);
+				if (!frameGraph || frameGraphGeneration != renderer.getSwapChainGeneration()) {
+					buildFrameGraph();
+				}
+				frameGraph->setImportedImage(swapChainColor, renderer.getCurrentImage(), renderer.getCurrentImageView());
+				frameGraph->setImportedImage(swapChainDepth, renderer.getCurrentDepthImage(), renderer.getCurrentDepthImageView());
+				currentFrameData = &frameData;
+				frameGraph->execute(cmdBuffer);
+				if (frameAllocator.flush() != VK_SUCCESS) {
+					throw std::runtime_error("Failed to flush frame allocator");
+				}
 				renderer.endFrame();
+				++frameCount;
 			}
 
 			//vkDeviceWaitIdle(devManager.getDeviceHandle()); // fix for begin command buffer validation error on nvidia gpu
 		}
 		vkDeviceWaitIdle(devManager.getDeviceHandle());
+		if (frameReadback) {
+			frameReadback->finish();
+		}
+		devManager.printMemoryReport();
+
+		auto frameStats = renderer.getFrameStatistics();
+		if (frameStats.frameCount > 0) {
+			double frameMs = frameStats.wallSeconds * 1000.0 / frameStats.frameCount;
+			double waitMs = frameStats.waitSeconds * 1000.0 / frameStats.frameCount;
+			double cpuMs = frameMs - waitMs;
+			std::cout << framesInFlight << " frames in flight: " << frameMs << " ms per frame, CPU busy "
+				<< cpuMs << " ms, waiting " << waitMs << " ms";
+			if (frameStats.gpuFrameCount > 0) {
+				// share of the frame where both were busy, assuming each only idles while waiting for the other
+				double gpuMs = frameStats.gpuSeconds * 1000.0 / frameStats.gpuFrameCount;
+				double overlap = std::clamp((cpuMs + gpuMs - frameMs) / frameMs, 0.0, 1.0);
+				std::cout << ", GPU busy " << gpuMs << " ms, CPU/GPU overlap " << overlap * 100.0 << "%";
+			}
+			std::cout << std::endl;
+		}
+
+		for (size_t i = 0; i < frameDescriptorAllocators.size(); ++i) {
+			auto stats = frameDescriptorAllocators[i]->getStatistics();
+			std::cout << "Frame " << i << " descriptor sets: " << stats.totalAllocationCount << " allocated over "
+				<< stats.resetCount << " frames, " << stats.poolCount << " pools" << std::endl;
+		}
+		auto cacheStats = descriptorSetCache->getStatistics();
+		std::cout << "Descriptor set cache: " << cacheStats.hitCount << " hits, " << cacheStats.missCount << " misses, "
+			<< cacheStats.cachedSets << " sets cached" << std::endl;
+		if (bindlessResources) {
+			auto bindlessStats = bindlessResources->getStatistics();
+			std::cout << "Bindless slots: " << bindlessStats.used[0] << "/" << bindlessStats.capacity[0] << " storage buffers, "
+				<< bindlessStats.used[1] << "/" << bindlessStats.capacity[1] << " sampled images, "
+				<< bindlessStats.used[2] << "/" << bindlessStats.capacity[2] << " samplers" << std::endl;
+		}
+		auto moduleStats = devManager.getShaderModuleCache().getStatistics();
+		auto pipelineStats = devManager.getPipelineStateCache().getStatistics();
+		std::cout << "Shader modules: " << moduleStats.moduleCount << " created, " << moduleStats.hitCount << " reused; pipelines: "
+			<< pipelineStats.missCount << " compiled, " << pipelineStats.hitCount << " shared, "
+			<< pipelineStats.livePipelineCount << " alive" << std::endl;
+		if (frameGraph) {
+			auto graphStats = frameGraph->getStatistics();
+			std::cout << "Frame graph: " << graphStats.passCount - graphStats.culledPassCount << "/" << graphStats.passCount
+				<< " passes, " << graphStats.barrierCount << " barriers, " << graphStats.transientImageCount
+				<< " transient images in " << graphStats.memoryBlockCount << " blocks (" << graphStats.transientBytes
+				<< " of " << graphStats.unaliasedBytes << " bytes)" << std::endl;
+		}
+		if (frameReadback) {
+			auto exportStats = frameReadback->getStatistics();
+			std::cout << "Frame export: " << exportStats.writtenFrames << "/" << exportStats.capturedFrames << " frames written to "
+				<< exportDirectory << " (" << exportStats.writtenBytes << " bytes), " << exportStats.failedFrames << " failed, "
+				<< exportStats.stallCount << " stalls waiting for the encoder (" << exportStats.stallSeconds * 1000.0 << " ms)" << std::endl;
+		}
+	}
+
+	void AppController::benchmarkDescriptors()
+	{
+		DescriptorBenchmark::run(devManager, frameAllocator);
 	}
 
 	void AppController::loadEntities()
 	{
-		// simplified: load models once and create entities with Model+Transform components
-		std::shared_ptr<Model> smoothVase = Model::createModelFromFile(devManager, "resources/models/smooth_vase.obj");
-		std::shared_ptr<Model> flatVase = Model::createModelFromFile(devManager, "resources/models/flat_vase.obj");
-		std::shared_ptr<Model> quad = Model::createModelFromFile(devManager, "resources/models/quad.obj");
+		// models are shared through the registry, so repeated paths are only loaded once
+		std::shared_ptr<Model> smoothVase = modelRegistry.acquire("resources/models/smooth_vase.obj");
+		std::shared_ptr<Model> flatVase = modelRegistry.acquire("resources/models/flat_vase.obj");
+		std::shared_ptr<Model> quad = modelRegistry.acquire("resources/models/quad.obj");
 
 		// smooth vase entity
 		{
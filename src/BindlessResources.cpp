@@ -0,0 +1,233 @@
+#include "BindlessResources.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace Vulkan3DEngine
+{
+	BindlessResources::SlotAllocator::SlotAllocator(uint32_t capacity) : capacity{ capacity }
+	{
+	}
+
+	bool BindlessResources::SlotAllocator::allocate(uint32_t& slot)
+	{
+		if (!freeSlots.empty()) {
+			slot = freeSlots.back();
+			freeSlots.pop_back();
+			return true;
+		}
+		if (nextSlot == capacity) {
+			return false;
+		}
+		slot = nextSlot++;
+		return true;
+	}
+
+	void BindlessResources::SlotAllocator::free(uint32_t slot)
+	{
+		assert(slot < nextSlot && "Slot was never allocated");
+		freeSlots.push_back(slot);
+	}
+
+	uint32_t BindlessResources::SlotAllocator::getUsed() const
+	{
+		return nextSlot - static_cast<uint32_t>(freeSlots.size());
+	}
+
+	uint32_t BindlessResources::SlotAllocator::getCapacity() const
+	{
+		return capacity;
+	}
+
+	BindlessResources::BindlessResources(DeviceManager& devManager, DeferredDeletionQueue& deletionQueue)
+		: devManager{ devManager }, deletionQueue{ deletionQueue }
+	{
+		if (!devManager.isDescriptorIndexingSupported()) {
+			throw std::runtime_error("Bindless resources require descriptor indexing support");
+		}
+
+		// all arrays are visible to every stage, so each one counts against the per stage limits
+		const auto& limits = devManager.getDescriptorIndexingProperties();
+		uint32_t resourceLimit = limits.maxPerStageUpdateAfterBindResources / KIND_COUNT;
+		uint32_t storageBufferCount = std::min({
+			MAX_STORAGE_BUFFERS,
+			limits.maxPerStageDescriptorUpdateAfterBindStorageBuffers,
+			limits.maxDescriptorSetUpdateAfterBindStorageBuffers,
+			resourceLimit
+		});
+		uint32_t sampledImageCount = std::min({
+			MAX_SAMPLED_IMAGES,
+			limits.maxPerStageDescriptorUpdateAfterBindSampledImages,
+			limits.maxDescriptorSetUpdateAfterBindSampledImages,
+			resourceLimit
+		});
+		uint32_t samplerCount = std::min({
+			MAX_SAMPLERS,
+			limits.maxPerStageDescriptorUpdateAfterBindSamplers,
+			limits.maxDescriptorSetUpdateAfterBindSamplers,
+			resourceLimit
+		});
+
+		slots.emplace_back(storageBufferCount);
+		slots.emplace_back(sampledImageCount);
+		slots.emplace_back(samplerCount);
+
+		// slots are written while the set is bound by frames still in flight, and most stay empty
+		VkDescriptorBindingFlags bindingFlags =
+			VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+			VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT |
+			VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+
+		setLayoutManager = DescriptorSetLayoutManager::Builder(devManager)
+			.addBinding(STORAGE_BUFFER_BINDING, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_ALL, storageBufferCount, bindingFlags)
+			.addBinding(SAMPLED_IMAGE_BINDING, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_ALL, sampledImageCount, bindingFlags)
+			.addBinding(SAMPLER_BINDING, VK_DESCRIPTOR_TYPE_SAMPLER, VK_SHADER_STAGE_ALL, samplerCount, bindingFlags)
+			.setLayoutFlags(VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT)
+			.build();
+
+		poolManager = DescriptorPoolManager::Builder(devManager)
+			.setMaxSets(1)
+			.setPoolFlags(VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, storageBufferCount)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, sampledImageCount)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_SAMPLER, samplerCount)
+			.build();
+
+		if (!poolManager->allocateDescriptorSet(setLayoutManager->getDescriptorSetLayout(), descriptorSet)) {
+			throw std::runtime_error("Failed to allocate bindless descriptor set");
+		}
+	}
+
+	BindlessResources::~BindlessResources()
+	{
+	}
+
+	/**
+	 * Writes a storage buffer into a free slot of the buffer array
+	 *
+	 * @return Index to address the buffer with from shaders
+	 */
+	uint32_t BindlessResources::registerStorageBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+	{
+		uint32_t slot = allocateSlot(Kind::StorageBuffer);
+		VkDescriptorBufferInfo bufferInfo{ buffer, offset, range };
+		writeDescriptor(Kind::StorageBuffer, slot, &bufferInfo, nullptr);
+		return slot;
+	}
+
+	uint32_t BindlessResources::registerSampledImage(VkImageView imageView, VkImageLayout imageLayout)
+	{
+		uint32_t slot = allocateSlot(Kind::SampledImage);
+		VkDescriptorImageInfo imageInfo{ VK_NULL_HANDLE, imageView, imageLayout };
+		writeDescriptor(Kind::SampledImage, slot, nullptr, &imageInfo);
+		return slot;
+	}
+
+	uint32_t BindlessResources::registerSampler(VkSampler sampler)
+	{
+		uint32_t slot = allocateSlot(Kind::Sampler);
+		VkDescriptorImageInfo imageInfo{ sampler, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED };
+		writeDescriptor(Kind::Sampler, slot, nullptr, &imageInfo);
+		return slot;
+	}
+
+	/**
+	 * Releases a slot. Frames in flight may still index it, so it is only handed out again once they have
+	 * finished, see DeferredDeletionQueue.
+	 */
+	void BindlessResources::release(Kind kind, uint32_t slot)
+	{
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			++pendingReleaseCount;
+		}
+		deletionQueue.enqueue([this, kind, slot]() {
+			std::lock_guard<std::mutex> lock{ mutex };
+			slots[static_cast<size_t>(kind)].free(slot);
+			--pendingReleaseCount;
+		});
+	}
+
+	void BindlessResources::bind(
+		VkCommandBuffer commandBuffer,
+		VkPipelineLayout pipelineLayout,
+		uint32_t setIndex,
+		VkPipelineBindPoint bindPoint
+	) const
+	{
+		vkCmdBindDescriptorSets(commandBuffer, bindPoint, pipelineLayout, setIndex, 1, &descriptorSet, 0, nullptr);
+	}
+
+	VkDescriptorSetLayout BindlessResources::getDescriptorSetLayout() const
+	{
+		return setLayoutManager->getDescriptorSetLayout();
+	}
+
+	BindlessResources::Statistics BindlessResources::getStatistics() const
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		Statistics stats{};
+		for (size_t i = 0; i < KIND_COUNT; ++i) {
+			stats.capacity[i] = slots[i].getCapacity();
+			stats.used[i] = slots[i].getUsed();
+		}
+		stats.pendingReleases = pendingReleaseCount;
+		return stats;
+	}
+
+	uint32_t BindlessResources::allocateSlot(Kind kind)
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		uint32_t slot;
+		if (!slots[static_cast<size_t>(kind)].allocate(slot)) {
+			throw std::runtime_error("Bindless descriptor array is full");
+		}
+		return slot;
+	}
+
+	void BindlessResources::writeDescriptor(
+		Kind kind,
+		uint32_t slot,
+		const VkDescriptorBufferInfo* bufferInfo,
+		const VkDescriptorImageInfo* imageInfo
+	)
+	{
+		VkWriteDescriptorSet write{};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = descriptorSet;
+		write.dstBinding = getBinding(kind);
+		write.dstArrayElement = slot;
+		write.descriptorType = getDescriptorType(kind);
+		write.descriptorCount = 1;
+		write.pBufferInfo = bufferInfo;
+		write.pImageInfo = imageInfo;
+
+		// update after bind allows writing unused slots while the set is bound in pending command buffers
+		vkUpdateDescriptorSets(devManager.getDeviceHandle(), 1, &write, 0, nullptr);
+	}
+
+	uint32_t BindlessResources::getBinding(Kind kind)
+	{
+		switch (kind) {
+		case Kind::StorageBuffer:
+			return STORAGE_BUFFER_BINDING;
+		case Kind::SampledImage:
+			return SAMPLED_IMAGE_BINDING;
+		default:
+			return SAMPLER_BINDING;
+		}
+	}
+
+	VkDescriptorType BindlessResources::getDescriptorType(Kind kind)
+	{
+		switch (kind) {
+		case Kind::StorageBuffer:
+			return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		case Kind::SampledImage:
+			return VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+		default:
+			return VK_DESCRIPTOR_TYPE_SAMPLER;
+		}
+	}
+}
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "BufferManager.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 
@@ -12,7 +13,9 @@ namespace Vulkan3DEngine
 		uint32_t instanceCount,
 		VkBufferUsageFlags usageFlags,
 		VkMemoryPropertyFlags memoryPropertyFlags,
-		VkDeviceSize minOffsetAlignment
+		VkDeviceSize minOffsetAlignment,
+		MemoryAllocator::Category category,
+		VkMemoryPropertyFlags preferredMemoryPropertyFlags
 	) : deviceManager{ deviceManager },
 		instanceSize{ instanceSize },
 		instanceCount{ instanceCount },
@@ -21,50 +24,64 @@ namespace Vulkan3DEngine
 	{
 		alignmentSize = getAlignment(instanceSize, minOffsetAlignment);
 		bufferSize = alignmentSize * instanceCount;
-		deviceManager.createBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, memory);
+		deviceManager.createBuffer(
+			bufferSize,
+			usageFlags,
+			memoryPropertyFlags,
+			buffer,
+			allocation,
+			category,
+			preferredMemoryPropertyFlags
+		);
+
+		// the chosen memory type may be coherent even if that was not requested
+		hostCoherent = deviceManager.getMemoryTypeProperties(allocation.memoryTypeIndex) & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+		nonCoherentAtomSize = deviceManager.physicalDeviceProperties.limits.nonCoherentAtomSize;
 	}
 
 	BufferManager::~BufferManager() 
 	{
 		unmap();
-		vkDestroyBuffer(deviceManager.getDeviceHandle(), buffer, nullptr);
-		vkFreeMemory(deviceManager.getDeviceHandle(), memory, nullptr);
+		deviceManager.destroyBuffer(buffer, allocation);
 	}
 
 	/**
 	 * Map a memory range of this buffer. If successful, mapped points to the specified buffer range.
 	 *
+	 * @note Host visible memory is persistently mapped by the allocator, so this only resolves the pointer
+	 *
 	 * @param size (Optional) Size of the memory range to map. Pass VK_WHOLE_SIZE to map the complete
 	 * buffer range.
 	 * @param offset (Optional) Byte offset from beginning
 	 *
-	 * @return VkResult of the buffer mapping call
+	 * @return VK_ERROR_MEMORY_MAP_FAILED if the buffer memory is not host visible
 	 */
-	VkResult BufferManager::map(VkDeviceSize size, VkDeviceSize offset) 
+	VkResult BufferManager::map([[maybe_unused]] VkDeviceSize size, VkDeviceSize offset) 
 	{
-		assert(buffer && memory && "Called map on buffer before create");
-		return vkMapMemory(deviceManager.getDeviceHandle(), memory, offset, size, 0, &mapped);
+		assert(buffer && allocation.memory && "Called map on buffer before create");
+		if (allocation.mapped == nullptr) {
+			return VK_ERROR_MEMORY_MAP_FAILED;
+		}
+		mapped = static_cast<char*>(allocation.mapped) + offset;
+		return VK_SUCCESS;
 	}
 
 	/**
 	 * Unmap a mapped memory range
 	 *
-	 * @note Does not return a result as vkUnmapMemory can't fail
+	 * @note The underlying memory block stays mapped until the allocation is freed
 	 */
 	void BufferManager::unmap() 
 	{
-		if (mapped) {
-			vkUnmapMemory(deviceManager.getDeviceHandle(), memory);
-			mapped = nullptr;
-		}
+		mapped = nullptr;
 	}
 
 	/**
 	 * Copies the specified data to the mapped buffer. Default value writes whole buffer range
 	 *
 	 * @param data Pointer to the data to copy
-	 * @param size (Optional) Size of the data to copy. Pass VK_WHOLE_SIZE to flush the complete buffer
-	 * range.
+	 * @param size (Optional) Size of the data to copy. Pass VK_WHOLE_SIZE to fill the buffer from offset
+	 * to its end.
 	 * @param offset (Optional) Byte offset from beginning of mapped region
 	 *
 	 */
@@ -73,13 +90,13 @@ namespace Vulkan3DEngine
 		assert(mapped && "Cannot copy to unmapped buffer");
 
 		if (size == VK_WHOLE_SIZE) {
-			memcpy(mapped, data, bufferSize);
-		}
-		else {
-			char* memOffset = (char*)mapped;
-			memOffset += offset;
-			memcpy(memOffset, data, size);
+			size = bufferSize - offset;
 		}
+		assert(offset + size <= bufferSize && "Write exceeds buffer size");
+
+		char* memOffset = (char*)mapped;
+		memOffset += offset;
+		memcpy(memOffset, data, size);
 	}
 
 	/**
@@ -95,11 +112,10 @@ namespace Vulkan3DEngine
 	 */
 	VkResult BufferManager::flush(VkDeviceSize size, VkDeviceSize offset) 
 	{
-		VkMappedMemoryRange mappedRange = {};
-		mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-		mappedRange.memory = memory;
-		mappedRange.offset = offset;
-		mappedRange.size = size;
+		if (hostCoherent) {
+			return VK_SUCCESS;
+		}
+		VkMappedMemoryRange mappedRange = getMappedRange(size, offset);
 		return vkFlushMappedMemoryRanges(deviceManager.getDeviceHandle(), 1, &mappedRange);
 	}
 
@@ -116,11 +132,10 @@ namespace Vulkan3DEngine
 	 */
 	VkResult BufferManager::invalidate(VkDeviceSize size, VkDeviceSize offset) 
 	{
-		VkMappedMemoryRange mappedRange = {};
-		mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-		mappedRange.memory = memory;
-		mappedRange.offset = offset;
-		mappedRange.size = size;
+		if (hostCoherent) {
+			return VK_SUCCESS;
+		}
+		VkMappedMemoryRange mappedRange = getMappedRange(size, offset);
 		return vkInvalidateMappedMemoryRanges(deviceManager.getDeviceHandle(), 1, &mappedRange);
 	}
 
@@ -230,6 +245,33 @@ namespace Vulkan3DEngine
 		return bufferSize; 
 	}
 
+	bool BufferManager::isHostCoherent() const
+	{
+		return hostCoherent;
+	}
+
+	/*
+	 * Returns the memory range covering size bytes at offset in this buffer, widened to multiples of
+	 * nonCoherentAtomSize as flushes and invalidations of non-coherent memory require. The range never
+	 * leaves the allocation, whose offset and size are already atom aligned or end the memory object.
+	 */
+	VkMappedMemoryRange BufferManager::getMappedRange(VkDeviceSize size, VkDeviceSize offset) const
+	{
+		VkDeviceSize allocationEnd = allocation.offset + allocation.size;
+		VkDeviceSize begin = allocation.offset + offset;
+		VkDeviceSize end = size == VK_WHOLE_SIZE ? allocationEnd : begin + size;
+
+		begin -= begin % nonCoherentAtomSize;
+		end = std::min((end + nonCoherentAtomSize - 1) / nonCoherentAtomSize * nonCoherentAtomSize, allocationEnd);
+
+		VkMappedMemoryRange mappedRange = {};
+		mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+		mappedRange.memory = allocation.memory;
+		mappedRange.offset = begin;
+		mappedRange.size = end - begin;
+		return mappedRange;
+	}
+
 
 	/*
 	 * Returns the minimum instance size required to be compatible with devices minOffsetAlignment
@@ -0,0 +1,66 @@
+#include "DeferredDeletionQueue.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+
+namespace Vulkan3DEngine
+{
+	DeferredDeletionQueue::DeferredDeletionQueue(int framesInFlight) : framesInFlight{ framesInFlight }
+	{
+		assert(framesInFlight > 0 && "At least one frame has to be in flight");
+	}
+
+	/**
+	 * Releases still pending are dropped without running: their owners are gone by now, and whatever the
+	 * callbacks captured is destroyed with them. The device has to be idle.
+	 */
+	DeferredDeletionQueue::~DeferredDeletionQueue()
+	{
+	}
+
+	void DeferredDeletionQueue::enqueue(std::function<void()> release)
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		pendingReleases.push_back({ std::move(release), frameCounter });
+	}
+
+	/**
+	 * Advances the frame counter; call once per frame after its in-flight fence has been waited on.
+	 * Releases queued framesInFlight frames ago run now, outside the lock, so they may queue releases
+	 * themselves.
+	 */
+	void DeferredDeletionQueue::nextFrame()
+	{
+		std::vector<PendingRelease> ready;
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			++frameCounter;
+
+			auto retired = std::stable_partition(pendingReleases.begin(), pendingReleases.end(), [this](const PendingRelease& pending) {
+				return frameCounter - pending.frame < static_cast<uint64_t>(framesInFlight);
+			});
+			ready.assign(std::make_move_iterator(retired), std::make_move_iterator(pendingReleases.end()));
+			pendingReleases.erase(retired, pendingReleases.end());
+		}
+		for (auto& pending : ready) {
+			pending.release();
+		}
+	}
+
+	/**
+	 * Runs every pending release right away, for callers that have waited for the device to go idle
+	 * because they need the resources now
+	 */
+	void DeferredDeletionQueue::flush()
+	{
+		std::vector<PendingRelease> ready;
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			ready.swap(pendingReleases);
+		}
+		for (auto& pending : ready) {
+			pending.release();
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include "DescriptorBenchmark.h"
+
+#include "Descriptors.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+namespace Vulkan3DEngine
+{
+	/**
+	 * Each iteration rewrites both bindings with a different offset into the frame allocator's first buffer,
+	 * so no path can skip work because nothing changed. Push descriptors are only recorded, the command
+	 * buffer is submitted after timing.
+	 */
+	void DescriptorBenchmark::run(DeviceManager& devManager, FrameAllocator& frameAllocator, uint32_t iterations)
+	{
+		constexpr uint32_t offsetCount = 64;
+		constexpr VkDeviceSize range = 256;
+
+		auto setLayoutManager = DescriptorSetLayoutManager::Builder(devManager)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+			.addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+			.build();
+
+		auto poolManager = DescriptorPoolManager::Builder(devManager)
+			.setMaxSets(1)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1)
+			.build();
+
+		VkDescriptorSet descriptorSet;
+		if (!poolManager->allocateDescriptorSet(setLayoutManager->getDescriptorSetLayout(), descriptorSet)) {
+			throw std::runtime_error("Failed to allocate benchmark descriptor set");
+		}
+
+		VkBuffer buffer = frameAllocator.getBuffer(0);
+		VkDeviceSize alignment = frameAllocator.getAlignment();
+		auto bufferInfoAt = [&](uint32_t i) -> VkDescriptorBufferInfo {
+			return { buffer, (i % offsetCount) * alignment, range };
+		};
+
+		using Clock = std::chrono::high_resolution_clock;
+		auto report = [iterations](const char* name, Clock::time_point start) {
+			double nanoseconds = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+			std::cout << "\t" << std::left << std::setw(32) << name << std::right << std::fixed << std::setprecision(1)
+				<< nanoseconds / iterations << " ns per update" << std::defaultfloat << std::endl;
+		};
+
+		std::cout << "Descriptor update benchmark, " << iterations << " updates of 2 descriptors:" << std::endl;
+
+		auto start = Clock::now();
+		for (uint32_t i = 0; i < iterations; ++i) {
+			VkDescriptorBufferInfo uniformInfo = bufferInfoAt(i);
+			VkDescriptorBufferInfo storageInfo = bufferInfoAt(i + 1);
+			DescriptorWriter(*setLayoutManager, *poolManager)
+				.writeBuffer(0, &uniformInfo)
+				.writeBuffer(1, &storageInfo)
+				.overwrite(descriptorSet);
+		}
+		report("DescriptorWriter::overwrite", start);
+
+		if (!devManager.isDescriptorUpdateTemplateSupported()) {
+			std::cout << "\tUpdate templates need Vulkan 1.1, skipping the remaining paths" << std::endl;
+			return;
+		}
+
+		DescriptorUpdateTemplate updateTemplate{ devManager, *setLayoutManager };
+		std::vector<DescriptorUpdateTemplate::Entry> entries(updateTemplate.getEntryCount());
+		uint32_t uniformEntry = updateTemplate.getEntryIndex(0);
+		uint32_t storageEntry = updateTemplate.getEntryIndex(1);
+
+		start = Clock::now();
+		for (uint32_t i = 0; i < iterations; ++i) {
+			entries[uniformEntry].buffer = bufferInfoAt(i);
+			entries[storageEntry].buffer = bufferInfoAt(i + 1);
+			updateTemplate.update(descriptorSet, entries.data());
+		}
+		report("vkUpdateDescriptorSetWithTemplate", start);
+
+		if (!devManager.isPushDescriptorSupported()) {
+			std::cout << "\tVK_KHR_push_descriptor not supported, skipping push descriptors" << std::endl;
+			return;
+		}
+
+		auto pushSetLayoutManager = DescriptorSetLayoutManager::Builder(devManager)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+			.addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+			.setLayoutFlags(VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR)
+			.build();
+		VkDescriptorSetLayout pushSetLayout = pushSetLayoutManager->getDescriptorSetLayout();
+
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = 1;
+		pipelineLayoutInfo.pSetLayouts = &pushSetLayout;
+
+		VkPipelineLayout pipelineLayout;
+		if (vkCreatePipelineLayout(devManager.getDeviceHandle(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create pipeline layout");
+		}
+
+		{
+			DescriptorUpdateTemplate pushTemplate{ devManager, *pushSetLayoutManager, pipelineLayout, 0 };
+			VkCommandBuffer commandBuffer = devManager.beginSingleTimeCommands();
+
+			start = Clock::now();
+			for (uint32_t i = 0; i < iterations; ++i) {
+				entries[uniformEntry].buffer = bufferInfoAt(i);
+				entries[storageEntry].buffer = bufferInfoAt(i + 1);
+				pushTemplate.push(commandBuffer, entries.data());
+			}
+			report("vkCmdPushDescriptorSetWithTemplate", start);
+
+			devManager.endSingleTimeCommands(commandBuffer);
+		}
+		vkDestroyPipelineLayout(devManager.getDeviceHandle(), pipelineLayout, nullptr);
+	}
+}
\ No newline at end of file
@@ -1,11 +1,95 @@
 #include "Descriptors.h"
 
+#include <algorithm>
 #include <cassert>
 #include <stdexcept>
 
 namespace Vulkan3DEngine
 {
 
+	DescriptorLayoutCache::DescriptorLayoutCache(DeviceManager& devManager) : devManager{ devManager }
+	{
+	}
+
+	DescriptorLayoutCache::~DescriptorLayoutCache()
+	{
+		for (auto& kv : layouts) {
+			vkDestroyDescriptorSetLayout(devManager.getDeviceHandle(), kv.second, nullptr);
+		}
+	}
+
+	/**
+	 * Returns the layout for the given bindings, creating it only the first time a binding list is seen.
+	 * Binding flags (keyed by binding number) and layout flags are part of the key, so an update after bind
+	 * layout never aliases a plain one. Layouts are owned by the cache and live as long as the device.
+	 */
+	VkDescriptorSetLayout DescriptorLayoutCache::getLayout(
+		std::vector<VkDescriptorSetLayoutBinding> bindings,
+		const std::unordered_map<uint32_t, VkDescriptorBindingFlags>& bindingFlags,
+		VkDescriptorSetLayoutCreateFlags layoutFlags
+	)
+	{
+		std::sort(bindings.begin(), bindings.end(), [](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b) {
+			return a.binding < b.binding;
+		});
+
+		std::vector<VkDescriptorBindingFlags> flags;
+		for (const auto& binding : bindings) {
+			auto it = bindingFlags.find(binding.binding);
+			flags.push_back(it != bindingFlags.end() ? it->second : 0);
+		}
+
+		DescriptorKey key;
+		key.reserve(bindings.size() * 5 + 1);
+		key.push_back(layoutFlags);
+		for (size_t i = 0; i < bindings.size(); ++i) {
+			key.push_back(bindings[i].binding);
+			key.push_back(bindings[i].descriptorType);
+			key.push_back(bindings[i].descriptorCount);
+			key.push_back(bindings[i].stageFlags);
+			key.push_back(flags[i]);
+		}
+
+		std::lock_guard<std::mutex> lock{ mutex };
+
+		auto it = layouts.find(key);
+		if (it != layouts.end()) {
+			++hitCount;
+			return it->second;
+		}
+
+		VkDescriptorSetLayoutCreateInfo descriptorSetLayoutInfo{};
+		descriptorSetLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		descriptorSetLayoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+		descriptorSetLayoutInfo.pBindings = bindings.data();
+		descriptorSetLayoutInfo.flags = layoutFlags;
+
+		VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+		if (!bindingFlags.empty()) {
+			bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+			bindingFlagsInfo.bindingCount = static_cast<uint32_t>(flags.size());
+			bindingFlagsInfo.pBindingFlags = flags.data();
+			descriptorSetLayoutInfo.pNext = &bindingFlagsInfo;
+		}
+
+		VkDescriptorSetLayout descriptorSetLayout;
+		if (vkCreateDescriptorSetLayout(
+			devManager.getDeviceHandle(),
+			&descriptorSetLayoutInfo,
+			nullptr,
+			&descriptorSetLayout) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create descriptor set layout");
+		}
+		layouts.emplace(std::move(key), descriptorSetLayout);
+		return descriptorSetLayout;
+	}
+
+	DescriptorLayoutCache::Statistics DescriptorLayoutCache::getStatistics() const
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		return { layouts.size(), hitCount };
+	}
+
 	DescriptorSetLayoutManager::Builder::Builder(DeviceManager& devManager) : devManager{ devManager } 
 	{
 	}
@@ -14,7 +98,8 @@ namespace Vulkan3DEngine
 		uint32_t binding, 
 		VkDescriptorType descriptorType, 
 		VkShaderStageFlags stageFlags, 
-		uint32_t count
+		uint32_t count,
+		VkDescriptorBindingFlags flags
 	)
 	{
 		assert(bindings.count(binding) == 0 && "Binding already in use");
@@ -24,18 +109,31 @@ namespace Vulkan3DEngine
 		layoutBinding.descriptorCount = count;
 		layoutBinding.stageFlags = stageFlags;
 		bindings[binding] = layoutBinding;
+		if (flags != 0) {
+			bindingFlags[binding] = flags;
+		}
+		return *this;
+	}
+
+	DescriptorSetLayoutManager::Builder& DescriptorSetLayoutManager::Builder::setLayoutFlags(
+		VkDescriptorSetLayoutCreateFlags flags
+	)
+	{
+		layoutFlags = flags;
 		return *this;
 	}
 
 	std::unique_ptr<DescriptorSetLayoutManager> DescriptorSetLayoutManager::Builder::build() const
 	{
-		return std::make_unique<DescriptorSetLayoutManager>(devManager, bindings);
+		return std::make_unique<DescriptorSetLayoutManager>(devManager, bindings, bindingFlags, layoutFlags);
 	}
 
 	DescriptorSetLayoutManager::DescriptorSetLayoutManager(
 		DeviceManager& devManager, 
 		std::unordered_map<uint32_t, 
-		VkDescriptorSetLayoutBinding> bindings
+		VkDescriptorSetLayoutBinding> bindings,
+		const std::unordered_map<uint32_t, VkDescriptorBindingFlags>& bindingFlags,
+		VkDescriptorSetLayoutCreateFlags layoutFlags
 	) : devManager{ devManager }, bindings{ bindings }
 	{
 		std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings{};
@@ -43,23 +141,12 @@ namespace Vulkan3DEngine
 			setLayoutBindings.push_back(kv.second);
 		}
 
-		VkDescriptorSetLayoutCreateInfo descriptorSetLayoutInfo{};
-		descriptorSetLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-		descriptorSetLayoutInfo.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
-		descriptorSetLayoutInfo.pBindings = setLayoutBindings.data();
-
-		if (vkCreateDescriptorSetLayout(
-			devManager.getDeviceHandle(),
-			&descriptorSetLayoutInfo,
-			nullptr,
-			&descriptorSetLayout) != VK_SUCCESS) {
-			throw std::runtime_error("Failed to create descriptor set layout");
-		}
+		// identical binding lists share one layout, owned by the device's layout cache
+		descriptorSetLayout = devManager.getDescriptorLayoutCache().getLayout(setLayoutBindings, bindingFlags, layoutFlags);
 	}
 
 	DescriptorSetLayoutManager::~DescriptorSetLayoutManager()
 	{
-		vkDestroyDescriptorSetLayout(devManager.getDeviceHandle(), descriptorSetLayout, nullptr);
 	}
 
 	VkDescriptorSetLayout DescriptorSetLayoutManager::getDescriptorSetLayout() const
@@ -133,7 +220,7 @@ namespace Vulkan3DEngine
 		allocInfo.pSetLayouts = &descriptorSetLayout;
 		allocInfo.descriptorSetCount = 1;
 
-		// Might want to create a class that handles this case, and builds a new pool whenever an old pool fills up
+		// fixed size pool; use DescriptorAllocator for sets whose number is not known up front
 		if (vkAllocateDescriptorSets(devManager.getDeviceHandle(), &allocInfo, &descriptorSet) != VK_SUCCESS) {
 			return false;
 		}
@@ -156,8 +243,134 @@ namespace Vulkan3DEngine
 	}
 
 
+	DescriptorAllocator::DescriptorAllocator(
+		DeviceManager& devManager,
+		const std::vector<PoolSizeRatio>& poolSizeRatios,
+		uint32_t initialSetsPerPool
+	) : devManager{ devManager }, poolSizeRatios{ poolSizeRatios }, setsPerPool{ initialSetsPerPool }
+	{
+		readyPools.push_back(createPool(setsPerPool));
+	}
+
+	DescriptorAllocator::~DescriptorAllocator()
+	{
+		for (auto pool : readyPools) {
+			vkDestroyDescriptorPool(devManager.getDeviceHandle(), pool, nullptr);
+		}
+		for (auto pool : fullPools) {
+			vkDestroyDescriptorPool(devManager.getDeviceHandle(), pool, nullptr);
+		}
+	}
+
+	/**
+	 * Allocates a descriptor set with the given layout. When the current pool is exhausted or fragmented it
+	 * is set aside until the next reset and the allocation is retried from a fresh pool.
+	 */
+	VkDescriptorSet DescriptorAllocator::allocate(VkDescriptorSetLayout descriptorSetLayout)
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+
+		VkDescriptorSetAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.pSetLayouts = &descriptorSetLayout;
+		allocInfo.descriptorSetCount = 1;
+
+		VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+		allocInfo.descriptorPool = getPool();
+		VkResult result = vkAllocateDescriptorSets(devManager.getDeviceHandle(), &allocInfo, &descriptorSet);
+
+		if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL) {
+			fullPools.push_back(allocInfo.descriptorPool);
+			readyPools.pop_back();
+
+			allocInfo.descriptorPool = getPool();
+			result = vkAllocateDescriptorSets(devManager.getDeviceHandle(), &allocInfo, &descriptorSet);
+		}
+
+		if (result != VK_SUCCESS) {
+			throw std::runtime_error("Failed to allocate descriptor set");
+		}
+
+		++allocationCount;
+		++totalAllocationCount;
+		return descriptorSet;
+	}
+
+	/**
+	 * Frees every set allocated so far by resetting all pools, which become available again
+	 */
+	void DescriptorAllocator::reset()
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+
+		for (auto pool : readyPools) {
+			vkResetDescriptorPool(devManager.getDeviceHandle(), pool, 0);
+		}
+		for (auto pool : fullPools) {
+			vkResetDescriptorPool(devManager.getDeviceHandle(), pool, 0);
+			readyPools.push_back(pool);
+		}
+		fullPools.clear();
+		allocationCount = 0;
+		++resetCount;
+	}
+
+	DescriptorAllocator::Statistics DescriptorAllocator::getStatistics() const
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+
+		Statistics stats{};
+		stats.poolCount = static_cast<uint32_t>(readyPools.size() + fullPools.size());
+		stats.fullPoolCount = static_cast<uint32_t>(fullPools.size());
+		stats.allocationCount = allocationCount;
+		stats.totalAllocationCount = totalAllocationCount;
+		stats.resetCount = resetCount;
+		return stats;
+	}
+
+	VkDescriptorPool DescriptorAllocator::getPool()
+	{
+		if (readyPools.empty()) {
+			// every new pool is larger, so a steady state is reached after a few frames
+			setsPerPool = std::min(setsPerPool + setsPerPool / 2, MAX_SETS_PER_POOL);
+			readyPools.push_back(createPool(setsPerPool));
+		}
+		return readyPools.back();
+	}
+
+	VkDescriptorPool DescriptorAllocator::createPool(uint32_t maxSets)
+	{
+		std::vector<VkDescriptorPoolSize> poolSizes;
+		for (const auto& ratio : poolSizeRatios) {
+			uint32_t count = std::max(static_cast<uint32_t>(ratio.ratio * maxSets), 1u);
+			poolSizes.push_back({ ratio.descriptorType, count });
+		}
+
+		VkDescriptorPoolCreateInfo descriptorPoolInfo{};
+		descriptorPoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		descriptorPoolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+		descriptorPoolInfo.pPoolSizes = poolSizes.data();
+		descriptorPoolInfo.maxSets = maxSets;
+
+		VkDescriptorPool pool;
+		if (vkCreateDescriptorPool(devManager.getDeviceHandle(), &descriptorPoolInfo, nullptr, &pool) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create descriptor pool");
+		}
+		return pool;
+	}
+
+
 	DescriptorWriter::DescriptorWriter(DescriptorSetLayoutManager& setLayout, DescriptorPoolManager& pool)
-		: setLayout{ setLayout }, pool{ pool }
+		: setLayout{ setLayout }, pool{ &pool }
+	{
+	}
+
+	DescriptorWriter::DescriptorWriter(DescriptorSetLayoutManager& setLayout, DescriptorAllocator& allocator)
+		: setLayout{ setLayout }, allocator{ &allocator }
+	{
+	}
+
+	DescriptorWriter::DescriptorWriter(DescriptorSetLayoutManager& setLayout) : setLayout{ setLayout }
 	{
 	}
 
@@ -207,8 +420,11 @@ namespace Vulkan3DEngine
 
 	bool DescriptorWriter::build(VkDescriptorSet& set)
 	{
-		bool success = pool.allocateDescriptorSet(setLayout.getDescriptorSetLayout(), set);
-		if (!success) {
+		assert((pool != nullptr || allocator != nullptr) && "Writer has no pool or allocator to build from");
+		if (allocator != nullptr) {
+			set = allocator->allocate(setLayout.getDescriptorSetLayout());
+		}
+		else if (!pool->allocateDescriptorSet(setLayout.getDescriptorSetLayout(), set)) {
 			return false;
 		}
 		overwrite(set);
@@ -220,6 +436,261 @@ namespace Vulkan3DEngine
 		for (auto& write : writes) {
 			write.dstSet = set;
 		}
-		vkUpdateDescriptorSets(pool.devManager.getDeviceHandle(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+		vkUpdateDescriptorSets(setLayout.devManager.getDeviceHandle(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+	}
+
+	DescriptorUpdateTemplate::DescriptorUpdateTemplate(DeviceManager& devManager, const DescriptorSetLayoutManager& setLayout)
+		: devManager{ devManager }
+	{
+		create(setLayout, VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET, VK_PIPELINE_BIND_POINT_GRAPHICS);
+	}
+
+	DescriptorUpdateTemplate::DescriptorUpdateTemplate(
+		DeviceManager& devManager,
+		const DescriptorSetLayoutManager& setLayout,
+		VkPipelineLayout pipelineLayout,
+		uint32_t set,
+		VkPipelineBindPoint bindPoint
+	) : devManager{ devManager }, pipelineLayout{ pipelineLayout }, set{ set }
+	{
+		if (!devManager.isPushDescriptorSupported()) {
+			throw std::runtime_error("Push descriptors are not supported by the device");
+		}
+		create(setLayout, VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR, bindPoint);
+		if (entryCount > devManager.getMaxPushDescriptors()) {
+			throw std::runtime_error("Layout has more descriptors than can be pushed");
+		}
+	}
+
+	DescriptorUpdateTemplate::~DescriptorUpdateTemplate()
+	{
+		vkDestroyDescriptorUpdateTemplate(devManager.getDeviceHandle(), updateTemplate, nullptr);
+	}
+
+	uint32_t DescriptorUpdateTemplate::getEntryCount() const
+	{
+		return entryCount;
+	}
+
+	uint32_t DescriptorUpdateTemplate::getEntryIndex(uint32_t binding, uint32_t arrayElement) const
+	{
+		assert(firstEntries.count(binding) == 1 && "Layout does not contain specified binding");
+		return firstEntries.at(binding) + arrayElement;
+	}
+
+	void DescriptorUpdateTemplate::update(VkDescriptorSet descriptorSet, const Entry* entries) const
+	{
+		assert(pipelineLayout == VK_NULL_HANDLE && "Push descriptor templates cannot update sets");
+		vkUpdateDescriptorSetWithTemplate(devManager.getDeviceHandle(), descriptorSet, updateTemplate, entries);
+	}
+
+	void DescriptorUpdateTemplate::push(VkCommandBuffer commandBuffer, const Entry* entries) const
+	{
+		assert(pipelineLayout != VK_NULL_HANDLE && "Template was not created for push descriptors");
+		devManager.cmdPushDescriptorSetWithTemplate(commandBuffer, updateTemplate, pipelineLayout, set, entries);
+	}
+
+	/**
+	 * Creates one template entry per binding, sorted by binding number; the descriptors of an array binding
+	 * are consecutive entries of the caller's Entry array.
+	 */
+	void DescriptorUpdateTemplate::create(
+		const DescriptorSetLayoutManager& setLayout,
+		VkDescriptorUpdateTemplateType templateType,
+		VkPipelineBindPoint bindPoint
+	)
+	{
+		if (!devManager.isDescriptorUpdateTemplateSupported()) {
+			throw std::runtime_error("Descriptor update templates require Vulkan 1.1");
+		}
+
+		std::vector<VkDescriptorSetLayoutBinding> bindings;
+		for (const auto& kv : setLayout.bindings) {
+			bindings.push_back(kv.second);
+		}
+		std::sort(bindings.begin(), bindings.end(), [](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b) {
+			return a.binding < b.binding;
+		});
+
+		std::vector<VkDescriptorUpdateTemplateEntry> templateEntries;
+		for (const auto& binding : bindings) {
+			VkDescriptorUpdateTemplateEntry templateEntry{};
+			templateEntry.dstBinding = binding.binding;
+			templateEntry.dstArrayElement = 0;
+			templateEntry.descriptorCount = binding.descriptorCount;
+			templateEntry.descriptorType = binding.descriptorType;
+			templateEntry.offset = entryCount * sizeof(Entry);
+			templateEntry.stride = sizeof(Entry);
+			templateEntries.push_back(templateEntry);
+
+			firstEntries[binding.binding] = entryCount;
+			entryCount += binding.descriptorCount;
+		}
+
+		VkDescriptorUpdateTemplateCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+		createInfo.descriptorUpdateEntryCount = static_cast<uint32_t>(templateEntries.size());
+		createInfo.pDescriptorUpdateEntries = templateEntries.data();
+		createInfo.templateType = templateType;
+		createInfo.descriptorSetLayout = setLayout.getDescriptorSetLayout();
+		createInfo.pipelineBindPoint = bindPoint;
+		createInfo.pipelineLayout = pipelineLayout;
+		createInfo.set = set;
+
+		if (vkCreateDescriptorUpdateTemplate(devManager.getDeviceHandle(), &createInfo, nullptr, &updateTemplate) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create descriptor update template");
+		}
+	}
+
+	DescriptorSetCache::DescriptorSetCache(
+		DeviceManager& devManager,
+		int frameCount,
+		const std::vector<DescriptorAllocator::PoolSizeRatio>& poolSizeRatios
+	)
+	{
+		frames.resize(frameCount);
+		for (auto& frame : frames) {
+			frame.allocator = std::make_unique<DescriptorAllocator>(devManager, poolSizeRatios);
+		}
+	}
+
+	DescriptorSetCache::~DescriptorSetCache()
+	{
+	}
+
+	/**
+	 * Switches to the sets of the given frame. Call once the frame's fence has signaled; if the frame has
+	 * accumulated too many sets they are all released and rebuilt on demand.
+	 */
+	void DescriptorSetCache::beginFrame(int frameIndex)
+	{
+		assert(frameIndex >= 0 && frameIndex < static_cast<int>(frames.size()) && "Frame index out of range");
+		currentFrame = frameIndex;
+
+		FrameSets& frame = frames[currentFrame];
+		if (frame.allocatedSets >= MAX_SETS_PER_FRAME) {
+			frame.allocator->reset();
+			frame.sets.clear();
+			frame.allocatedSets = 0;
+			++flushCount;
+		}
+	}
+
+	/**
+	 * Returns a set of the current frame holding exactly the writer's resources, allocating and writing
+	 * one only if no such set exists yet
+	 */
+	VkDescriptorSet DescriptorSetCache::get(DescriptorWriter& writer)
+	{
+		FrameSets& frame = frames[currentFrame];
+		DescriptorKey key = makeKey(writer);
+
+		auto it = frame.sets.find(key);
+		if (it != frame.sets.end()) {
+			++hitCount;
+			return it->second.set;
+		}
+
+		++missCount;
+		VkDescriptorSet set = frame.allocator->allocate(writer.setLayout.getDescriptorSetLayout());
+		writer.overwrite(set);
+		frame.sets.emplace(std::move(key), CachedSet{ set, collectResources(writer) });
+		++frame.allocatedSets;
+		return set;
+	}
+
+	/**
+	 * Forgets every set of every frame referencing the buffer. Call before destroying it, so a buffer
+	 * created later with the same handle does not hit those sets. Frames in flight may still read them,
+	 * so they are only freed along with the rest of their frame's sets.
+	 */
+	void DescriptorSetCache::invalidateBuffer(VkBuffer buffer)
+	{
+		invalidate((uint64_t)buffer);
+	}
+
+	void DescriptorSetCache::invalidateImageView(VkImageView imageView)
+	{
+		invalidate((uint64_t)imageView);
+	}
+
+	void DescriptorSetCache::invalidateSampler(VkSampler sampler)
+	{
+		invalidate((uint64_t)sampler);
+	}
+
+	/**
+	 * Drops every cached set, e.g. after destroying many resources they may reference. The device must be idle.
+	 */
+	void DescriptorSetCache::clear()
+	{
+		for (auto& frame : frames) {
+			frame.allocator->reset();
+			frame.sets.clear();
+			frame.allocatedSets = 0;
+		}
+		++flushCount;
+	}
+
+	void DescriptorSetCache::invalidate(uint64_t handle)
+	{
+		for (auto& frame : frames) {
+			std::erase_if(frame.sets, [handle](const auto& entry) {
+				const auto& resources = entry.second.resources;
+				return std::find(resources.begin(), resources.end(), handle) != resources.end();
+			});
+		}
+	}
+
+	DescriptorSetCache::Statistics DescriptorSetCache::getStatistics() const
+	{
+		Statistics stats{};
+		for (const auto& frame : frames) {
+			stats.cachedSets += frame.sets.size();
+		}
+		stats.hitCount = hitCount;
+		stats.missCount = missCount;
+		stats.flushCount = flushCount;
+		return stats;
+	}
+
+	DescriptorKey DescriptorSetCache::makeKey(const DescriptorWriter& writer)
+	{
+		DescriptorKey key;
+		key.push_back((uint64_t)writer.setLayout.getDescriptorSetLayout());
+		for (const auto& write : writer.writes) {
+			key.push_back(write.dstBinding);
+			key.push_back(write.descriptorType);
+			if (write.pBufferInfo != nullptr) {
+				key.push_back((uint64_t)write.pBufferInfo->buffer);
+				key.push_back(write.pBufferInfo->offset);
+				key.push_back(write.pBufferInfo->range);
+			}
+			if (write.pImageInfo != nullptr) {
+				key.push_back((uint64_t)write.pImageInfo->sampler);
+				key.push_back((uint64_t)write.pImageInfo->imageView);
+				key.push_back(write.pImageInfo->imageLayout);
+			}
+		}
+		return key;
+	}
+
+	std::vector<uint64_t> DescriptorSetCache::collectResources(const DescriptorWriter& writer)
+	{
+		std::vector<uint64_t> resources;
+		for (const auto& write : writer.writes) {
+			if (write.pBufferInfo != nullptr) {
+				resources.push_back((uint64_t)write.pBufferInfo->buffer);
+			}
+			if (write.pImageInfo != nullptr) {
+				if (write.pImageInfo->sampler != VK_NULL_HANDLE) {
+					resources.push_back((uint64_t)write.pImageInfo->sampler);
+				}
+				if (write.pImageInfo->imageView != VK_NULL_HANDLE) {
+					resources.push_back((uint64_t)write.pImageInfo->imageView);
+				}
+			}
+		}
+		return resources;
 	}
 }
\ No newline at end of file
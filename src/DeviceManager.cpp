@@ -1,8 +1,15 @@
 #include "DeviceManager.h"
 
 #include "Constants.h"
+#include "Descriptors.h"
+#include "FileUtils.h"
+#include "GfxPipeline.h"
 
+#include <bit>
+#include <cassert>
 #include <cstring>
+#include <filesystem>
+#include <iomanip>
 #include <iostream>
 #include <set>
 #include <unordered_set>
@@ -84,10 +91,24 @@ namespace Vulkan3DEngine
 		selectPhysicalDevice();
 		createLogicalDevice();
 		createCommandPool();
+		createPipelineCache();
+		createMemoryAllocator();
+		createStagingRing();
+		createUploadBatcher();
+		createDescriptorLayoutCache();
+		createShaderCaches();
 	}
 
 	DeviceManager::~DeviceManager()
 	{
+		pipelineStateCache.reset();
+		shaderModuleCache.reset();
+		descriptorLayoutCache.reset();
+		uploadBatcher.reset();
+		stagingRing.reset();
+		memoryAllocator.reset();
+		savePipelineCache();
+		vkDestroyPipelineCache(device, pipelineCache, nullptr);
 		vkDestroyCommandPool(device, commandPool, nullptr);
 		vkDestroyDevice(device, nullptr);
 
@@ -95,7 +116,9 @@ namespace Vulkan3DEngine
 			DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
 		}
 
-		vkDestroySurfaceKHR(instance, surface, nullptr);
+		if (surface != VK_NULL_HANDLE) {
+			vkDestroySurfaceKHR(instance, surface, nullptr);
+		}
 		vkDestroyInstance(instance, nullptr);
 	}
 
@@ -104,6 +127,11 @@ namespace Vulkan3DEngine
 		return commandPool;
 	}
 
+	VkPipelineCache DeviceManager::getPipelineCacheHandle() const
+	{
+		return pipelineCache;
+	}
+
 	VkDevice DeviceManager::getDeviceHandle() const
 	{
 		return device;
@@ -124,25 +152,221 @@ namespace Vulkan3DEngine
 		return presentQueue;
 	}
 
+	VkQueue DeviceManager::getTransferQueueHandle() const
+	{
+		return transferQueue;
+	}
+
+	MemoryAllocator& DeviceManager::getMemoryAllocator() const
+	{
+		return *memoryAllocator;
+	}
+
+	StagingRing& DeviceManager::getStagingRing() const
+	{
+		return *stagingRing;
+	}
+
+	UploadBatcher& DeviceManager::getUploadBatcher() const
+	{
+		return *uploadBatcher;
+	}
+
+	DescriptorLayoutCache& DeviceManager::getDescriptorLayoutCache() const
+	{
+		return *descriptorLayoutCache;
+	}
+
+	ShaderModuleCache& DeviceManager::getShaderModuleCache() const
+	{
+		return *shaderModuleCache;
+	}
+
+	PipelineStateCache& DeviceManager::getPipelineStateCache() const
+	{
+		return *pipelineStateCache;
+	}
+
 	SwapChainSupportDetails DeviceManager::getSwapChainSupport()
 	{
 		return querySwapChainSupport(physicalDevice);
 	}
 
-	uint32_t DeviceManager::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const
+	/**
+	 * Finds a memory type matching typeFilter and properties.
+	 *
+	 * Among the matching types, the one with the most preferredProperties wins, e.g. DEVICE_LOCAL for
+	 * host visible data picks resizable BAR memory when the device exposes it. When the size of the
+	 * allocation is known, types whose heap has no room left for it within the budget are skipped;
+	 * if every matching heap is over budget the first matching type is returned anyway.
+	 */
+	uint32_t DeviceManager::findMemoryType(
+		uint32_t typeFilter,
+		VkMemoryPropertyFlags properties,
+		VkDeviceSize size,
+		VkMemoryPropertyFlags preferredProperties
+	) const
 	{
-		VkPhysicalDeviceMemoryProperties memProperties;
-		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
-		for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-			if ((typeFilter & (1 << i)) &&
-				(memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-				return i;
+		std::vector<HeapBudget> heaps;
+		if (size > 0) {
+			heaps = getMemoryBudget();
+		}
+
+		uint32_t firstMatch = UINT32_MAX;
+		uint32_t bestMatch = UINT32_MAX;
+		int bestScore = -1;
+		for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+			VkMemoryPropertyFlags flags = memoryProperties.memoryTypes[i].propertyFlags;
+			if (!(typeFilter & (1 << i)) || (flags & properties) != properties) {
+				continue;
 			}
+			if (firstMatch == UINT32_MAX) {
+				firstMatch = i;
+			}
+			if (size > 0) {
+				const HeapBudget& heap = heaps[memoryProperties.memoryTypes[i].heapIndex];
+				if (heap.usage + size > heap.budget) continue;
+			}
+			int score = std::popcount(flags & preferredProperties);
+			if (score > bestScore) {
+				bestMatch = i;
+				bestScore = score;
+			}
+		}
+		if (bestMatch != UINT32_MAX) {
+			return bestMatch;
+		}
+		if (firstMatch != UINT32_MAX) {
+			return firstMatch;
 		}
 		throw std::runtime_error("Failed to find a suitable memory type");
 		return UINT32_MAX;	// unreachable
 	}
 
+	VkMemoryPropertyFlags DeviceManager::getMemoryTypeProperties(uint32_t memoryTypeIndex) const
+	{
+		return memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags;
+	}
+
+	/**
+	 * Returns the budget and usage of every memory heap. Reported by the driver through VK_EXT_memory_budget
+	 * when available, otherwise estimated from the heap size and the allocator's own accounting.
+	 */
+	std::vector<HeapBudget> DeviceManager::getMemoryBudget() const
+	{
+		std::vector<HeapBudget> heaps(memoryProperties.memoryHeapCount);
+
+		if (memoryBudgetSupported) {
+			VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+			budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+			VkPhysicalDeviceMemoryProperties2 memProperties2{};
+			memProperties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+			memProperties2.pNext = &budgetProperties;
+			vkGetPhysicalDeviceMemoryProperties2(physicalDevice, &memProperties2);
+
+			for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; ++i) {
+				heaps[i].budget = budgetProperties.heapBudget[i];
+				heaps[i].usage = budgetProperties.heapUsage[i];
+			}
+		}
+		else {
+			for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; ++i) {
+				heaps[i].budget = static_cast<VkDeviceSize>(memoryProperties.memoryHeaps[i].size * FALLBACK_HEAP_BUDGET);
+				heaps[i].usage = memoryAllocator ? memoryAllocator->getHeapUsage(i) : 0;
+			}
+		}
+
+		for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; ++i) {
+			heaps[i].size = memoryProperties.memoryHeaps[i].size;
+			heaps[i].deviceLocal = memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+		}
+		return heaps;
+	}
+
+	bool DeviceManager::isMemoryBudgetSupported() const
+	{
+		return memoryBudgetSupported;
+	}
+
+	void DeviceManager::printMemoryReport() const
+	{
+		auto toMiB = [](VkDeviceSize bytes) { return static_cast<double>(bytes) / (1024.0 * 1024.0); };
+
+		std::streamsize previousPrecision = std::cout.precision();
+		std::cout << std::fixed << std::setprecision(1);
+		std::cout << "Device memory (" << (memoryBudgetSupported ? "reported by driver" : "estimated") << "):" << std::endl;
+		auto heaps = getMemoryBudget();
+		for (size_t i = 0; i < heaps.size(); ++i) {
+			std::cout << "\tHeap " << i << (heaps[i].deviceLocal ? " (device local)" : "") << ": "
+				<< toMiB(heaps[i].usage) << " / " << toMiB(heaps[i].budget) << " MiB budget, "
+				<< toMiB(heaps[i].size) << " MiB total" << std::endl;
+		}
+
+		MemoryAllocator::Statistics stats = memoryAllocator->getStatistics();
+		std::cout << "Engine allocations by category:" << std::endl;
+		for (size_t i = 0; i < MemoryAllocator::CATEGORY_COUNT; ++i) {
+			std::cout << "\t" << MemoryAllocator::getCategoryName(static_cast<MemoryAllocator::Category>(i)) << ": "
+				<< toMiB(stats.categoryBytes[i]) << " MiB" << std::endl;
+		}
+		std::cout << std::defaultfloat << std::setprecision(previousPrecision);
+	}
+
+	bool DeviceManager::isDescriptorIndexingSupported() const
+	{
+		return descriptorIndexingSupported;
+	}
+
+	const VkPhysicalDeviceProperties& DeviceManager::getPhysicalDeviceProperties() const
+	{
+		return physicalDeviceProperties;
+	}
+
+	const VkPhysicalDeviceDescriptorIndexingProperties& DeviceManager::getDescriptorIndexingProperties() const
+	{
+		return descriptorIndexingProperties;
+	}
+
+	// Core 1.1 functionality needs both the instance and the device to be at 1.1
+	bool DeviceManager::isApiVersion11Supported() const
+	{
+		return instanceApiVersion >= VK_API_VERSION_1_1 && physicalDeviceProperties.apiVersion >= VK_API_VERSION_1_1;
+	}
+
+	// Descriptor update templates are core since 1.1
+	bool DeviceManager::isDescriptorUpdateTemplateSupported() const
+	{
+		return isApiVersion11Supported();
+	}
+
+	// Dedicated allocations and the *MemoryRequirements2 queries are core since 1.1
+	bool DeviceManager::isDedicatedAllocationSupported() const
+	{
+		return isApiVersion11Supported();
+	}
+
+	bool DeviceManager::isPushDescriptorSupported() const
+	{
+		return pushDescriptorSupported;
+	}
+
+	uint32_t DeviceManager::getMaxPushDescriptors() const
+	{
+		return maxPushDescriptors;
+	}
+
+	void DeviceManager::cmdPushDescriptorSetWithTemplate(
+		VkCommandBuffer commandBuffer,
+		VkDescriptorUpdateTemplate descriptorUpdateTemplate,
+		VkPipelineLayout pipelineLayout,
+		uint32_t set,
+		const void* data
+	) const
+	{
+		assert(pushDescriptorSupported && "Push descriptors are not supported by the device");
+		pushDescriptorSetWithTemplate(commandBuffer, descriptorUpdateTemplate, pipelineLayout, set, data);
+	}
+
 	QueueFamilyIndices DeviceManager::getQueueFamilies()
 	{
 		return queryQueueFamilies(physicalDevice);
@@ -174,7 +398,9 @@ namespace Vulkan3DEngine
 		VkBufferUsageFlags usage, 
 		VkMemoryPropertyFlags properties, 
 		VkBuffer& buffer, 
-		VkDeviceMemory& bufferMemory
+		MemoryAllocator::Allocation& bufferAllocation,
+		MemoryAllocator::Category category,
+		VkMemoryPropertyFlags preferredProperties
 	)
 	{
 		VkBufferCreateInfo bufferInfo{};
@@ -183,23 +409,57 @@ namespace Vulkan3DEngine
 		bufferInfo.usage = usage;
 		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
+		// Buffers written on the transfer queue are read on the graphics queue without ownership transfers
+		if (bufferQueueFamilies.size() > 1 && (usage & (VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT))) {
+			bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+			bufferInfo.queueFamilyIndexCount = static_cast<uint32_t>(bufferQueueFamilies.size());
+			bufferInfo.pQueueFamilyIndices = bufferQueueFamilies.data();
+		}
+
 		if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
 			throw std::runtime_error("Failed to create vertex buffer");
 		}
 
 		VkMemoryRequirements memRequirements;
-		vkGetBufferMemoryRequirements(device, buffer, &memRequirements);
+		MemoryAllocator::DedicatedRequest dedicated{};
+		if (isDedicatedAllocationSupported()) {
+			VkMemoryDedicatedRequirements dedicatedRequirements{};
+			dedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+			VkMemoryRequirements2 requirements2{};
+			requirements2.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+			requirements2.pNext = &dedicatedRequirements;
+
+			VkBufferMemoryRequirementsInfo2 requirementsInfo{};
+			requirementsInfo.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2;
+			requirementsInfo.buffer = buffer;
+			vkGetBufferMemoryRequirements2(device, &requirementsInfo, &requirements2);
+
+			memRequirements = requirements2.memoryRequirements;
+			dedicated.buffer = buffer;
+			dedicated.prefersDedicated = dedicatedRequirements.prefersDedicatedAllocation == VK_TRUE;
+			dedicated.requiresDedicated = dedicatedRequirements.requiresDedicatedAllocation == VK_TRUE;
+		}
+		else {
+			vkGetBufferMemoryRequirements(device, buffer, &memRequirements);
+		}
 
-		VkMemoryAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+		bufferAllocation = memoryAllocator->allocate(
+			memRequirements,
+			findMemoryType(memRequirements.memoryTypeBits, properties, memRequirements.size, preferredProperties),
+			MemoryAllocator::ResourceKind::Linear,
+			category,
+			&dedicated
+		);
 
-		if (vkAllocateMemory(device, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
-			throw std::runtime_error("Failed to allocate vertex buffer memory");
+		if (vkBindBufferMemory(device, buffer, bufferAllocation.memory, bufferAllocation.offset) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to bind buffer memory");
 		}
+	}
 
-		vkBindBufferMemory(device, buffer, bufferMemory, 0);
+	void DeviceManager::destroyBuffer(VkBuffer buffer, MemoryAllocator::Allocation& bufferAllocation)
+	{
+		vkDestroyBuffer(device, buffer, nullptr);
+		memoryAllocator->free(bufferAllocation);
 	}
 
 	VkCommandBuffer DeviceManager::beginSingleTimeCommands()
@@ -221,7 +481,7 @@ namespace Vulkan3DEngine
 		return commandBuffer;
 	}
 
-	void DeviceManager::endSingleTimeCommands(VkCommandBuffer commandBuffer)
+	void DeviceManager::endSingleTimeCommands(VkCommandBuffer commandBuffer, VkFence fence)
 	{
 		vkEndCommandBuffer(commandBuffer);
 
@@ -230,23 +490,20 @@ namespace Vulkan3DEngine
 		submitInfo.commandBufferCount = 1;
 		submitInfo.pCommandBuffers = &commandBuffer;
 
-		vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-		vkQueueWaitIdle(graphicsQueue);
+		vkQueueSubmit(graphicsQueue, 1, &submitInfo, fence);
+		if (fence != VK_NULL_HANDLE) {
+			vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX);
+		}
+		else {
+			vkQueueWaitIdle(graphicsQueue);
+		}
 
 		vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
 	}
 
-	void DeviceManager::copyBuffer(VkBuffer src, VkBuffer dst, VkDeviceSize size)
+	void DeviceManager::copyBuffer(VkBuffer src, VkBuffer dst, VkDeviceSize size, VkDeviceSize srcOffset, VkDeviceSize dstOffset)
 	{
-		VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
-		VkBufferCopy copyRegion{};
-		copyRegion.srcOffset = 0;  // Optional
-		copyRegion.dstOffset = 0;  // Optional
-		copyRegion.size = size;
-		vkCmdCopyBuffer(commandBuffer, src, dst, 1, &copyRegion);
-
-		endSingleTimeCommands(commandBuffer);
+		uploadBatcher->wait(uploadBatcher->copyBuffer(src, dst, size, srcOffset, dstOffset));
 	}
 
 	void DeviceManager::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount)
@@ -281,7 +538,9 @@ namespace Vulkan3DEngine
 		const VkImageCreateInfo& createInfo, 
 		VkMemoryPropertyFlags properties, 
 		VkImage& image, 
-		VkDeviceMemory& imageMemory
+		MemoryAllocator::Allocation& imageAllocation,
+		MemoryAllocator::Category category,
+		VkMemoryPropertyFlags preferredProperties
 	)
 	{
 		if (vkCreateImage(device, &createInfo, nullptr, &image) != VK_SUCCESS) {
@@ -289,22 +548,47 @@ namespace Vulkan3DEngine
 		}
 
 		VkMemoryRequirements memRequirements;
-		vkGetImageMemoryRequirements(device, image, &memRequirements);
-
-		VkMemoryAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-		if (vkAllocateMemory(device, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-			throw std::runtime_error("Failed to allocate image memory");
+		MemoryAllocator::DedicatedRequest dedicated{};
+		if (isDedicatedAllocationSupported()) {
+			VkMemoryDedicatedRequirements dedicatedRequirements{};
+			dedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+			VkMemoryRequirements2 requirements2{};
+			requirements2.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+			requirements2.pNext = &dedicatedRequirements;
+
+			VkImageMemoryRequirementsInfo2 requirementsInfo{};
+			requirementsInfo.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2;
+			requirementsInfo.image = image;
+			vkGetImageMemoryRequirements2(device, &requirementsInfo, &requirements2);
+
+			memRequirements = requirements2.memoryRequirements;
+			dedicated.image = image;
+			dedicated.prefersDedicated = dedicatedRequirements.prefersDedicatedAllocation == VK_TRUE;
+			dedicated.requiresDedicated = dedicatedRequirements.requiresDedicatedAllocation == VK_TRUE;
+		}
+		else {
+			vkGetImageMemoryRequirements(device, image, &memRequirements);
 		}
 
-		if (vkBindImageMemory(device, image, imageMemory, 0) != VK_SUCCESS) {
+		imageAllocation = memoryAllocator->allocate(
+			memRequirements,
+			findMemoryType(memRequirements.memoryTypeBits, properties, memRequirements.size, preferredProperties),
+			createInfo.tiling == VK_IMAGE_TILING_OPTIMAL ? MemoryAllocator::ResourceKind::Optimal : MemoryAllocator::ResourceKind::Linear,
+			category,
+			&dedicated
+		);
+
+		if (vkBindImageMemory(device, image, imageAllocation.memory, imageAllocation.offset) != VK_SUCCESS) {
 			throw std::runtime_error("Failed to bind image memory");
 		}
 	}
 
+	void DeviceManager::destroyImage(VkImage image, MemoryAllocator::Allocation& imageAllocation)
+	{
+		vkDestroyImage(device, image, nullptr);
+		memoryAllocator->free(imageAllocation);
+	}
+
 	void DeviceManager::createInstance()
 	{
 		if (enableValidationLayers && !checkValidationLayerSupport()) {
@@ -325,7 +609,24 @@ namespace Vulkan3DEngine
 			AppConstants::ENGINE_MINOR_VERSION, 
 			AppConstants::ENGINE_PATCH_VERSION
 		);
-		appInfo.apiVersion = VK_API_VERSION_1_0;
+
+		// 1.1 is enough for vkGetPhysicalDeviceMemoryProperties2, which the memory budget query relies on;
+		// 1.2 additionally makes descriptor indexing core
+		auto enumerateInstanceVersion = (PFN_vkEnumerateInstanceVersion)vkGetInstanceProcAddr(
+			nullptr,
+			"vkEnumerateInstanceVersion"
+		);
+		uint32_t loaderApiVersion = VK_API_VERSION_1_0;
+		if (enumerateInstanceVersion != nullptr) {
+			enumerateInstanceVersion(&loaderApiVersion);
+		}
+		if (loaderApiVersion >= VK_API_VERSION_1_2) {
+			instanceApiVersion = VK_API_VERSION_1_2;
+		}
+		else if (loaderApiVersion >= VK_API_VERSION_1_1) {
+			instanceApiVersion = VK_API_VERSION_1_1;
+		}
+		appInfo.apiVersion = instanceApiVersion;
 
 		VkInstanceCreateInfo createInfo = {};
 		createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -367,6 +668,7 @@ namespace Vulkan3DEngine
 
 	void DeviceManager::createSurface()
 	{
+		if (windowManager.isHeadless()) return;
 		windowManager.createWindowSurface(instance, &surface);
 	}
 
@@ -393,7 +695,14 @@ namespace Vulkan3DEngine
 		}
 
 		vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
 		std::cout << "Selected physical device: " << physicalDeviceProperties.deviceName << std::endl;
+
+		memoryBudgetSupported = isApiVersion11Supported() &&
+			isDeviceExtensionAvailable(physicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+		queryDescriptorIndexingSupport();
+		queryPushDescriptorSupport();
 	}
 
 	void DeviceManager::createLogicalDevice()
@@ -402,6 +711,9 @@ namespace Vulkan3DEngine
 
 		std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
 		std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily.value(), indices.presentFamily.value()};
+		if (indices.transferFamily.has_value()) {
+			uniqueQueueFamilies.insert(indices.transferFamily.value());
+		}
 
 		float queuePriority = 1.0f;
 		for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -416,15 +728,39 @@ namespace Vulkan3DEngine
 		VkPhysicalDeviceFeatures deviceFeatures = {};
 		deviceFeatures.samplerAnisotropy = VK_TRUE;
 
+		// features beyond 1.0 have to go through the pNext chain, which replaces pEnabledFeatures
+		VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures = getRequiredDescriptorIndexingFeatures();
+		VkPhysicalDeviceFeatures2 deviceFeatures2{};
+		deviceFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		deviceFeatures2.pNext = &indexingFeatures;
+		deviceFeatures2.features = deviceFeatures;
+
 		VkDeviceCreateInfo createInfo = {};
 		createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 
 		createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 		createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
-		createInfo.pEnabledFeatures = &deviceFeatures;
-		createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-		createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+		std::vector<const char*> enabledExtensions = getRequiredDeviceExtensions();
+		if (memoryBudgetSupported) {
+			enabledExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+		}
+		if (descriptorIndexingExtension) {
+			enabledExtensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+		}
+		if (pushDescriptorSupported) {
+			enabledExtensions.push_back(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+		}
+
+		if (descriptorIndexingSupported) {
+			createInfo.pNext = &deviceFeatures2;
+			createInfo.pEnabledFeatures = nullptr;
+		}
+		else {
+			createInfo.pEnabledFeatures = &deviceFeatures;
+		}
+		createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+		createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
 		// no longer necessary, but good practice :)
 		if (enableValidationLayers) {
@@ -439,8 +775,28 @@ namespace Vulkan3DEngine
 			throw std::runtime_error("Failed to create logical device");
 		}
 
+		if (pushDescriptorSupported) {
+			pushDescriptorSetWithTemplate = (PFN_vkCmdPushDescriptorSetWithTemplateKHR)vkGetDeviceProcAddr(
+				device,
+				"vkCmdPushDescriptorSetWithTemplateKHR"
+			);
+			pushDescriptorSupported = pushDescriptorSetWithTemplate != nullptr;
+		}
+
 		vkGetDeviceQueue(device, indices.graphicsFamily.value(), 0, &graphicsQueue);
 		vkGetDeviceQueue(device, indices.presentFamily.value(), 0, &presentQueue);
+
+		if (indices.transferFamily.has_value()) {
+			transferQueueFamily = indices.transferFamily.value();
+			vkGetDeviceQueue(device, transferQueueFamily, 0, &transferQueue);
+			bufferQueueFamilies = { indices.graphicsFamily.value(), transferQueueFamily };
+			std::cout << "Using dedicated transfer queue family " << transferQueueFamily << std::endl;
+		}
+		else {
+			transferQueueFamily = indices.graphicsFamily.value();
+			transferQueue = graphicsQueue;
+			bufferQueueFamilies = { indices.graphicsFamily.value() };
+		}
 	}
 
 	void DeviceManager::createCommandPool()
@@ -458,14 +814,88 @@ namespace Vulkan3DEngine
 		}
 	}
 
+	/**
+	 * Creates the pipeline cache shared by every pipeline, seeded from the file written on the last shutdown.
+	 * Data from another driver or GPU is discarded rather than handed to the driver.
+	 */
+	void DeviceManager::createPipelineCache()
+	{
+		std::vector<char> cacheData;
+		if (std::filesystem::exists(AppConstants::PIPELINE_CACHE_PATH)) {
+			cacheData = FileUtils::readBinaryFile(AppConstants::PIPELINE_CACHE_PATH);
+			if (!isPipelineCacheCompatible(cacheData)) {
+				std::cout << "Discarding pipeline cache written by a different device or driver" << std::endl;
+				cacheData.clear();
+			}
+		}
+
+		VkPipelineCacheCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		createInfo.initialDataSize = cacheData.size();
+		createInfo.pInitialData = cacheData.empty() ? nullptr : cacheData.data();
+
+		if (vkCreatePipelineCache(device, &createInfo, nullptr, &pipelineCache) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create pipeline cache");
+		}
+		if (!cacheData.empty()) {
+			std::cout << "Loaded pipeline cache (" << cacheData.size() << " bytes)" << std::endl;
+		}
+	}
+
+	// Called on shutdown; a failed write only costs recompiling the pipelines on the next launch
+	void DeviceManager::savePipelineCache()
+	{
+		size_t dataSize = 0;
+		if (vkGetPipelineCacheData(device, pipelineCache, &dataSize, nullptr) != VK_SUCCESS || dataSize == 0) {
+			return;
+		}
+		std::vector<char> cacheData(dataSize);
+		if (vkGetPipelineCacheData(device, pipelineCache, &dataSize, cacheData.data()) != VK_SUCCESS) {
+			return;
+		}
+
+		try {
+			FileUtils::writeBinaryFile(AppConstants::PIPELINE_CACHE_PATH, cacheData.data(), dataSize);
+		}
+		catch (const std::exception& e) {
+			std::cerr << "Failed to save pipeline cache: " << e.what() << std::endl;
+		}
+	}
+
+	void DeviceManager::createMemoryAllocator()
+	{
+		memoryAllocator = std::make_unique<MemoryAllocator>(device, memoryProperties);
+	}
+
+	void DeviceManager::createStagingRing()
+	{
+		stagingRing = std::make_unique<StagingRing>(*this);
+	}
+
+	void DeviceManager::createUploadBatcher()
+	{
+		uploadBatcher = std::make_unique<UploadBatcher>(*this, *stagingRing, transferQueue, transferQueueFamily);
+	}
+
+	void DeviceManager::createDescriptorLayoutCache()
+	{
+		descriptorLayoutCache = std::make_unique<DescriptorLayoutCache>(*this);
+	}
+
+	void DeviceManager::createShaderCaches()
+	{
+		shaderModuleCache = std::make_unique<ShaderModuleCache>(*this);
+		pipelineStateCache = std::make_unique<PipelineStateCache>(*this);
+	}
+
 	bool DeviceManager::isDeviceSuitable(VkPhysicalDevice physicalDev)
 	{
 		QueueFamilyIndices indices = queryQueueFamilies(physicalDev);
 
 		bool extensionsSupported = checkDeviceExtensionSupport(physicalDev);
 
-		bool swapChainAdequate = false;
-		if (extensionsSupported) {
+		bool swapChainAdequate = windowManager.isHeadless();
+		if (extensionsSupported && !swapChainAdequate) {
 			SwapChainSupportDetails swapChainSupport = querySwapChainSupport(physicalDev);
 			swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
 		}
@@ -479,11 +909,13 @@ namespace Vulkan3DEngine
 
 	std::vector<const char*> DeviceManager::getRequiredExtensions()
 	{
-		uint32_t glfwExtensionCount = 0;
-		const char** glfwExtensions;
-		glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-		std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+		std::vector<const char*> extensions;
+		if (!windowManager.isHeadless()) {
+			uint32_t glfwExtensionCount = 0;
+			const char** glfwExtensions;
+			glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+			extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+		}
 
 		if (enableValidationLayers) {
 			extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -492,6 +924,15 @@ namespace Vulkan3DEngine
 		return extensions;
 	}
 
+	std::vector<const char*> DeviceManager::getRequiredDeviceExtensions() const
+	{
+		// nothing is presented when headless
+		if (windowManager.isHeadless()) {
+			return {};
+		}
+		return deviceExtensions;
+	}
+
 	bool DeviceManager::checkValidationLayerSupport()
 	{
 		uint32_t layerCount;
@@ -533,8 +974,11 @@ namespace Vulkan3DEngine
 			if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
 				indices.graphicsFamily = i;
 			}
-			VkBool32 presentSupport = false;
-			vkGetPhysicalDeviceSurfaceSupportKHR(physicalDev, i, surface, &presentSupport);
+			// without a surface the graphics queue stands in for the present queue
+			VkBool32 presentSupport = surface == VK_NULL_HANDLE && indices.graphicsFamily.has_value();
+			if (surface != VK_NULL_HANDLE) {
+				vkGetPhysicalDeviceSurfaceSupportKHR(physicalDev, i, surface, &presentSupport);
+			}
 			if (queueFamily.queueCount > 0 && presentSupport) {
 				indices.presentFamily = i;
 			}
@@ -545,6 +989,22 @@ namespace Vulkan3DEngine
 			i++;
 		}
 
+		// Prefer a pure DMA family, otherwise any family that can transfer without graphics
+		for (uint32_t family = 0; family < queueFamilyCount && !indices.transferFamily.has_value(); ++family) {
+			VkQueueFlags flags = queueFamilies[family].queueFlags;
+			if (queueFamilies[family].queueCount > 0 && (flags & VK_QUEUE_TRANSFER_BIT) &&
+				!(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+				indices.transferFamily = family;
+			}
+		}
+		for (uint32_t family = 0; family < queueFamilyCount && !indices.transferFamily.has_value(); ++family) {
+			VkQueueFlags flags = queueFamilies[family].queueFlags;
+			if (queueFamilies[family].queueCount > 0 && (flags & (VK_QUEUE_TRANSFER_BIT | VK_QUEUE_COMPUTE_BIT)) &&
+				!(flags & VK_QUEUE_GRAPHICS_BIT)) {
+				indices.transferFamily = family;
+			}
+		}
+
 		return indices;
 	}
 
@@ -598,6 +1058,7 @@ namespace Vulkan3DEngine
 			availableExtensions.data()
 		);
 
+		auto deviceExtensions = getRequiredDeviceExtensions();
 		std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
 
 		for (const auto& extension : availableExtensions) {
@@ -607,6 +1068,124 @@ namespace Vulkan3DEngine
 		return requiredExtensions.empty();
 	}
 
+	bool DeviceManager::isDeviceExtensionAvailable(VkPhysicalDevice physicalDev, const char* extensionName)
+	{
+		uint32_t extensionCount;
+		vkEnumerateDeviceExtensionProperties(physicalDev, nullptr, &extensionCount, nullptr);
+
+		std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+		vkEnumerateDeviceExtensionProperties(physicalDev, nullptr, &extensionCount, availableExtensions.data());
+
+		for (const auto& extension : availableExtensions) {
+			if (strcmp(extension.extensionName, extensionName) == 0) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/**
+	 * Checks whether the selected device can back a bindless descriptor set: core in 1.2, otherwise through
+	 * VK_EXT_descriptor_indexing on a 1.1 device. Every feature enabled by getRequiredDescriptorIndexingFeatures
+	 * has to be supported, and the update after bind limits are queried for sizing the descriptor arrays.
+	 */
+	void DeviceManager::queryDescriptorIndexingSupport()
+	{
+		if (!isApiVersion11Supported()) {
+			return;
+		}
+
+		bool core = instanceApiVersion >= VK_API_VERSION_1_2 && physicalDeviceProperties.apiVersion >= VK_API_VERSION_1_2;
+		if (!core && !isDeviceExtensionAvailable(physicalDevice, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME)) {
+			return;
+		}
+
+		VkPhysicalDeviceDescriptorIndexingFeatures supported{};
+		supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+		VkPhysicalDeviceFeatures2 features2{};
+		features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features2.pNext = &supported;
+		vkGetPhysicalDeviceFeatures2(physicalDevice, &features2);
+
+		bool featuresSupported =
+			supported.shaderSampledImageArrayNonUniformIndexing &&
+			supported.shaderStorageBufferArrayNonUniformIndexing &&
+			supported.descriptorBindingSampledImageUpdateAfterBind &&
+			supported.descriptorBindingStorageBufferUpdateAfterBind &&
+			supported.descriptorBindingUpdateUnusedWhilePending &&
+			supported.descriptorBindingPartiallyBound &&
+			supported.runtimeDescriptorArray;
+		if (!featuresSupported) {
+			return;
+		}
+
+		descriptorIndexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+		VkPhysicalDeviceProperties2 properties2{};
+		properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties2.pNext = &descriptorIndexingProperties;
+		vkGetPhysicalDeviceProperties2(physicalDevice, &properties2);
+		descriptorIndexingProperties.pNext = nullptr;
+
+		descriptorIndexingSupported = true;
+		descriptorIndexingExtension = !core;
+		std::cout << "Descriptor indexing supported (" << (core ? "Vulkan 1.2" : "extension") << ")" << std::endl;
+	}
+
+	// Push descriptors are only used through update templates, which need 1.1
+	void DeviceManager::queryPushDescriptorSupport()
+	{
+		if (!isDescriptorUpdateTemplateSupported() ||
+			!isDeviceExtensionAvailable(physicalDevice, VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME)) {
+			return;
+		}
+
+		VkPhysicalDevicePushDescriptorPropertiesKHR pushDescriptorProperties{};
+		pushDescriptorProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PUSH_DESCRIPTOR_PROPERTIES_KHR;
+		VkPhysicalDeviceProperties2 properties2{};
+		properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties2.pNext = &pushDescriptorProperties;
+		vkGetPhysicalDeviceProperties2(physicalDevice, &properties2);
+
+		pushDescriptorSupported = true;
+		maxPushDescriptors = pushDescriptorProperties.maxPushDescriptors;
+	}
+
+	VkPhysicalDeviceDescriptorIndexingFeatures DeviceManager::getRequiredDescriptorIndexingFeatures()
+	{
+		VkPhysicalDeviceDescriptorIndexingFeatures features{};
+		features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+		features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+		features.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+		features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+		features.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+		features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+		features.descriptorBindingPartiallyBound = VK_TRUE;
+		features.runtimeDescriptorArray = VK_TRUE;
+		return features;
+	}
+
+	/**
+	 * Checks the header version one layout: header size, header version, vendor ID, device ID and the
+	 * pipeline cache UUID, which changes whenever the driver's cache format does.
+	 */
+	bool DeviceManager::isPipelineCacheCompatible(const std::vector<char>& cacheData) const
+	{
+		constexpr size_t headerSize = 4 * sizeof(uint32_t) + VK_UUID_SIZE;
+		if (cacheData.size() < headerSize) {
+			return false;
+		}
+
+		uint32_t header[4];
+		std::memcpy(header, cacheData.data(), sizeof(header));
+		const char* uuid = cacheData.data() + sizeof(header);
+
+		return header[0] >= headerSize &&
+			header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+			header[2] == physicalDeviceProperties.vendorID &&
+			header[3] == physicalDeviceProperties.deviceID &&
+			std::memcmp(uuid, physicalDeviceProperties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+	}
+
 	SwapChainSupportDetails DeviceManager::querySwapChainSupport(VkPhysicalDevice physicalDev)
 	{
 		SwapChainSupportDetails details;
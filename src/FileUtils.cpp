@@ -1,10 +1,127 @@
 #include "FileUtils.h"
 
+#include <cstdio>
 #include <fstream>
 #include <stdexcept>
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace Vulkan3DEngine
 {
+	FileUtils::MappedFile::MappedFile(const std::string& filePath)
+	{
+#ifdef _WIN32
+		HANDLE file = CreateFileA(
+			filePath.c_str(),
+			GENERIC_READ,
+			FILE_SHARE_READ,
+			nullptr,
+			OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+			nullptr
+		);
+		if (file == INVALID_HANDLE_VALUE) {
+			throw std::runtime_error("Failed to open file for mapping: " + filePath);
+		}
+		fileHandle = file;
+
+		LARGE_INTEGER fileSize{};
+		if (!GetFileSizeEx(file, &fileSize)) {
+			close();
+			throw std::runtime_error("Failed to query file size: " + filePath);
+		}
+		size = static_cast<size_t>(fileSize.QuadPart);
+		if (size == 0) {
+			return;
+		}
+
+		mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mappingHandle == nullptr) {
+			close();
+			throw std::runtime_error("Failed to create file mapping: " + filePath);
+		}
+
+		data = static_cast<const unsigned char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+		if (data == nullptr) {
+			close();
+			throw std::runtime_error("Failed to map file: " + filePath);
+		}
+#else
+		fileDescriptor = open(filePath.c_str(), O_RDONLY);
+		if (fileDescriptor < 0) {
+			throw std::runtime_error("Failed to open file for mapping: " + filePath);
+		}
+
+		struct stat fileStat{};
+		if (fstat(fileDescriptor, &fileStat) != 0) {
+			close();
+			throw std::runtime_error("Failed to query file size: " + filePath);
+		}
+		size = static_cast<size_t>(fileStat.st_size);
+		if (size == 0) {
+			return;
+		}
+
+		void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+		if (mapping == MAP_FAILED) {
+			close();
+			throw std::runtime_error("Failed to map file: " + filePath);
+		}
+		data = static_cast<const unsigned char*>(mapping);
+		madvise(mapping, size, MADV_SEQUENTIAL);
+#endif
+	}
+
+	FileUtils::MappedFile::~MappedFile()
+	{
+		close();
+	}
+
+	const unsigned char* FileUtils::MappedFile::getData() const
+	{
+		return data;
+	}
+
+	size_t FileUtils::MappedFile::getSize() const
+	{
+		return size;
+	}
+
+	void FileUtils::MappedFile::close()
+	{
+#ifdef _WIN32
+		if (data != nullptr) {
+			UnmapViewOfFile(data);
+		}
+		if (mappingHandle != nullptr) {
+			CloseHandle(mappingHandle);
+		}
+		if (fileHandle != nullptr) {
+			CloseHandle(fileHandle);
+		}
+		mappingHandle = nullptr;
+		fileHandle = nullptr;
+#else
+		if (data != nullptr) {
+			munmap(const_cast<unsigned char*>(data), size);
+		}
+		if (fileDescriptor >= 0) {
+			::close(fileDescriptor);
+		}
+		fileDescriptor = -1;
+#endif
+		data = nullptr;
+		size = 0;
+	}
+
 	std::vector<char> FileUtils::readBinaryFile(const std::string& filePath)
 	{
 		std::ifstream file(filePath, std::ios::ate | std::ios::binary);
@@ -21,4 +138,29 @@ namespace Vulkan3DEngine
 
 		return buff;
 	}
+
+	/**
+	 * Writes the data to a temporary file next to the target and renames it over the target, so an
+	 * interrupted write never leaves a truncated file behind.
+	 */
+	void FileUtils::writeBinaryFile(const std::string& filePath, const void* data, size_t size)
+	{
+		std::string tempPath = filePath + ".tmp";
+		{
+			std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+			if (!file.is_open()) {
+				throw std::runtime_error("Failed to open binary file for writing: " + tempPath);
+			}
+			file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+			if (!file) {
+				throw std::runtime_error("Failed to write binary file: " + tempPath);
+			}
+		}
+
+		// rename does not replace an existing file on Windows
+		std::remove(filePath.c_str());
+		if (std::rename(tempPath.c_str(), filePath.c_str()) != 0) {
+			throw std::runtime_error("Failed to replace binary file: " + filePath);
+		}
+	}
 }
\ No newline at end of file
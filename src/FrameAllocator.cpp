@@ -0,0 +1,123 @@
+#include "FrameAllocator.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace Vulkan3DEngine
+{
+	FrameAllocator::FrameAllocator(DeviceManager& devManager, int frameCount, VkDeviceSize capacity)
+		: capacity{ capacity }
+	{
+		const VkPhysicalDeviceLimits& limits = devManager.physicalDeviceProperties.limits;
+		alignment = std::max(limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment);
+
+		frameBuffers.resize(frameCount);
+		for (auto& frameBuffer : frameBuffers) {
+			frameBuffer = std::make_unique<BufferManager>(
+				devManager,
+				capacity,
+				1,
+				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+				1,
+				MemoryAllocator::Category::Uniform,
+				// resizable BAR memory lets shaders read the data without going over the bus
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+			);
+			if (frameBuffer->map() != VK_SUCCESS) {
+				throw std::runtime_error("Failed to map frame allocator buffer");
+			}
+		}
+	}
+
+	FrameAllocator::~FrameAllocator()
+	{
+	}
+
+	/**
+	 * Starts handing out slices of the given frame's buffer. Call once the frame's fence has signaled,
+	 * since everything allocated the last time this frame index was used is overwritten.
+	 */
+	void FrameAllocator::beginFrame(int frameIndex)
+	{
+		assert(frameIndex >= 0 && frameIndex < static_cast<int>(frameBuffers.size()) && "Frame index out of range");
+		peakBytes = std::max(peakBytes, getUsedBytes());
+		currentFrame = frameIndex;
+		head = 0;
+	}
+
+	/**
+	 * Reserves size bytes in the current frame's buffer, aligned for use as a dynamic uniform or storage
+	 * buffer offset. Safe to call from several threads recording the same frame.
+	 */
+	FrameAllocator::Slice FrameAllocator::allocate(VkDeviceSize size)
+	{
+		// sizes are rounded up to the alignment, so every offset handed out stays aligned
+		VkDeviceSize alignedSize = (size + alignment - 1) & ~(alignment - 1);
+		VkDeviceSize offset = head.fetch_add(alignedSize);
+		if (offset + alignedSize > capacity) {
+			throw std::runtime_error("Frame allocator is out of space");
+		}
+
+		BufferManager& frameBuffer = *frameBuffers[currentFrame];
+		return {
+			frameBuffer.getBuffer(),
+			static_cast<uint32_t>(offset),
+			size,
+			static_cast<char*>(frameBuffer.getMappedMemory()) + offset
+		};
+	}
+
+	/**
+	 * Makes everything allocated in the current frame visible to the device. Call before submitting the
+	 * frame; only the used part of the buffer is flushed, and nothing at all on host coherent memory.
+	 */
+	VkResult FrameAllocator::flush()
+	{
+		VkDeviceSize used = getUsedBytes();
+		if (used == 0) {
+			return VK_SUCCESS;
+		}
+		return frameBuffers[currentFrame]->flush(used, 0);
+	}
+
+	/**
+	 * Descriptor info for binding the frame's buffer as a dynamic uniform or storage buffer. The range is
+	 * the size of the structure read by the shader; the slice offset is supplied when binding the set.
+	 */
+	VkDescriptorBufferInfo FrameAllocator::descriptorInfo(int frameIndex, VkDeviceSize range) const
+	{
+		return frameBuffers[frameIndex]->descriptorInfo(range, 0);
+	}
+
+	VkBuffer FrameAllocator::getBuffer(int frameIndex) const
+	{
+		return frameBuffers[frameIndex]->getBuffer();
+	}
+
+	int FrameAllocator::getFrameCount() const
+	{
+		return static_cast<int>(frameBuffers.size());
+	}
+
+	VkDeviceSize FrameAllocator::getAlignment() const
+	{
+		return alignment;
+	}
+
+	VkDeviceSize FrameAllocator::getCapacity() const
+	{
+		return capacity;
+	}
+
+	VkDeviceSize FrameAllocator::getUsedBytes() const
+	{
+		return std::min(head.load(), capacity);
+	}
+
+	VkDeviceSize FrameAllocator::getPeakBytes() const
+	{
+		return std::max(peakBytes, getUsedBytes());
+	}
+}
\ No newline at end of file
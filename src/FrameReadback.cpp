@@ -0,0 +1,367 @@
+#include "FrameReadback.h"
+#include "FileUtils.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+namespace Vulkan3DEngine
+{
+
+	namespace
+	{
+
+		std::array<uint32_t, 256> makeCrcTable()
+		{
+			std::array<uint32_t, 256> table{};
+			for (uint32_t n = 0; n < 256; ++n) {
+				uint32_t c = n;
+				for (int k = 0; k < 8; ++k) {
+					c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+				}
+				table[n] = c;
+			}
+			return table;
+		}
+
+		uint32_t crc32(const unsigned char* data, size_t size, uint32_t crc = 0)
+		{
+			static const std::array<uint32_t, 256> table = makeCrcTable();
+			crc = ~crc;
+			for (size_t i = 0; i < size; ++i) {
+				crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+			}
+			return ~crc;
+		}
+
+		void appendBigEndian(std::vector<unsigned char>& out, uint32_t value)
+		{
+			out.push_back(static_cast<unsigned char>(value >> 24));
+			out.push_back(static_cast<unsigned char>(value >> 16));
+			out.push_back(static_cast<unsigned char>(value >> 8));
+			out.push_back(static_cast<unsigned char>(value));
+		}
+
+		void appendChunk(std::vector<unsigned char>& out, const char type[4], const std::vector<unsigned char>& data)
+		{
+			appendBigEndian(out, static_cast<uint32_t>(data.size()));
+			size_t typeOffset = out.size();
+			out.insert(out.end(), type, type + 4);
+			out.insert(out.end(), data.begin(), data.end());
+			appendBigEndian(out, crc32(out.data() + typeOffset, out.size() - typeOffset));
+		}
+
+	}
+
+	FrameReadback::FrameReadback(
+		DeviceManager& devManager,
+		ThreadPool& threadPool,
+		int framesInFlight,
+		const std::string& outputDirectory,
+		Format format
+	) : devManager{ devManager },
+		threadPool{ threadPool },
+		outputDirectory{ outputDirectory },
+		format{ format },
+		// a frame in flight's copy is read when its fence comes around again, the other half of the ring
+		// keeps rendering going while earlier frames are still being encoded
+		slots(static_cast<size_t>(framesInFlight) * 2)
+	{
+		std::error_code error;
+		std::filesystem::create_directories(outputDirectory, error);
+		if (error || !std::filesystem::is_directory(outputDirectory)) {
+			throw std::runtime_error("Failed to create frame export directory: " + outputDirectory);
+		}
+	}
+
+	FrameReadback::~FrameReadback()
+	{
+		// the encode tasks read the mapped buffers
+		waitForEncodes();
+	}
+
+	/**
+	 * The renderer has waited for this frame index's fence, so the copies recorded the last time the
+	 * index was used are complete and can be encoded
+	 */
+	void FrameReadback::beginFrame(int frameIndex)
+	{
+		dispatch(frameIndex);
+	}
+
+	/**
+	 * Copies the image into the next buffer of the ring, waiting only if that buffer is still being
+	 * written out. The host read barrier makes the copy visible once the frame's fence is waited for.
+	 */
+	void FrameReadback::record(VkCommandBuffer commandBuffer, VkImage image, VkFormat imageFormat, VkExtent2D extent, int frameIndex)
+	{
+		assert(isFormatSupported(imageFormat) && "Frame readback needs an 8 bit RGBA or BGRA image");
+
+		Slot& slot = slots[nextSlot];
+		nextSlot = (nextSlot + 1) % slots.size();
+		{
+			std::unique_lock<std::mutex> lock{ mutex };
+			assert(slot.state != SlotState::Copying && "Frame readback slot reused before its copy was collected");
+			if (slot.state != SlotState::Free) {
+				auto waitStart = std::chrono::high_resolution_clock::now();
+				slotFreed.wait(lock, [&slot]() { return slot.state == SlotState::Free; });
+				++statistics.stallCount;
+				statistics.stallSeconds += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - waitStart).count();
+			}
+			++statistics.capturedFrames;
+		}
+
+		// the extent only changes when the window is resized, the buffer is kept otherwise
+		VkDeviceSize size = static_cast<VkDeviceSize>(extent.width) * extent.height * 4;
+		if (!slot.buffer || slot.buffer->getBufferSize() < size) {
+			slot.buffer.reset();
+			slot.buffer = std::make_unique<BufferManager>(
+				devManager,
+				size,
+				1,
+				VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+				1,
+				MemoryAllocator::Category::Staging,
+				VK_MEMORY_PROPERTY_HOST_CACHED_BIT	// the host reads every byte
+			);
+			if (slot.buffer->map() != VK_SUCCESS) {
+				throw std::runtime_error("Failed to map frame readback buffer");
+			}
+		}
+
+		slot.state = SlotState::Copying;
+		slot.frameIndex = frameIndex;
+		slot.frameNumber = nextFrameNumber++;
+		slot.extent = extent;
+		slot.swapRedBlue = imageFormat == VK_FORMAT_B8G8R8A8_UNORM || imageFormat == VK_FORMAT_B8G8R8A8_SRGB;
+
+		VkBufferImageCopy region{};
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.layerCount = 1;
+		region.imageExtent = { extent.width, extent.height, 1 };
+		vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.buffer->getBuffer(), 1, &region);
+
+		VkBufferMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.buffer = slot.buffer->getBuffer();
+		barrier.offset = 0;
+		barrier.size = size;
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_HOST_BIT,
+			0,
+			0, nullptr,
+			1, &barrier,
+			0, nullptr
+		);
+	}
+
+	void FrameReadback::finish()
+	{
+		dispatch(-1);
+		waitForEncodes();
+	}
+
+	FrameReadback::Statistics FrameReadback::getStatistics() const
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		return statistics;
+	}
+
+	bool FrameReadback::isFormatSupported(VkFormat imageFormat)
+	{
+		return imageFormat == VK_FORMAT_R8G8B8A8_UNORM || imageFormat == VK_FORMAT_R8G8B8A8_SRGB ||
+			imageFormat == VK_FORMAT_B8G8R8A8_UNORM || imageFormat == VK_FORMAT_B8G8R8A8_SRGB;
+	}
+
+	/**
+	 * Hands the completed copies of a frame index, or of all frames for -1, to the thread pool
+	 */
+	void FrameReadback::dispatch(int frameIndex)
+	{
+		std::vector<Slot*> completed;
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			for (Slot& slot : slots) {
+				if (slot.state == SlotState::Copying && (frameIndex < 0 || slot.frameIndex == frameIndex)) {
+					slot.state = SlotState::Encoding;
+					++pendingEncodes;
+					completed.push_back(&slot);
+				}
+			}
+		}
+
+		for (size_t i = 0; i < completed.size(); ++i) {
+			Slot* slot = completed[i];
+			try {
+				if (slot->buffer->invalidate() != VK_SUCCESS) {
+					throw std::runtime_error("Failed to invalidate frame readback buffer");
+				}
+				threadPool.submit([this, slot]() { encode(*slot); });
+			}
+			catch (...) {
+				// the slots not handed to the pool are dropped, otherwise waitForEncodes never returns
+				{
+					std::lock_guard<std::mutex> lock{ mutex };
+					for (size_t j = i; j < completed.size(); ++j) {
+						completed[j]->state = SlotState::Free;
+						--pendingEncodes;
+						++statistics.failedFrames;
+					}
+				}
+				slotFreed.notify_all();
+				throw;
+			}
+		}
+	}
+
+	/**
+	 * Runs on the thread pool. A frame that fails to be written is reported and skipped, the export
+	 * carries on with the next one.
+	 */
+	void FrameReadback::encode(Slot& slot)
+	{
+		uint64_t writtenBytes = 0;
+		bool written = false;
+		try {
+			const auto* pixels = static_cast<const unsigned char*>(slot.buffer->getMappedMemory());
+			char fileName[64];
+			std::vector<unsigned char> file;
+			if (format == Format::Png) {
+				std::snprintf(fileName, sizeof(fileName), "frame_%06llu.png", static_cast<unsigned long long>(slot.frameNumber));
+				file = encodePng(pixels, slot.extent, slot.swapRedBlue);
+			}
+			else {
+				std::snprintf(
+					fileName,
+					sizeof(fileName),
+					"frame_%06llu_%ux%u.rgba",
+					static_cast<unsigned long long>(slot.frameNumber),
+					slot.extent.width,
+					slot.extent.height
+				);
+				file = encodeRaw(pixels, slot.extent, slot.swapRedBlue);
+			}
+
+			FileUtils::writeBinaryFile((std::filesystem::path(outputDirectory) / fileName).string(), file.data(), file.size());
+			writtenBytes = file.size();
+			written = true;
+		}
+		catch (std::exception& e) {
+			std::cerr << "Failed to export frame " << slot.frameNumber << ": " << e.what() << std::endl;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			if (written) {
+				++statistics.writtenFrames;
+				statistics.writtenBytes += writtenBytes;
+			}
+			else {
+				++statistics.failedFrames;
+			}
+			slot.state = SlotState::Free;
+			--pendingEncodes;
+		}
+		slotFreed.notify_all();
+	}
+
+	void FrameReadback::waitForEncodes()
+	{
+		std::unique_lock<std::mutex> lock{ mutex };
+		slotFreed.wait(lock, [this]() { return pendingEncodes == 0; });
+	}
+
+	/**
+	 * RGB PNG whose zlib stream uses uncompressed deflate blocks. Encoding is a single copy plus the
+	 * checksums, which keeps up with the GPU at the cost of file size.
+	 */
+	std::vector<unsigned char> FrameReadback::encodePng(const unsigned char* pixels, VkExtent2D extent, bool swapRedBlue)
+	{
+		// every row starts with filter type 0 (none)
+		size_t rowSize = static_cast<size_t>(extent.width) * 3 + 1;
+		std::vector<unsigned char> scanlines(rowSize * extent.height);
+		for (uint32_t y = 0; y < extent.height; ++y) {
+			unsigned char* row = scanlines.data() + rowSize * y;
+			const unsigned char* source = pixels + static_cast<size_t>(extent.width) * 4 * y;
+			row[0] = 0;
+			for (uint32_t x = 0; x < extent.width; ++x) {
+				row[1 + x * 3] = source[x * 4 + (swapRedBlue ? 2 : 0)];
+				row[2 + x * 3] = source[x * 4 + 1];
+				row[3 + x * 3] = source[x * 4 + (swapRedBlue ? 0 : 2)];
+			}
+		}
+
+		constexpr size_t MAX_STORED_BLOCK = 65535;
+		std::vector<unsigned char> zlib;
+		zlib.reserve(scanlines.size() + (scanlines.size() / MAX_STORED_BLOCK + 1) * 5 + 6);
+		zlib.push_back(0x78);	// deflate, 32K window
+		zlib.push_back(0x01);	// no preset dictionary, check bits
+		size_t offset = 0;
+		do {
+			size_t blockSize = std::min(MAX_STORED_BLOCK, scanlines.size() - offset);
+			bool last = offset + blockSize == scanlines.size();
+			zlib.push_back(last ? 1 : 0);
+			zlib.push_back(static_cast<unsigned char>(blockSize));
+			zlib.push_back(static_cast<unsigned char>(blockSize >> 8));
+			zlib.push_back(static_cast<unsigned char>(~blockSize));
+			zlib.push_back(static_cast<unsigned char>(~blockSize >> 8));
+			zlib.insert(zlib.end(), scanlines.begin() + offset, scanlines.begin() + offset + blockSize);
+			offset += blockSize;
+		} while (offset < scanlines.size());
+
+		// adler32, reduced every 5552 bytes, the most that cannot overflow 32 bits
+		uint32_t a = 1, b = 0;
+		for (size_t start = 0; start < scanlines.size(); start += 5552) {
+			size_t end = std::min(start + 5552, scanlines.size());
+			for (size_t i = start; i < end; ++i) {
+				a += scanlines[i];
+				b += a;
+			}
+			a %= 65521;
+			b %= 65521;
+		}
+		appendBigEndian(zlib, (b << 16) | a);
+
+		std::vector<unsigned char> header;
+		appendBigEndian(header, extent.width);
+		appendBigEndian(header, extent.height);
+		header.push_back(8);	// bit depth
+		header.push_back(2);	// truecolor
+		header.push_back(0);	// deflate
+		header.push_back(0);	// adaptive filtering
+		header.push_back(0);	// no interlacing
+
+		static constexpr unsigned char SIGNATURE[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+		std::vector<unsigned char> png(std::begin(SIGNATURE), std::end(SIGNATURE));
+		png.reserve(zlib.size() + 64);
+		appendChunk(png, "IHDR", header);
+		appendChunk(png, "IDAT", zlib);
+		appendChunk(png, "IEND", {});
+		return png;
+	}
+
+	std::vector<unsigned char> FrameReadback::encodeRaw(const unsigned char* pixels, VkExtent2D extent, bool swapRedBlue)
+	{
+		std::vector<unsigned char> raw(pixels, pixels + static_cast<size_t>(extent.width) * extent.height * 4);
+		if (swapRedBlue) {
+			for (size_t i = 0; i < raw.size(); i += 4) {
+				std::swap(raw[i], raw[i + 2]);
+			}
+		}
+		return raw;
+	}
+
+}
\ No newline at end of file
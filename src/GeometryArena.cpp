@@ -0,0 +1,161 @@
+#include "GeometryArena.h"
+
+#include "Model.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace Vulkan3DEngine
+{
+	GeometryArena::FreeList::FreeList(uint32_t capacity)
+	{
+		freeRanges[0] = capacity;
+	}
+
+	bool GeometryArena::FreeList::allocate(uint32_t count, Range& range)
+	{
+		for (auto it = freeRanges.begin(); it != freeRanges.end(); ++it) {
+			if (it->second < count) continue;
+
+			range = { it->first, count };
+			uint32_t remaining = it->second - count;
+			freeRanges.erase(it);
+			if (remaining > 0) {
+				freeRanges[range.offset + count] = remaining;
+			}
+			used += count;
+			return true;
+		}
+		return false;
+	}
+
+	void GeometryArena::FreeList::free(const Range& range)
+	{
+		uint32_t offset = range.offset;
+		uint32_t count = range.count;
+
+		auto next = freeRanges.lower_bound(offset);
+		if (next != freeRanges.end() && offset + count == next->first) {
+			count += next->second;
+			next = freeRanges.erase(next);
+		}
+		if (next != freeRanges.begin()) {
+			auto prev = std::prev(next);
+			if (prev->first + prev->second == offset) {
+				offset = prev->first;
+				count += prev->second;
+				freeRanges.erase(prev);
+			}
+		}
+		freeRanges[offset] = count;
+		used -= range.count;
+	}
+
+	uint32_t GeometryArena::FreeList::getUsed() const
+	{
+		return used;
+	}
+
+	GeometryArena::GeometryArena(
+		DeviceManager& devManager,
+		uint32_t vertexCapacity,
+		uint32_t indexCapacity,
+		DeferredDeletionQueue& deletionQueue
+	) : vertexRanges{ vertexCapacity }, indexRanges{ indexCapacity }, deletionQueue{ deletionQueue }
+	{
+		vertBufferManager = std::make_unique<BufferManager>(
+			devManager,
+			sizeof(Model::Vertex),
+			vertexCapacity,
+			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			1,
+			MemoryAllocator::Category::Mesh
+		);
+
+		idxBufferManager = std::make_unique<BufferManager>(
+			devManager,
+			sizeof(uint32_t),
+			indexCapacity,
+			VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			1,
+			MemoryAllocator::Category::Mesh
+		);
+	}
+
+	GeometryArena::~GeometryArena()
+	{
+	}
+
+	GeometryArena::Range GeometryArena::allocateVertices(uint32_t count)
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		Range range{};
+		if (!vertexRanges.allocate(count, range)) {
+			throw OutOfSpaceError("Geometry arena is out of vertex space");
+		}
+		return range;
+	}
+
+	GeometryArena::Range GeometryArena::allocateIndices(uint32_t count)
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		Range range{};
+		if (!indexRanges.allocate(count, range)) {
+			throw OutOfSpaceError("Geometry arena is out of index space");
+		}
+		return range;
+	}
+
+	/**
+	 * Releases a vertex range. It is only reused after every frame that may still draw from it has
+	 * finished, see DeferredDeletionQueue.
+	 */
+	void GeometryArena::freeVertices(const Range& range)
+	{
+		if (range.count == 0) return;
+		deletionQueue.enqueue([this, range]() {
+			std::lock_guard<std::mutex> lock{ mutex };
+			vertexRanges.free(range);
+		});
+	}
+
+	void GeometryArena::freeIndices(const Range& range)
+	{
+		if (range.count == 0) return;
+		deletionQueue.enqueue([this, range]() {
+			std::lock_guard<std::mutex> lock{ mutex };
+			indexRanges.free(range);
+		});
+	}
+
+	void GeometryArena::bind(VkCommandBuffer commandBuffer) const
+	{
+		VkBuffer buffers[] = { vertBufferManager->getBuffer() };
+		VkDeviceSize offsets[] = { 0 };
+		vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+		vkCmdBindIndexBuffer(commandBuffer, idxBufferManager->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+	}
+
+	VkBuffer GeometryArena::getVertexBuffer() const
+	{
+		return vertBufferManager->getBuffer();
+	}
+
+	VkBuffer GeometryArena::getIndexBuffer() const
+	{
+		return idxBufferManager->getBuffer();
+	}
+
+	GeometryArena::Statistics GeometryArena::getStatistics() const
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		return {
+			vertBufferManager->getInstanceCount(),
+			vertexRanges.getUsed(),
+			idxBufferManager->getInstanceCount(),
+			indexRanges.getUsed()
+		};
+	}
+}
\ No newline at end of file
@@ -1,12 +1,39 @@
 #include "GfxPipeline.h"
 
 #include "FileUtils.h"
+#include "HashUtils.h"
 
+#include <bit>
 #include <stdexcept>
 #include <cassert>
 
 namespace Vulkan3DEngine
 {
+	bool SpecializationConstants::empty() const
+	{
+		return mapEntries.empty();
+	}
+
+	VkSpecializationInfo SpecializationConstants::getInfo() const
+	{
+		VkSpecializationInfo info{};
+		info.mapEntryCount = static_cast<uint32_t>(mapEntries.size());
+		info.pMapEntries = mapEntries.data();
+		info.dataSize = data.size();
+		info.pData = data.data();
+		return info;
+	}
+
+	const std::vector<VkSpecializationMapEntry>& SpecializationConstants::getMapEntries() const
+	{
+		return mapEntries;
+	}
+
+	const std::vector<uint8_t>& SpecializationConstants::getData() const
+	{
+		return data;
+	}
+
 	void GfxPipeline::defaultPipelineConfigInfo(PipelineConfigInfo& configInfo)
 	{
 		configInfo.inputAssInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
@@ -97,16 +124,32 @@ namespace Vulkan3DEngine
 		DeviceManager& deviceManager, 
 		const std::string& vertShaderPath, 
 		const std::string& fragShaderPath, 
-		const PipelineConfigInfo& configInfo
+		const PipelineConfigInfo& configInfo,
+		VkPipelineCache pipelineCache
 	) : deviceManager{ deviceManager }
 	{
-		createGraphicsPipeline(vertShaderPath, fragShaderPath, configInfo);
+		auto& shaderModuleCache = deviceManager.getShaderModuleCache();
+		createGraphicsPipeline(
+			shaderModuleCache.getModule(vertShaderPath),
+			shaderModuleCache.getModule(fragShaderPath),
+			configInfo,
+			pipelineCache
+		);
+	}
+
+	GfxPipeline::GfxPipeline(
+		DeviceManager& deviceManager,
+		VkShaderModule vertShaderModule,
+		VkShaderModule fragShaderModule,
+		const PipelineConfigInfo& configInfo,
+		VkPipelineCache pipelineCache
+	) : deviceManager{ deviceManager }
+	{
+		createGraphicsPipeline(vertShaderModule, fragShaderModule, configInfo, pipelineCache);
 	}
 
 	GfxPipeline::~GfxPipeline()
 	{
-		vkDestroyShaderModule(deviceManager.getDeviceHandle(), vertShaderModule, nullptr);
-		vkDestroyShaderModule(deviceManager.getDeviceHandle(), fragShaderModule, nullptr);
 		vkDestroyPipeline(deviceManager.getDeviceHandle(), pipeline, nullptr);
 	}
 
@@ -116,9 +159,10 @@ namespace Vulkan3DEngine
 	}
 
 	void GfxPipeline::createGraphicsPipeline(
-		const std::string& vertShaderPath,
-		const std::string& fragShaderPath, 
-		const PipelineConfigInfo& configInfo
+		VkShaderModule vertShaderModule,
+		VkShaderModule fragShaderModule,
+		const PipelineConfigInfo& configInfo,
+		VkPipelineCache pipelineCache
 	)
 	{
 		assert(
@@ -130,21 +174,17 @@ namespace Vulkan3DEngine
 			"Cannot create graphics pipeline: renderPass not provided in configInfo"
 		);
 
-		auto vertShaderCode = FileUtils::readBinaryFile(vertShaderPath);
-		auto fragShaderCode = FileUtils::readBinaryFile(fragShaderPath);
-
-		createShaderModule(vertShaderCode, &vertShaderModule);
-		createShaderModule(fragShaderCode, &fragShaderModule);
+		VkSpecializationInfo vertSpecializationInfo = configInfo.vertSpecialization.getInfo();
+		VkSpecializationInfo fragSpecializationInfo = configInfo.fragSpecialization.getInfo();
 
 		VkPipelineShaderStageCreateInfo shaderStages[2];
-
 		shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 		shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
 		shaderStages[0].module = vertShaderModule;
 		shaderStages[0].pName = "main";
 		shaderStages[0].flags = 0;
 		shaderStages[0].pNext = nullptr;
-		shaderStages[0].pSpecializationInfo = nullptr;
+		shaderStages[0].pSpecializationInfo = configInfo.vertSpecialization.empty() ? nullptr : &vertSpecializationInfo;
 
 		shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 		shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
@@ -152,7 +192,7 @@ namespace Vulkan3DEngine
 		shaderStages[1].pName = "main";
 		shaderStages[1].flags = 0;
 		shaderStages[1].pNext = nullptr;
-		shaderStages[1].pSpecializationInfo = nullptr;
+		shaderStages[1].pSpecializationInfo = configInfo.fragSpecialization.empty() ? nullptr : &fragSpecializationInfo;
 
 		auto& bindingDescriptions = configInfo.bindingDescriptions;
 		auto& attribDescriptions = configInfo.attribDescriptions;
@@ -185,7 +225,7 @@ namespace Vulkan3DEngine
 
 		if (vkCreateGraphicsPipelines(
 			deviceManager.getDeviceHandle(), 
-			VK_NULL_HANDLE, 
+			pipelineCache != VK_NULL_HANDLE ? pipelineCache : deviceManager.getPipelineCacheHandle(), 
 			1, 
 			&pipelineInfo, 
 			nullptr, 
@@ -195,23 +235,325 @@ namespace Vulkan3DEngine
 		}
 	}
 
-	void GfxPipeline::createShaderModule(const std::vector<char> codeBytes, VkShaderModule* shaderModule)
+	ShaderModuleCache::ShaderModuleCache(DeviceManager& devManager) : devManager{ devManager }
+	{
+	}
+
+	ShaderModuleCache::~ShaderModuleCache()
+	{
+		for (auto& [hash, bucket] : modules) {
+			for (auto& cached : bucket) {
+				vkDestroyShaderModule(devManager.getDeviceHandle(), cached.module, nullptr);
+			}
+		}
+	}
+
+	/**
+	 * Returns the module for the given SPIR-V, creating it on first use
+	 *
+	 * @return Module owned by the cache, valid until releaseUnused drops it
+	 */
+	VkShaderModule ShaderModuleCache::getModule(const std::vector<char>& code)
 	{
+		uint64_t hash = HashUtils::hashBytes(code.data(), code.size());
+
+		std::lock_guard<std::mutex> lock{ mutex };
+		auto& bucket = modules[hash];
+		for (auto& cached : bucket) {
+			if (cached.code == code) {
+				++hitCount;
+				return cached.module;
+			}
+		}
+
 		VkShaderModuleCreateInfo createInfo{};
 		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-		createInfo.codeSize = codeBytes.size();
-		createInfo.pCode = reinterpret_cast<const uint32_t*>(codeBytes.data());
-
-		if (vkCreateShaderModule(
-			deviceManager.getDeviceHandle(),
-			&createInfo,
-			nullptr,
-			shaderModule
-		) != VK_SUCCESS) {
+		createInfo.codeSize = code.size();
+		createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+
+		VkShaderModule module;
+		if (vkCreateShaderModule(devManager.getDeviceHandle(), &createInfo, nullptr, &module) != VK_SUCCESS) {
 			throw std::runtime_error("Failed to create shader module");
 		}
+		bucket.push_back({ code, module });
+		return module;
+	}
+
+	VkShaderModule ShaderModuleCache::getModule(const std::string& filePath)
+	{
+		return getModule(FileUtils::readBinaryFile(filePath));
+	}
+
+	/**
+	 * Destroys every cached module not in inUse. Nothing may be creating a pipeline from a released module,
+	 * pipelines already created do not need theirs.
+	 */
+	void ShaderModuleCache::releaseUnused(const std::unordered_set<VkShaderModule>& inUse)
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		for (auto it = modules.begin(); it != modules.end();) {
+			auto& bucket = it->second;
+			std::erase_if(bucket, [this, &inUse](const CachedModule& cached) {
+				if (inUse.contains(cached.module)) {
+					return false;
+				}
+				vkDestroyShaderModule(devManager.getDeviceHandle(), cached.module, nullptr);
+				return true;
+			});
+			it = bucket.empty() ? modules.erase(it) : std::next(it);
+		}
+	}
+
+	ShaderModuleCache::Statistics ShaderModuleCache::getStatistics() const
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		Statistics stats{};
+		for (auto& [hash, bucket] : modules) {
+			stats.moduleCount += bucket.size();
+		}
+		stats.hitCount = hitCount;
+		return stats;
+	}
+
+	size_t PipelineStateCache::KeyHash::operator()(const Key& key) const
+	{
+		return static_cast<size_t>(HashUtils::hashBytes(key.data(), key.size() * sizeof(uint64_t)));
+	}
+
+	PipelineStateCache::PipelineStateCache(DeviceManager& devManager) : devManager{ devManager }
+	{
+	}
+
+	PipelineStateCache::~PipelineStateCache()
+	{
+	}
+
+	/**
+	 * Returns a pipeline matching the shaders and configuration, sharing one that is still alive if it
+	 * was built from identical state. The lock is not held while compiling, so concurrent requests for
+	 * the same new pipeline may both compile it; the first one stored wins. The modules are looked up
+	 * under the lock and pinned while compiling, so releaseUnusedShaderModules cannot destroy them.
+	 */
+	std::shared_ptr<GfxPipeline> PipelineStateCache::getPipeline(
+		const std::string& vertShaderPath,
+		const std::string& fragShaderPath,
+		const PipelineConfigInfo& configInfo,
+		VkPipelineCache pipelineCache
+	)
+	{
+		std::vector<char> vertCode = FileUtils::readBinaryFile(vertShaderPath);
+		std::vector<char> fragCode = FileUtils::readBinaryFile(fragShaderPath);
+
+		VkShaderModule vertShaderModule;
+		VkShaderModule fragShaderModule;
+		Key key;
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			auto& shaderModuleCache = devManager.getShaderModuleCache();
+			vertShaderModule = shaderModuleCache.getModule(vertCode);
+			fragShaderModule = shaderModuleCache.getModule(fragCode);
+			key = makeKey(vertShaderModule, fragShaderModule, configInfo);
+
+			auto it = pipelines.find(key);
+			if (it != pipelines.end()) {
+				if (auto pipeline = it->second.lock()) {
+					++hitCount;
+					return pipeline;
+				}
+			}
+			++buildingModules[vertShaderModule];
+			++buildingModules[fragShaderModule];
+		}
+
+		std::shared_ptr<GfxPipeline> pipeline;
+		try {
+			pipeline = std::make_shared<GfxPipeline>(devManager, vertShaderModule, fragShaderModule, configInfo, pipelineCache);
+		}
+		catch (...) {
+			std::lock_guard<std::mutex> lock{ mutex };
+			unpinModules(vertShaderModule, fragShaderModule);
+			throw;
+		}
+
+		std::lock_guard<std::mutex> lock{ mutex };
+		unpinModules(vertShaderModule, fragShaderModule);
+		auto& cached = pipelines[key];
+		if (auto existing = cached.lock()) {
+			++hitCount;
+			return existing;
+		}
+		++missCount;
+		cached = pipeline;
+		return pipeline;
+	}
+
+	/**
+	 * Destroys the cached shader modules that no live pipeline was built from and no pipeline being
+	 * compiled uses. Pipelines do not need their modules once created, so this waits for pipelines to be
+	 * dropped rather than for the GPU; RenderSystem calls it when a retired pipeline is released.
+	 */
+	void PipelineStateCache::releaseUnusedShaderModules()
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		std::unordered_set<VkShaderModule> inUse;
+		for (auto it = pipelines.begin(); it != pipelines.end();) {
+			if (it->second.expired()) {
+				it = pipelines.erase(it);
+				continue;
+			}
+			// the key starts with the two modules, see makeKey
+			inUse.insert((VkShaderModule)it->first[0]);
+			inUse.insert((VkShaderModule)it->first[1]);
+			++it;
+		}
+		for (auto& [module, count] : buildingModules) {
+			inUse.insert(module);
+		}
+		devManager.getShaderModuleCache().releaseUnused(inUse);
+	}
+
+	// Call with the lock held
+	void PipelineStateCache::unpinModules(VkShaderModule vertShaderModule, VkShaderModule fragShaderModule)
+	{
+		for (VkShaderModule module : { vertShaderModule, fragShaderModule }) {
+			auto it = buildingModules.find(module);
+			if (--it->second == 0) {
+				buildingModules.erase(it);
+			}
+		}
+	}
+
+	PipelineStateCache::Statistics PipelineStateCache::getStatistics() const
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		Statistics stats{};
+		for (auto& [key, pipeline] : pipelines) {
+			if (!pipeline.expired()) {
+				++stats.livePipelineCount;
+			}
+		}
+		stats.hitCount = hitCount;
+		stats.missCount = missCount;
+		return stats;
+	}
+
+	/**
+	 * Flattens everything that ends up in VkGraphicsPipelineCreateInfo into a key. Pointers inside the
+	 * create infos are skipped since they point back into configInfo, whose contents are already covered.
+	 */
+	PipelineStateCache::Key PipelineStateCache::makeKey(
+		VkShaderModule vertShaderModule,
+		VkShaderModule fragShaderModule,
+		const PipelineConfigInfo& configInfo
+	)
+	{
+		Key key;
+		auto add = [&key](uint64_t value) { key.push_back(value); };
+		auto addFloat = [&key](float value) { key.push_back(std::bit_cast<uint32_t>(value)); };
+		auto addSpecialization = [&add](const SpecializationConstants& constants) {
+			add(constants.getMapEntries().size());
+			for (auto& entry : constants.getMapEntries()) {
+				add(entry.constantID);
+				add(entry.offset);
+				add(entry.size);
+			}
+			add(constants.getData().size());
+			for (uint8_t byte : constants.getData()) {
+				add(byte);
+			}
+		};
+		auto addStencilOp = [&add](const VkStencilOpState& state) {
+			add(state.failOp);
+			add(state.passOp);
+			add(state.depthFailOp);
+			add(state.compareOp);
+			add(state.compareMask);
+			add(state.writeMask);
+			add(state.reference);
+		};
+
+		add((uint64_t)vertShaderModule);
+		add((uint64_t)fragShaderModule);
 
+		add(configInfo.bindingDescriptions.size());
+		for (auto& binding : configInfo.bindingDescriptions) {
+			add(binding.binding);
+			add(binding.stride);
+			add(binding.inputRate);
+		}
+		add(configInfo.attribDescriptions.size());
+		for (auto& attrib : configInfo.attribDescriptions) {
+			add(attrib.location);
+			add(attrib.binding);
+			add(attrib.format);
+			add(attrib.offset);
+		}
+
+		add(configInfo.viewportInfo.viewportCount);
+		add(configInfo.viewportInfo.scissorCount);
+
+		add(configInfo.inputAssInfo.topology);
+		add(configInfo.inputAssInfo.primitiveRestartEnable);
+
+		auto& raster = configInfo.rasterizationInfo;
+		add(raster.depthClampEnable);
+		add(raster.rasterizerDiscardEnable);
+		add(raster.polygonMode);
+		add(raster.cullMode);
+		add(raster.frontFace);
+		add(raster.depthBiasEnable);
+		addFloat(raster.depthBiasConstantFactor);
+		addFloat(raster.depthBiasClamp);
+		addFloat(raster.depthBiasSlopeFactor);
+		addFloat(raster.lineWidth);
+
+		auto& multisample = configInfo.multisampleInfo;
+		add(multisample.rasterizationSamples);
+		add(multisample.sampleShadingEnable);
+		addFloat(multisample.minSampleShading);
+		add(multisample.pSampleMask != nullptr ? *multisample.pSampleMask : ~0ull);
+		add(multisample.alphaToCoverageEnable);
+		add(multisample.alphaToOneEnable);
+
+		auto& blend = configInfo.colorBlendAttachment;
+		add(blend.blendEnable);
+		add(blend.srcColorBlendFactor);
+		add(blend.dstColorBlendFactor);
+		add(blend.colorBlendOp);
+		add(blend.srcAlphaBlendFactor);
+		add(blend.dstAlphaBlendFactor);
+		add(blend.alphaBlendOp);
+		add(blend.colorWriteMask);
+
+		add(configInfo.colorBlendInfo.logicOpEnable);
+		add(configInfo.colorBlendInfo.logicOp);
+		add(configInfo.colorBlendInfo.attachmentCount);
+		for (float constant : configInfo.colorBlendInfo.blendConstants) {
+			addFloat(constant);
+		}
+
+		auto& depthStencil = configInfo.depthStencilInfo;
+		add(depthStencil.depthTestEnable);
+		add(depthStencil.depthWriteEnable);
+		add(depthStencil.depthCompareOp);
+		add(depthStencil.depthBoundsTestEnable);
+		add(depthStencil.stencilTestEnable);
+		addStencilOp(depthStencil.front);
+		addStencilOp(depthStencil.back);
+		addFloat(depthStencil.minDepthBounds);
+		addFloat(depthStencil.maxDepthBounds);
+
+		add(configInfo.dynamicStateEnables.size());
+		for (auto state : configInfo.dynamicStateEnables) {
+			add(state);
+		}
 
+		add((uint64_t)configInfo.pipelineLayout);
+		add((uint64_t)configInfo.renderPass);
+		add(configInfo.subpass);
+		addSpecialization(configInfo.vertSpecialization);
+		addSpecialization(configInfo.fragSpecialization);
+		return key;
 	}
 
 }
\ No newline at end of file
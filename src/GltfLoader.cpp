@@ -0,0 +1,779 @@
+#include "GltfLoader.h"
+
+#include "FileUtils.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace Vulkan3DEngine
+{
+	namespace
+	{
+		constexpr uint32_t GLB_MAGIC = 0x46546C67;			// "glTF"
+		constexpr uint32_t GLB_CHUNK_JSON = 0x4E4F534A;		// "JSON"
+		constexpr uint32_t GLB_CHUNK_BIN = 0x004E4942;		// "BIN\0"
+		constexpr size_t GLB_HEADER_SIZE = 12;
+		constexpr size_t GLB_CHUNK_HEADER_SIZE = 8;
+
+		constexpr uint32_t COMPONENT_BYTE = 5120;
+		constexpr uint32_t COMPONENT_UNSIGNED_BYTE = 5121;
+		constexpr uint32_t COMPONENT_SHORT = 5122;
+		constexpr uint32_t COMPONENT_UNSIGNED_SHORT = 5123;
+		constexpr uint32_t COMPONENT_UNSIGNED_INT = 5125;
+		constexpr uint32_t COMPONENT_FLOAT = 5126;
+
+		constexpr int MODE_TRIANGLES = 4;
+		constexpr int MAX_JSON_DEPTH = 128;
+
+		struct JsonValue
+		{
+			enum class Type { Null, Bool, Number, String, Array, Object };
+
+			Type type = Type::Null;
+			bool boolean = false;
+			double number = 0.0;
+			std::string string;
+			std::vector<JsonValue> elements;	// array elements or object values
+			std::vector<std::string> keys;		// object keys, parallel to elements
+
+			const JsonValue* find(const std::string& key) const
+			{
+				if (type != Type::Object) return nullptr;
+				for (size_t i = 0; i < keys.size(); ++i) {
+					if (keys[i] == key) return &elements[i];
+				}
+				return nullptr;
+			}
+
+			size_t getArraySize() const
+			{
+				return type == Type::Array ? elements.size() : 0;
+			}
+
+			double getNumber(const std::string& key, double defaultValue) const
+			{
+				const JsonValue* value = find(key);
+				return (value != nullptr && value->type == Type::Number) ? value->number : defaultValue;
+			}
+
+			bool getBool(const std::string& key, bool defaultValue) const
+			{
+				const JsonValue* value = find(key);
+				return (value != nullptr && value->type == Type::Bool) ? value->boolean : defaultValue;
+			}
+
+			const std::string* getString(const std::string& key) const
+			{
+				const JsonValue* value = find(key);
+				return (value != nullptr && value->type == Type::String) ? &value->string : nullptr;
+			}
+		};
+
+		// Minimal recursive descent parser, sufficient for the glTF JSON chunk
+		class JsonParser
+		{
+		private:
+			const char* cur;
+			const char* end;
+			int depth = 0;
+
+		public:
+			JsonParser(const char* begin, const char* end) : cur{ begin }, end{ end } {}
+
+			JsonValue parse()
+			{
+				JsonValue root = parseValue();
+				skipWhitespace();
+				// The GLB JSON chunk may be padded with trailing spaces or null bytes
+				while (cur < end && *cur == '\0') ++cur;
+				if (cur != end) fail("unexpected trailing characters");
+				return root;
+			}
+
+		private:
+			[[noreturn]] void fail(const char* reason) const
+			{
+				throw std::runtime_error(std::string("Failed to parse glTF JSON: ") + reason);
+			}
+
+			void skipWhitespace()
+			{
+				while (cur < end && (*cur == ' ' || *cur == '\t' || *cur == '\n' || *cur == '\r')) ++cur;
+			}
+
+			void expect(char c)
+			{
+				skipWhitespace();
+				if (cur >= end || *cur != c) fail("unexpected character");
+				++cur;
+			}
+
+			JsonValue parseValue()
+			{
+				skipWhitespace();
+				if (cur >= end) fail("unexpected end of input");
+
+				JsonValue value{};
+				switch (*cur) {
+				case '{':
+					parseObject(value);
+					break;
+				case '[':
+					parseArray(value);
+					break;
+				case '"':
+					value.type = JsonValue::Type::String;
+					value.string = parseString();
+					break;
+				case 't':
+					parseLiteral("true");
+					value.type = JsonValue::Type::Bool;
+					value.boolean = true;
+					break;
+				case 'f':
+					parseLiteral("false");
+					value.type = JsonValue::Type::Bool;
+					break;
+				case 'n':
+					parseLiteral("null");
+					break;
+				default:
+					value.type = JsonValue::Type::Number;
+					value.number = parseNumber();
+					break;
+				}
+				return value;
+			}
+
+			void parseObject(JsonValue& value)
+			{
+				if (++depth > MAX_JSON_DEPTH) fail("nesting too deep");
+				value.type = JsonValue::Type::Object;
+				expect('{');
+				skipWhitespace();
+				if (cur < end && *cur == '}') {
+					++cur;
+					--depth;
+					return;
+				}
+				while (true) {
+					skipWhitespace();
+					if (cur >= end || *cur != '"') fail("expected object key");
+					value.keys.push_back(parseString());
+					expect(':');
+					value.elements.push_back(parseValue());
+					skipWhitespace();
+					if (cur < end && *cur == ',') {
+						++cur;
+						continue;
+					}
+					expect('}');
+					break;
+				}
+				--depth;
+			}
+
+			void parseArray(JsonValue& value)
+			{
+				if (++depth > MAX_JSON_DEPTH) fail("nesting too deep");
+				value.type = JsonValue::Type::Array;
+				expect('[');
+				skipWhitespace();
+				if (cur < end && *cur == ']') {
+					++cur;
+					--depth;
+					return;
+				}
+				while (true) {
+					value.elements.push_back(parseValue());
+					skipWhitespace();
+					if (cur < end && *cur == ',') {
+						++cur;
+						continue;
+					}
+					expect(']');
+					break;
+				}
+				--depth;
+			}
+
+			void parseLiteral(const char* literal)
+			{
+				size_t length = std::strlen(literal);
+				if (static_cast<size_t>(end - cur) < length || std::strncmp(cur, literal, length) != 0) {
+					fail("invalid literal");
+				}
+				cur += length;
+			}
+
+			double parseNumber()
+			{
+				double result = 0.0;
+				auto [ptr, ec] = std::from_chars(cur, end, result);
+				if (ec != std::errc() || ptr == cur) fail("invalid number");
+				cur = ptr;
+				return result;
+			}
+
+			uint32_t parseHex4()
+			{
+				if (end - cur < 4) fail("truncated unicode escape");
+				uint32_t code = 0;
+				for (int i = 0; i < 4; ++i) {
+					char c = *cur++;
+					code <<= 4;
+					if (c >= '0' && c <= '9') code |= c - '0';
+					else if (c >= 'a' && c <= 'f') code |= c - 'a' + 10;
+					else if (c >= 'A' && c <= 'F') code |= c - 'A' + 10;
+					else fail("invalid unicode escape");
+				}
+				return code;
+			}
+
+			static void appendUtf8(std::string& out, uint32_t code)
+			{
+				if (code < 0x80) {
+					out += static_cast<char>(code);
+				}
+				else if (code < 0x800) {
+					out += static_cast<char>(0xC0 | (code >> 6));
+					out += static_cast<char>(0x80 | (code & 0x3F));
+				}
+				else if (code < 0x10000) {
+					out += static_cast<char>(0xE0 | (code >> 12));
+					out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+					out += static_cast<char>(0x80 | (code & 0x3F));
+				}
+				else {
+					out += static_cast<char>(0xF0 | (code >> 18));
+					out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+					out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+					out += static_cast<char>(0x80 | (code & 0x3F));
+				}
+			}
+
+			std::string parseString()
+			{
+				++cur; // opening quote
+				std::string result;
+				while (true) {
+					if (cur >= end) fail("unterminated string");
+					char c = *cur++;
+					if (c == '"') break;
+					if (c != '\\') {
+						result += c;
+						continue;
+					}
+
+					if (cur >= end) fail("unterminated escape");
+					char escaped = *cur++;
+					switch (escaped) {
+					case '"': result += '"'; break;
+					case '\\': result += '\\'; break;
+					case '/': result += '/'; break;
+					case 'b': result += '\b'; break;
+					case 'f': result += '\f'; break;
+					case 'n': result += '\n'; break;
+					case 'r': result += '\r'; break;
+					case 't': result += '\t'; break;
+					case 'u': {
+						uint32_t code = parseHex4();
+						if (code >= 0xD800 && code <= 0xDBFF && end - cur >= 6 && cur[0] == '\\' && cur[1] == 'u') {
+							cur += 2;
+							uint32_t low = parseHex4();
+							code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+						}
+						appendUtf8(result, code);
+						break;
+					}
+					default:
+						fail("invalid escape");
+					}
+				}
+				return result;
+			}
+		};
+
+		struct ByteRange
+		{
+			const unsigned char* data = nullptr;
+			size_t size = 0;
+		};
+
+		struct Document
+		{
+			JsonValue json;
+			std::vector<ByteRange> buffers;
+			std::vector<std::unique_ptr<FileUtils::MappedFile>> externalFiles;
+		};
+
+		// Strided view of an accessor inside its (memory mapped) buffer; data is null for absent attributes
+		struct AccessorView
+		{
+			const unsigned char* data = nullptr;
+			size_t count = 0;
+			size_t stride = 0;
+			uint32_t componentType = 0;
+			uint32_t componentCount = 0;
+			bool normalized = false;
+		};
+
+		struct PrimitiveSource
+		{
+			AccessorView position;
+			AccessorView color;
+			AccessorView normal;
+			AccessorView texCoords;
+			AccessorView indices;
+			bool hasIndices = false;	// indices may still be null: an accessor without a buffer view is all zeros
+			uint32_t firstVertex = 0;
+			uint32_t firstIndex = 0;
+			uint32_t vertexCount = 0;
+			uint32_t indexCount = 0;
+		};
+
+		uint32_t readU32(const unsigned char* data)
+		{
+			uint32_t value;
+			std::memcpy(&value, data, sizeof(value));
+			return value;
+		}
+
+		const JsonValue& getArrayElement(const JsonValue& root, const char* arrayName, double index)
+		{
+			const JsonValue* array = root.find(arrayName);
+			if (array == nullptr || index < 0 || static_cast<size_t>(index) >= array->getArraySize()) {
+				throw std::runtime_error(std::string("glTF reference out of range in ") + arrayName);
+			}
+			return array->elements[static_cast<size_t>(index)];
+		}
+
+		void loadBuffers(Document& doc, const std::filesystem::path& baseDir, ByteRange glbBinChunk)
+		{
+			const JsonValue* buffers = doc.json.find("buffers");
+			for (size_t i = 0; i < (buffers ? buffers->getArraySize() : 0); ++i) {
+				const JsonValue& buffer = buffers->elements[i];
+				size_t byteLength = static_cast<size_t>(buffer.getNumber("byteLength", 0.0));
+				const std::string* uri = buffer.getString("uri");
+
+				ByteRange range{};
+				if (uri == nullptr) {
+					if (i != 0 || glbBinChunk.data == nullptr) {
+						throw std::runtime_error("glTF buffer has no uri and no GLB binary chunk");
+					}
+					range = glbBinChunk;
+				}
+				else if (uri->rfind("data:", 0) == 0) {
+					throw std::runtime_error("glTF embedded data URIs are not supported, convert the asset to .glb");
+				}
+				else {
+					auto file = std::make_unique<FileUtils::MappedFile>((baseDir / *uri).string());
+					range = { file->getData(), file->getSize() };
+					doc.externalFiles.push_back(std::move(file));
+				}
+
+				if (range.size < byteLength) {
+					throw std::runtime_error("glTF buffer is smaller than its declared byteLength");
+				}
+				range.size = byteLength;
+				doc.buffers.push_back(range);
+			}
+		}
+
+		Document parseDocument(const FileUtils::MappedFile& file, const std::string& filePath)
+		{
+			const unsigned char* data = file.getData();
+			size_t size = file.getSize();
+
+			const char* jsonBegin = nullptr;
+			const char* jsonEnd = nullptr;
+			ByteRange binChunk{};
+
+			if (size >= GLB_HEADER_SIZE && readU32(data) == GLB_MAGIC) {
+				if (readU32(data + 4) != 2) {
+					throw std::runtime_error("Unsupported GLB container version: " + filePath);
+				}
+				size_t length = std::min<size_t>(readU32(data + 8), size);
+
+				size_t offset = GLB_HEADER_SIZE;
+				while (offset + GLB_CHUNK_HEADER_SIZE <= length) {
+					size_t chunkLength = readU32(data + offset);
+					uint32_t chunkType = readU32(data + offset + 4);
+					offset += GLB_CHUNK_HEADER_SIZE;
+					if (chunkLength > length - offset) {
+						throw std::runtime_error("Truncated GLB chunk: " + filePath);
+					}
+
+					if (chunkType == GLB_CHUNK_JSON && jsonBegin == nullptr) {
+						jsonBegin = reinterpret_cast<const char*>(data + offset);
+						jsonEnd = jsonBegin + chunkLength;
+					}
+					else if (chunkType == GLB_CHUNK_BIN && binChunk.data == nullptr) {
+						binChunk = { data + offset, chunkLength };
+					}
+					offset += chunkLength;
+				}
+				if (jsonBegin == nullptr) {
+					throw std::runtime_error("GLB file has no JSON chunk: " + filePath);
+				}
+			}
+			else {
+				jsonBegin = reinterpret_cast<const char*>(data);
+				jsonEnd = jsonBegin + size;
+			}
+
+			Document doc{};
+			doc.json = JsonParser{ jsonBegin, jsonEnd }.parse();
+
+			const JsonValue* asset = doc.json.find("asset");
+			const std::string* version = asset ? asset->getString("version") : nullptr;
+			if (version == nullptr || version->rfind("2.", 0) != 0) {
+				throw std::runtime_error("Only glTF 2.x assets are supported: " + filePath);
+			}
+
+			loadBuffers(doc, std::filesystem::path(filePath).parent_path(), binChunk);
+			return doc;
+		}
+
+		uint32_t getComponentSize(uint32_t componentType)
+		{
+			switch (componentType) {
+			case COMPONENT_BYTE:
+			case COMPONENT_UNSIGNED_BYTE:
+				return 1;
+			case COMPONENT_SHORT:
+			case COMPONENT_UNSIGNED_SHORT:
+				return 2;
+			case COMPONENT_UNSIGNED_INT:
+			case COMPONENT_FLOAT:
+				return 4;
+			default:
+				throw std::runtime_error("Unknown glTF accessor component type");
+			}
+		}
+
+		uint32_t getComponentCount(const std::string& type)
+		{
+			if (type == "SCALAR") return 1;
+			if (type == "VEC2") return 2;
+			if (type == "VEC3") return 3;
+			if (type == "VEC4") return 4;
+			throw std::runtime_error("Unsupported glTF accessor type: " + type);
+		}
+
+		AccessorView resolveAccessor(const Document& doc, double accessorIndex)
+		{
+			const JsonValue& accessor = getArrayElement(doc.json, "accessors", accessorIndex);
+			if (accessor.find("sparse") != nullptr) {
+				throw std::runtime_error("Sparse glTF accessors are not supported");
+			}
+
+			const std::string* type = accessor.getString("type");
+			AccessorView view{};
+			view.count = static_cast<size_t>(accessor.getNumber("count", 0.0));
+			view.componentType = static_cast<uint32_t>(accessor.getNumber("componentType", 0.0));
+			view.componentCount = getComponentCount(type ? *type : "");
+			view.normalized = accessor.getBool("normalized", false);
+
+			// Accessors without a buffer view are defined to be all zeros
+			const JsonValue* bufferViewIndex = accessor.find("bufferView");
+			if (bufferViewIndex == nullptr || view.count == 0) {
+				return view;
+			}
+
+			const JsonValue& bufferView = getArrayElement(doc.json, "bufferViews", bufferViewIndex->number);
+			double bufferIndex = bufferView.getNumber("buffer", -1.0);
+			if (bufferIndex < 0 || static_cast<size_t>(bufferIndex) >= doc.buffers.size()) {
+				throw std::runtime_error("glTF buffer view references a missing buffer");
+			}
+			const ByteRange& buffer = doc.buffers[static_cast<size_t>(bufferIndex)];
+
+			size_t viewOffset = static_cast<size_t>(bufferView.getNumber("byteOffset", 0.0));
+			size_t viewLength = static_cast<size_t>(bufferView.getNumber("byteLength", 0.0));
+			size_t accessorOffset = static_cast<size_t>(accessor.getNumber("byteOffset", 0.0));
+			size_t elementSize = static_cast<size_t>(getComponentSize(view.componentType)) * view.componentCount;
+			view.stride = static_cast<size_t>(bufferView.getNumber("byteStride", 0.0));
+			if (view.stride == 0) {
+				view.stride = elementSize;
+			}
+
+			if (viewOffset > buffer.size || viewLength > buffer.size - viewOffset ||
+				accessorOffset > viewLength || elementSize > viewLength - accessorOffset ||
+				view.count - 1 > (viewLength - accessorOffset - elementSize) / view.stride) {
+				throw std::runtime_error("glTF accessor exceeds the bounds of its buffer view");
+			}
+
+			view.data = buffer.data + viewOffset + accessorOffset;
+			return view;
+		}
+
+		float readComponent(const unsigned char* data, uint32_t componentType, bool normalized)
+		{
+			switch (componentType) {
+			case COMPONENT_FLOAT: {
+				float value;
+				std::memcpy(&value, data, sizeof(value));
+				return value;
+			}
+			case COMPONENT_UNSIGNED_BYTE:
+				return normalized ? data[0] / 255.0f : static_cast<float>(data[0]);
+			case COMPONENT_BYTE: {
+				float value = static_cast<float>(static_cast<int8_t>(data[0]));
+				return normalized ? std::max(value / 127.0f, -1.0f) : value;
+			}
+			case COMPONENT_UNSIGNED_SHORT: {
+				uint16_t value;
+				std::memcpy(&value, data, sizeof(value));
+				return normalized ? value / 65535.0f : static_cast<float>(value);
+			}
+			case COMPONENT_SHORT: {
+				int16_t value;
+				std::memcpy(&value, data, sizeof(value));
+				return normalized ? std::max(value / 32767.0f, -1.0f) : static_cast<float>(value);
+			}
+			case COMPONENT_UNSIGNED_INT:
+				return static_cast<float>(readU32(data));
+			default:
+				return 0.0f;
+			}
+		}
+
+		// Reads up to componentCount floats of element i; components missing from the accessor are left untouched
+		void readElement(const AccessorView& view, size_t i, float* out, uint32_t componentCount)
+		{
+			if (view.data == nullptr) return;
+			const unsigned char* element = view.data + i * view.stride;
+			uint32_t componentSize = getComponentSize(view.componentType);
+			uint32_t count = std::min(componentCount, view.componentCount);
+			for (uint32_t c = 0; c < count; ++c) {
+				out[c] = readComponent(element + c * componentSize, view.componentType, view.normalized);
+			}
+		}
+
+		bool isFloatAttribute(const AccessorView& view, uint32_t componentCount, size_t vertexCount)
+		{
+			return view.data != nullptr && view.componentType == COMPONENT_FLOAT && view.componentCount == componentCount &&
+				view.stride == sizeof(Model::Vertex) && view.count == vertexCount;
+		}
+
+		// True when the attributes are already interleaved exactly like Model::Vertex
+		bool matchesVertexLayout(const PrimitiveSource& source)
+		{
+			const unsigned char* base = source.position.data;
+			return isFloatAttribute(source.position, 3, source.vertexCount) &&
+				isFloatAttribute(source.color, 3, source.vertexCount) &&
+				isFloatAttribute(source.normal, 3, source.vertexCount) &&
+				isFloatAttribute(source.texCoords, 2, source.vertexCount) &&
+				offsetof(Model::Vertex, position) == 0 &&
+				source.color.data == base + offsetof(Model::Vertex, color) &&
+				source.normal.data == base + offsetof(Model::Vertex, normal) &&
+				source.texCoords.data == base + offsetof(Model::Vertex, texCoords);
+		}
+
+		void writeVertices(const PrimitiveSource& source, Model::Vertex* dst)
+		{
+			if (matchesVertexLayout(source)) {
+				std::memcpy(dst, source.position.data, source.vertexCount * sizeof(Model::Vertex));
+				return;
+			}
+
+			for (size_t i = 0; i < source.vertexCount; ++i) {
+				Model::Vertex vertex{};
+				vertex.color = { 1.0f, 1.0f, 1.0f };
+				readElement(source.position, i, &vertex.position.x, 3);
+				readElement(source.color, i, &vertex.color.x, 3);
+				readElement(source.normal, i, &vertex.normal.x, 3);
+				readElement(source.texCoords, i, &vertex.texCoords.x, 2);
+				dst[i] = vertex;
+			}
+		}
+
+		uint32_t readIndex(const AccessorView& view, size_t i)
+		{
+			const unsigned char* element = view.data + i * view.stride;
+			switch (view.componentType) {
+			case COMPONENT_UNSIGNED_INT:
+				return readU32(element);
+			case COMPONENT_UNSIGNED_SHORT: {
+				uint16_t index;
+				std::memcpy(&index, element, sizeof(index));
+				return index;
+			}
+			case COMPONENT_UNSIGNED_BYTE:
+				return *element;
+			default:
+				throw std::runtime_error("Unsupported glTF index component type");
+			}
+		}
+
+		// Checked while parsing, before any geometry is allocated, so a bad asset never reaches the arena
+		void validateIndices(const PrimitiveSource& source, const std::string& filePath)
+		{
+			const AccessorView& view = source.indices;
+			if (view.data == nullptr) {
+				return;
+			}
+			uint32_t maxIndex = 0;
+			for (size_t i = 0; i < source.indexCount; ++i) {
+				maxIndex = std::max(maxIndex, readIndex(view, i));
+			}
+			if (maxIndex >= source.vertexCount) {
+				throw std::runtime_error("glTF index exceeds the vertex count of its primitive: " + filePath);
+			}
+		}
+
+		void writeIndices(const PrimitiveSource& source, uint32_t* dst)
+		{
+			const AccessorView& view = source.indices;
+			if (!source.hasIndices) {
+				for (uint32_t i = 0; i < source.indexCount; ++i) {
+					dst[i] = i;
+				}
+				return;
+			}
+			if (view.data == nullptr) {
+				std::memset(dst, 0, source.indexCount * sizeof(uint32_t));
+				return;
+			}
+
+			switch (view.componentType) {
+			case COMPONENT_UNSIGNED_INT:
+				if (view.stride == sizeof(uint32_t)) {
+					std::memcpy(dst, view.data, source.indexCount * sizeof(uint32_t));
+				}
+				else {
+					for (size_t i = 0; i < source.indexCount; ++i) {
+						dst[i] = readU32(view.data + i * view.stride);
+					}
+				}
+				break;
+			case COMPONENT_UNSIGNED_SHORT:
+				for (size_t i = 0; i < source.indexCount; ++i) {
+					uint16_t index;
+					std::memcpy(&index, view.data + i * view.stride, sizeof(index));
+					dst[i] = index;
+				}
+				break;
+			case COMPONENT_UNSIGNED_BYTE:
+				for (size_t i = 0; i < source.indexCount; ++i) {
+					dst[i] = view.data[i * view.stride];
+				}
+				break;
+			default:
+				throw std::runtime_error("Unsupported glTF index component type");
+			}
+		}
+	}
+
+	bool GltfLoader::isGltfFile(const std::string& filePath)
+	{
+		std::string extension = std::filesystem::path(filePath).extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(),
+			[](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		return extension == ".glb" || extension == ".gltf";
+	}
+
+	/**
+	 * Loads all triangle primitives of the asset into one model, with one draw range per primitive.
+	 *
+	 * The file and its buffers are memory mapped and accessor data is written straight into the staging
+	 * buffer: attributes already interleaved like Model::Vertex and 32-bit indices are copied as whole
+	 * blocks, everything else is converted element by element. Indices stay relative to their primitive,
+	 * which is rebased at draw time through the primitive's vertex offset.
+	 */
+	std::unique_ptr<Model> GltfLoader::loadModel(
+		DeviceManager& devManager,
+		GeometryArena& geometryArena,
+		const std::string& filePath
+	)
+	{
+		FileUtils::MappedFile file{ filePath };
+		Document doc = parseDocument(file, filePath);
+
+		std::vector<PrimitiveSource> sources;
+		std::vector<Model::Primitive> primitives;
+		uint64_t totalVertices = 0;
+		uint64_t totalIndices = 0;
+
+		const JsonValue* meshes = doc.json.find("meshes");
+		for (size_t m = 0; m < (meshes ? meshes->getArraySize() : 0); ++m) {
+			const JsonValue* meshPrimitives = meshes->elements[m].find("primitives");
+			for (size_t p = 0; p < (meshPrimitives ? meshPrimitives->getArraySize() : 0); ++p) {
+				const JsonValue& primitive = meshPrimitives->elements[p];
+				const JsonValue* attributes = primitive.find("attributes");
+				if (static_cast<int>(primitive.getNumber("mode", MODE_TRIANGLES)) != MODE_TRIANGLES ||
+					attributes == nullptr || attributes->find("POSITION") == nullptr) {
+					continue;
+				}
+
+				PrimitiveSource source{};
+				source.position = resolveAccessor(doc, attributes->getNumber("POSITION", -1.0));
+				if (attributes->find("COLOR_0") != nullptr) {
+					source.color = resolveAccessor(doc, attributes->getNumber("COLOR_0", -1.0));
+				}
+				if (attributes->find("NORMAL") != nullptr) {
+					source.normal = resolveAccessor(doc, attributes->getNumber("NORMAL", -1.0));
+				}
+				if (attributes->find("TEXCOORD_0") != nullptr) {
+					source.texCoords = resolveAccessor(doc, attributes->getNumber("TEXCOORD_0", -1.0));
+				}
+				source.hasIndices = primitive.find("indices") != nullptr;
+				if (source.hasIndices) {
+					source.indices = resolveAccessor(doc, primitive.getNumber("indices", -1.0));
+				}
+
+				size_t vertexCount = source.position.count;
+				size_t indexCount = source.hasIndices ? source.indices.count : vertexCount;
+				for (const AccessorView* attribute : { &source.color, &source.normal, &source.texCoords }) {
+					if (attribute->data != nullptr && attribute->count < vertexCount) {
+						throw std::runtime_error("glTF vertex attribute has fewer elements than POSITION: " + filePath);
+					}
+				}
+				if (vertexCount == 0 || indexCount == 0) {
+					continue;
+				}
+
+				source.firstVertex = static_cast<uint32_t>(totalVertices);
+				source.firstIndex = static_cast<uint32_t>(totalIndices);
+				totalVertices += vertexCount;
+				totalIndices += indexCount;
+				if (totalVertices > static_cast<uint64_t>(std::numeric_limits<int32_t>::max()) ||
+					totalIndices > std::numeric_limits<uint32_t>::max()) {
+					throw std::runtime_error("glTF asset is too large to load as a single model: " + filePath);
+				}
+				source.vertexCount = static_cast<uint32_t>(vertexCount);
+				source.indexCount = static_cast<uint32_t>(indexCount);
+				validateIndices(source, filePath);
+
+				primitives.push_back({ source.firstIndex, source.indexCount, static_cast<int32_t>(source.firstVertex) });
+				sources.push_back(source);
+			}
+		}
+
+		if (totalVertices < 3) {
+			throw std::runtime_error("glTF asset contains no triangle primitives: " + filePath);
+		}
+
+		return std::make_unique<Model>(
+			devManager,
+			geometryArena,
+			static_cast<uint32_t>(totalVertices),
+			static_cast<uint32_t>(totalIndices),
+			std::move(primitives),
+			[&sources](Model::Vertex* vertices, uint32_t* indices) {
+				for (const auto& source : sources) {
+					writeVertices(source, vertices + source.firstVertex);
+					writeIndices(source, indices + source.firstIndex);
+				}
+			}
+		);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,340 @@
+#include "MemoryAllocator.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <stdexcept>
+
+namespace Vulkan3DEngine
+{
+	MemoryAllocator::MemoryAllocator(VkDevice device, const VkPhysicalDeviceMemoryProperties& memoryProperties)
+		: device{ device }, memoryProperties{ memoryProperties }
+	{
+	}
+
+	MemoryAllocator::~MemoryAllocator()
+	{
+		for (auto& pool : pools) {
+			for (auto& block : pool.blocks) {
+				freeDeviceMemory(block->memory, block->mapped, block->size, pool.memoryTypeIndex);
+			}
+		}
+	}
+
+	/**
+	 * Reserves memory for a resource with the given requirements.
+	 *
+	 * Requests are rounded up to a power of two no smaller than their alignment, so every buddy offset
+	 * already satisfies the alignment. Resources larger than half a block, and those the driver prefers
+	 * or requires to have their own memory, get a dedicated allocation.
+	 * Host visible memory is persistently mapped; the returned mapped pointer stays valid until free.
+	 */
+	MemoryAllocator::Allocation MemoryAllocator::allocate(
+		const VkMemoryRequirements& requirements,
+		uint32_t memoryTypeIndex,
+		ResourceKind kind,
+		Category category,
+		const DedicatedRequest* dedicated
+	)
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+
+		Allocation allocation{};
+		allocation.memoryTypeIndex = memoryTypeIndex;
+		allocation.requestedSize = requirements.size;
+		allocation.kind = kind;
+		allocation.category = category;
+
+		Pool& pool = getPool(memoryTypeIndex, kind);
+		VkDeviceSize roundedSize = std::bit_ceil(std::max({ requirements.size, requirements.alignment, MIN_ALLOCATION_SIZE }));
+
+		// lazily allocated memory is committed per allocation, sharing a block would defeat that
+		if (roundedSize > pool.blockSize / 2 || isLazilyAllocated(memoryTypeIndex) ||
+			(dedicated != nullptr && (dedicated->prefersDedicated || dedicated->requiresDedicated))) {
+			allocation.memory = allocateDeviceMemory(requirements.size, memoryTypeIndex, &allocation.mapped, dedicated);
+			allocation.size = requirements.size;
+			++dedicatedAllocationCount;
+			dedicatedBytes += requirements.size;
+			categoryBytes[static_cast<size_t>(category)] += allocation.size;
+			return allocation;
+		}
+
+		uint32_t order = getOrder(roundedSize);
+		VkDeviceSize offset = 0;
+		Block* block = nullptr;
+		for (auto& candidate : pool.blocks) {
+			if (allocateFromBlock(*candidate, order, offset)) {
+				block = candidate.get();
+				break;
+			}
+		}
+
+		if (block == nullptr) {
+			auto newBlock = std::make_unique<Block>();
+			newBlock->size = pool.blockSize;
+			newBlock->memory = allocateDeviceMemory(pool.blockSize, memoryTypeIndex, &newBlock->mapped);
+			newBlock->freeLists.resize(getOrder(pool.blockSize) + 1);
+			newBlock->freeLists.back().insert(0);
+
+			block = newBlock.get();
+			pool.blocks.push_back(std::move(newBlock));
+			[[maybe_unused]] bool allocated = allocateFromBlock(*block, order, offset);
+			assert(allocated && "Allocation must fit into an empty block");
+		}
+
+		block->allocatedBytes += roundedSize;
+		++block->allocationCount;
+		requestedBytes += requirements.size;
+		categoryBytes[static_cast<size_t>(category)] += roundedSize;
+
+		allocation.memory = block->memory;
+		allocation.offset = offset;
+		allocation.size = roundedSize;
+		allocation.mapped = block->mapped ? static_cast<char*>(block->mapped) + offset : nullptr;
+		allocation.block = block;
+		return allocation;
+	}
+
+	/**
+	 * Returns an allocation to its block, merging free buddies. Empty blocks are released, except for
+	 * the last one of a pool which is kept to avoid reallocating on the next request.
+	 */
+	void MemoryAllocator::free(Allocation& allocation)
+	{
+		if (allocation.memory == VK_NULL_HANDLE) {
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock{ mutex };
+		categoryBytes[static_cast<size_t>(allocation.category)] -= allocation.size;
+
+		if (allocation.block == nullptr) {
+			freeDeviceMemory(allocation.memory, allocation.mapped, allocation.size, allocation.memoryTypeIndex);
+			--dedicatedAllocationCount;
+			dedicatedBytes -= allocation.size;
+			allocation = Allocation{};
+			return;
+		}
+
+		Block& block = *allocation.block;
+		freeToBlock(block, allocation.offset, getOrder(allocation.size));
+		block.allocatedBytes -= allocation.size;
+		--block.allocationCount;
+		requestedBytes -= allocation.requestedSize;
+
+		if (block.allocationCount == 0) {
+			Pool& pool = getPool(allocation.memoryTypeIndex, allocation.kind);
+			size_t emptyBlocks = std::count_if(pool.blocks.begin(), pool.blocks.end(),
+				[](const std::unique_ptr<Block>& b) { return b->allocationCount == 0; });
+			if (emptyBlocks > 1) {
+				freeDeviceMemory(block.memory, block.mapped, block.size, allocation.memoryTypeIndex);
+				pool.blocks.erase(std::find_if(pool.blocks.begin(), pool.blocks.end(),
+					[&block](const std::unique_ptr<Block>& b) { return b.get() == &block; }));
+			}
+		}
+
+		allocation = Allocation{};
+	}
+
+	MemoryAllocator::Statistics MemoryAllocator::getStatistics() const
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+
+		Statistics stats{};
+		stats.dedicatedAllocationCount = dedicatedAllocationCount;
+		stats.dedicatedBytes = dedicatedBytes;
+		stats.requestedBytes = requestedBytes;
+		stats.allocationCount = dedicatedAllocationCount;
+		stats.heapUsage = heapUsage;
+		stats.categoryBytes = categoryBytes;
+
+		VkDeviceSize freeBytes = 0;
+		for (const auto& pool : pools) {
+			for (const auto& block : pool.blocks) {
+				VkDeviceSize largestFree = getLargestFreeRange(*block);
+				stats.blocks.push_back({
+					pool.memoryTypeIndex,
+					pool.kind,
+					block->size,
+					block->allocatedBytes,
+					largestFree,
+					block->allocationCount
+				});
+
+				++stats.blockCount;
+				stats.allocationCount += block->allocationCount;
+				stats.blockBytes += block->size;
+				stats.allocatedBytes += block->allocatedBytes;
+				stats.largestFreeRange = std::max(stats.largestFreeRange, largestFree);
+				freeBytes += block->size - block->allocatedBytes;
+			}
+		}
+
+		if (stats.allocatedBytes > 0) {
+			stats.internalFragmentation = 1.0f - static_cast<float>(stats.requestedBytes) / stats.allocatedBytes;
+		}
+		if (freeBytes > 0) {
+			stats.externalFragmentation = 1.0f - static_cast<float>(stats.largestFreeRange) / freeBytes;
+		}
+		return stats;
+	}
+
+	VkDeviceSize MemoryAllocator::getHeapUsage(uint32_t heapIndex) const
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		return heapUsage[heapIndex];
+	}
+
+	const char* MemoryAllocator::getCategoryName(Category category)
+	{
+		switch (category) {
+		case Category::Mesh:
+			return "Meshes";
+		case Category::Texture:
+			return "Textures";
+		case Category::Uniform:
+			return "Uniform buffers";
+		case Category::Depth:
+			return "Depth";
+		case Category::Staging:
+			return "Staging";
+		default:
+			return "Other";
+		}
+	}
+
+	MemoryAllocator::Pool& MemoryAllocator::getPool(uint32_t memoryTypeIndex, ResourceKind kind)
+	{
+		for (auto& pool : pools) {
+			if (pool.memoryTypeIndex == memoryTypeIndex && pool.kind == kind) {
+				return pool;
+			}
+		}
+		pools.push_back({ memoryTypeIndex, kind, getBlockSize(memoryTypeIndex), {} });
+		return pools.back();
+	}
+
+	VkDeviceSize MemoryAllocator::getBlockSize(uint32_t memoryTypeIndex) const
+	{
+		VkDeviceSize heapSize = memoryProperties.memoryHeaps[getHeapIndex(memoryTypeIndex)].size;
+		if (heapSize <= SMALL_HEAP_SIZE) {
+			return std::max(std::bit_floor(heapSize / 8), MIN_ALLOCATION_SIZE);
+		}
+		return DEFAULT_BLOCK_SIZE;
+	}
+
+	bool MemoryAllocator::isHostVisible(uint32_t memoryTypeIndex) const
+	{
+		return memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+	}
+
+	bool MemoryAllocator::isLazilyAllocated(uint32_t memoryTypeIndex) const
+	{
+		return memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+	}
+
+	uint32_t MemoryAllocator::getHeapIndex(uint32_t memoryTypeIndex) const
+	{
+		return memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+	}
+
+	VkDeviceMemory MemoryAllocator::allocateDeviceMemory(
+		VkDeviceSize size,
+		uint32_t memoryTypeIndex,
+		void** mapped,
+		const DedicatedRequest* dedicated
+	)
+	{
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = size;
+		allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+		// tells the driver which resource the memory is for, so it can place it as it would its own
+		VkMemoryDedicatedAllocateInfo dedicatedInfo{};
+		if (dedicated != nullptr && (dedicated->buffer != VK_NULL_HANDLE || dedicated->image != VK_NULL_HANDLE)) {
+			dedicatedInfo.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+			dedicatedInfo.buffer = dedicated->buffer;
+			dedicatedInfo.image = dedicated->image;
+			allocInfo.pNext = &dedicatedInfo;
+		}
+
+		VkDeviceMemory memory;
+		if (vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to allocate device memory");
+		}
+
+		*mapped = nullptr;
+		if (isHostVisible(memoryTypeIndex) && vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, mapped) != VK_SUCCESS) {
+			vkFreeMemory(device, memory, nullptr);
+			throw std::runtime_error("Failed to map device memory");
+		}
+		heapUsage[getHeapIndex(memoryTypeIndex)] += size;
+		return memory;
+	}
+
+	void MemoryAllocator::freeDeviceMemory(VkDeviceMemory memory, void* mapped, VkDeviceSize size, uint32_t memoryTypeIndex)
+	{
+		if (mapped != nullptr) {
+			vkUnmapMemory(device, memory);
+		}
+		vkFreeMemory(device, memory, nullptr);
+		heapUsage[getHeapIndex(memoryTypeIndex)] -= size;
+	}
+
+	bool MemoryAllocator::allocateFromBlock(Block& block, uint32_t order, VkDeviceSize& offset)
+	{
+		uint32_t current = order;
+		while (current < block.freeLists.size() && block.freeLists[current].empty()) {
+			++current;
+		}
+		if (current >= block.freeLists.size()) {
+			return false;
+		}
+
+		// Take the lowest free offset and split it down, releasing the upper halves
+		auto it = block.freeLists[current].begin();
+		offset = *it;
+		block.freeLists[current].erase(it);
+		while (current > order) {
+			--current;
+			block.freeLists[current].insert(offset + getOrderSize(current));
+		}
+		return true;
+	}
+
+	void MemoryAllocator::freeToBlock(Block& block, VkDeviceSize offset, uint32_t order)
+	{
+		while (order + 1 < block.freeLists.size()) {
+			VkDeviceSize buddy = offset ^ getOrderSize(order);
+			auto it = block.freeLists[order].find(buddy);
+			if (it == block.freeLists[order].end()) {
+				break;
+			}
+			block.freeLists[order].erase(it);
+			offset = std::min(offset, buddy);
+			++order;
+		}
+		block.freeLists[order].insert(offset);
+	}
+
+	uint32_t MemoryAllocator::getOrder(VkDeviceSize size)
+	{
+		return static_cast<uint32_t>(std::countr_zero(size / MIN_ALLOCATION_SIZE));
+	}
+
+	VkDeviceSize MemoryAllocator::getOrderSize(uint32_t order)
+	{
+		return MIN_ALLOCATION_SIZE << order;
+	}
+
+	VkDeviceSize MemoryAllocator::getLargestFreeRange(const Block& block)
+	{
+		for (size_t order = block.freeLists.size(); order-- > 0;) {
+			if (!block.freeLists[order].empty()) {
+				return getOrderSize(static_cast<uint32_t>(order));
+			}
+		}
+		return 0;
+	}
+}
\ No newline at end of file
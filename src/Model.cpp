@@ -1,5 +1,6 @@
 #include "Model.h"
 
+#include "GltfLoader.h"
 #include "HashUtils.h"
 
 #define TINYOBJLOADER_IMPLEMENTATION
@@ -10,6 +11,7 @@
 
 #include <cassert>
 #include <cstring>
+#include <numeric>
 #include <unordered_map>
 
 namespace std
@@ -115,105 +117,172 @@ namespace Vulkan3DEngine
 		}
 	}
 
-	std::unique_ptr<Model> Model::createModelFromFile(DeviceManager& devManager, const std::string& filePath)
+	std::unique_ptr<Model> Model::createModelFromFile(
+		DeviceManager& devManager,
+		GeometryArena& geometryArena,
+		const std::string& filePath
+	)
 	{
+		if (GltfLoader::isGltfFile(filePath)) {
+			return GltfLoader::loadModel(devManager, geometryArena, filePath);
+		}
+
 		Data modelData{};
 		modelData.load(filePath);
-		return std::make_unique<Model>(devManager, modelData);
+		return std::make_unique<Model>(devManager, geometryArena, modelData);
 	}
 
-	Model::Model(DeviceManager& deviceManager, const Model::Data& modelData) : deviceManager{ deviceManager }
+	// Models without indices get a sequential index list so every draw can be indexed
+	static uint32_t getIndexCount(const Model::Data& modelData)
 	{
-		createVertexBuffers(modelData.vertices);
-		createIndexBuffer(modelData.indices);
+		return static_cast<uint32_t>(modelData.indices.empty() ? modelData.vertices.size() : modelData.indices.size());
 	}
 
-	Model::~Model()
+	Model::Model(DeviceManager& deviceManager, GeometryArena& geometryArena, const Model::Data& modelData)
+		: Model(
+			deviceManager,
+			geometryArena,
+			static_cast<uint32_t>(modelData.vertices.size()),
+			getIndexCount(modelData),
+			{ Primitive{ 0, getIndexCount(modelData), 0 } },
+			[&modelData](Vertex* vertices, uint32_t* indices) {
+				std::memcpy(vertices, modelData.vertices.data(), modelData.vertices.size() * sizeof(Vertex));
+				if (modelData.indices.empty()) {
+					std::iota(indices, indices + modelData.vertices.size(), 0u);
+				}
+				else {
+					std::memcpy(indices, modelData.indices.data(), modelData.indices.size() * sizeof(uint32_t));
+				}
+			}
+		)
 	{
 	}
 
-	void Model::bind(VkCommandBuffer commandBuffer)
+	Model::Model(
+		DeviceManager& deviceManager,
+		GeometryArena& geometryArena,
+		uint32_t vertexCount,
+		uint32_t indexCount,
+		std::vector<Primitive> primitives,
+		const StagingWriter& writeStaging
+	) : deviceManager{ deviceManager }, geometryArena{ geometryArena }, primitives{ std::move(primitives) }
 	{
-		VkBuffer buffers[] = { vertBufferManager->getBuffer()};
-		VkDeviceSize offsets[] = { 0 };
-		vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+		assert(vertexCount >= 3 && "Vertex count must be at least 3");
+		assert(indexCount > 0 && "Models are always drawn indexed");
 
-		if (hasIndexBuffer) {
-			vkCmdBindIndexBuffer(commandBuffer, idxBufferManager->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+		vertexRange = geometryArena.allocateVertices(vertexCount);
+		try {
+			indexRange = geometryArena.allocateIndices(indexCount);
+		}
+		catch (...) {
+			geometryArena.freeVertices(vertexRange);
+			throw;
+		}
+		// The destructor does not run for a throwing constructor, so the ranges are handed back here
+		try {
+			upload(writeStaging);
+		}
+		catch (...) {
+			geometryArena.freeVertices(vertexRange);
+			geometryArena.freeIndices(indexRange);
+			throw;
 		}
 	}
 
-	void Model::draw(VkCommandBuffer commandBuffer)
+	Model::~Model()
 	{
-		if (hasIndexBuffer) {
-			vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
-		}
-		else {
-			vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
+		// The copies into the arena must finish before the ranges can be handed out again
+		if (!uploaded) {
+			deviceManager.getUploadBatcher().wait(uploadTicket);
 		}
+		geometryArena.freeVertices(vertexRange);
+		geometryArena.freeIndices(indexRange);
 	}
 
-	void Model::createVertexBuffers(const std::vector<Vertex>& vertices)
+	void Model::bind(VkCommandBuffer commandBuffer)
 	{
-		vertexCount = static_cast<uint32_t>(vertices.size());
-		assert(vertexCount >= 3 && "Vertex count must be at least 3");
-		uint32_t sizeOfVertex = sizeof(vertices[0]);
+		geometryArena.bind(commandBuffer);
+	}
 
-		BufferManager stagingBufferManager{
-			deviceManager,
-			sizeOfVertex,
-			vertexCount,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-		};
+	void Model::draw(VkCommandBuffer commandBuffer, uint32_t firstInstance)
+	{
+		for (const auto& primitive : primitives) {
+			vkCmdDrawIndexed(
+				commandBuffer,
+				primitive.indexCount,
+				1,
+				indexRange.offset + primitive.firstIndex,
+				static_cast<int32_t>(vertexRange.offset) + primitive.vertexOffset,
+				firstInstance
+			);
+		}
+	}
 
-		stagingBufferManager.map();
-		stagingBufferManager.writeToBuffer((void*)vertices.data());
+	void Model::appendDrawCommands(std::vector<VkDrawIndexedIndirectCommand>& commands, uint32_t firstInstance) const
+	{
+		for (const auto& primitive : primitives) {
+			VkDrawIndexedIndirectCommand command{};
+			command.indexCount = primitive.indexCount;
+			command.instanceCount = 1;
+			command.firstIndex = indexRange.offset + primitive.firstIndex;
+			command.vertexOffset = static_cast<int32_t>(vertexRange.offset) + primitive.vertexOffset;
+			command.firstInstance = firstInstance;
+			commands.push_back(command);
+		}
+	}
 
-		vertBufferManager = std::make_unique<BufferManager>(
-			deviceManager,
-			sizeOfVertex,
-			vertexCount,
-			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-		);
+	bool Model::isReady() const
+	{
+		if (!uploaded) {
+			uploaded = deviceManager.getUploadBatcher().isComplete(uploadTicket);
+		}
+		return uploaded;
+	}
 
-		VkDeviceSize bufferSize = sizeOfVertex * vertexCount;
-		deviceManager.copyBuffer(stagingBufferManager.getBuffer(), vertBufferManager->getBuffer(), bufferSize);
+	VkDeviceSize Model::getDeviceMemorySize() const
+	{
+		return sizeof(Vertex) * static_cast<VkDeviceSize>(vertexRange.count) +
+			sizeof(uint32_t) * static_cast<VkDeviceSize>(indexRange.count);
 	}
 
-	void Model::createIndexBuffer(const std::vector<uint32_t>& indices)
+	const std::vector<Model::Primitive>& Model::getPrimitives() const
 	{
-		indexCount = static_cast<uint32_t>(indices.size());
-		
-		hasIndexBuffer = indexCount > 0;
-		if (!hasIndexBuffer) {
-			return;
-		}
+		return primitives;
+	}
 
-		uint32_t sizeOfIndex = sizeof(indices[0]);
-		VkDeviceSize bufferSize = sizeOfIndex * indexCount;
+	/**
+	 * Queues the upload of vertices and indices into the model's arena ranges through one region of
+	 * the device staging ring.
+	 * 
+	 * The staging memory is handed to the writer while mapped, so loaders can fill it directly from
+	 * their source data instead of building intermediate vectors first. The copies are submitted with
+	 * the next upload batch; isReady reports when they have finished.
+	 */
+	void Model::upload(const StagingWriter& writeStaging)
+	{
+		VkDeviceSize vertexBytes = sizeof(Vertex) * static_cast<VkDeviceSize>(vertexRange.count);
+		VkDeviceSize indexBytes = sizeof(uint32_t) * static_cast<VkDeviceSize>(indexRange.count);
 
-		BufferManager stagingBufferManager{
-			deviceManager,
-			sizeOfIndex,
-			indexCount,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-		};
+		UploadBatcher& uploadBatcher = deviceManager.getUploadBatcher();
+		StagingRing::Region staging = uploadBatcher.allocateStaging(vertexBytes + indexBytes, alignof(Vertex));
 
-		stagingBufferManager.map();
-		stagingBufferManager.writeToBuffer((void*)indices.data());
+		auto stagingMemory = static_cast<char*>(staging.mapped);
+		writeStaging(reinterpret_cast<Vertex*>(stagingMemory), reinterpret_cast<uint32_t*>(stagingMemory + vertexBytes));
 
-		idxBufferManager = std::make_unique<BufferManager>(
-			deviceManager,
-			sizeOfIndex,
-			indexCount,
-			VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+		uploadBatcher.copyBuffer(
+			staging.buffer,
+			geometryArena.getVertexBuffer(),
+			vertexBytes,
+			staging.offset,
+			sizeof(Vertex) * static_cast<VkDeviceSize>(vertexRange.offset)
+		);
+		uploadTicket = uploadBatcher.copyBuffer(
+			staging.buffer,
+			geometryArena.getIndexBuffer(),
+			indexBytes,
+			staging.offset + vertexBytes,
+			sizeof(uint32_t) * static_cast<VkDeviceSize>(indexRange.offset)
 		);
-
-		deviceManager.copyBuffer(stagingBufferManager.getBuffer(), idxBufferManager->getBuffer(), bufferSize);
 	}
 	
 }
\ No newline at end of file
@@ -0,0 +1,216 @@
+#include "ModelRegistry.h"
+
+#include "Constants.h"
+#include "FileUtils.h"
+#include "HashUtils.h"
+
+#include <algorithm>
+#include <filesystem>
+
+namespace Vulkan3DEngine
+{
+	ModelRegistry::ModelRegistry(DeviceManager& devManager, GeometryArena& geometryArena, DeferredDeletionQueue& deletionQueue)
+		: devManager{ devManager }, geometryArena{ geometryArena }, deletionQueue{ deletionQueue }
+	{
+		// fragmentation makes the arena run out before all of its capacity is used
+		GeometryArena::Statistics arenaStats = geometryArena.getStatistics();
+		VkDeviceSize capacity = arenaStats.vertexCapacity * sizeof(Model::Vertex) + arenaStats.indexCapacity * sizeof(uint32_t);
+		residentBudget = static_cast<VkDeviceSize>(static_cast<double>(capacity) * AppConstants::MODEL_RESIDENT_BUDGET_FRACTION);
+		cacheBudget = static_cast<VkDeviceSize>(static_cast<double>(capacity) * AppConstants::MODEL_CACHE_BUDGET_FRACTION);
+	}
+
+	ModelRegistry::~ModelRegistry()
+	{
+	}
+
+	/**
+	 * Returns a shared handle to the model stored at filePath, loading it only if it is not resident.
+	 *
+	 * Lookups go by normalized path first; on a miss the file contents are hashed so that identical
+	 * files stored under different paths still share a single GPU copy. Models stay resident after the
+	 * last handle is released, until enforceBudget evicts them or a load needs their space.
+	 */
+	std::shared_ptr<Model> ModelRegistry::acquire(const std::string& filePath)
+	{
+		std::string key = normalizePath(filePath);
+
+		auto pathIt = pathToHash.find(key);
+		if (pathIt != pathToHash.end()) {
+			auto entryIt = entries.find(pathIt->second);
+			if (entryIt != entries.end()) {
+				++cacheHitCount;
+				entryIt->second.lastUsed = currentTick;
+				return entryIt->second.model;
+			}
+			pathToHash.erase(pathIt);
+		}
+
+		auto fileBytes = FileUtils::readBinaryFile(filePath);
+		uint64_t contentHash = HashUtils::hashBytes(fileBytes.data(), fileBytes.size());
+		pathToHash[key] = contentHash;
+
+		auto entryIt = entries.find(contentHash);
+		if (entryIt != entries.end()) {
+			++cacheHitCount;
+			entryIt->second.lastUsed = currentTick;
+			return entryIt->second.model;
+		}
+
+		std::shared_ptr<Model> model;
+		while (!model) {
+			try {
+				model = Model::createModelFromFile(devManager, geometryArena, filePath);
+			}
+			catch (const GeometryArena::OutOfSpaceError&) {
+				// evicted ranges are only reused once no frame can draw from them, so wait for the device
+				// instead of frames going by; loading is a stall anyway
+				if (!evictLeastRecentlyUsed()) {
+					throw;
+				}
+				vkDeviceWaitIdle(devManager.getDeviceHandle());
+				deletionQueue.flush();
+			}
+		}
+		++loadCount;
+
+		Entry& entry = entries[contentHash];
+		entry.model = model;
+		entry.path = key;
+		entry.deviceMemorySize = model->getDeviceMemorySize();
+		entry.lastUsed = currentTick;
+		return model;
+	}
+
+	/**
+	 * Call once per frame. Models still referenced are marked as used in this frame; if the resident
+	 * models exceed the resident budget or the unreferenced ones the cache budget, unreferenced models
+	 * are evicted in least recently used order until both fit.
+	 */
+	void ModelRegistry::enforceBudget()
+	{
+		++currentTick;
+
+		VkDeviceSize residentBytes = 0;
+		VkDeviceSize cachedBytes = 0;
+		std::vector<std::pair<uint64_t, uint64_t>> candidates;	// (lastUsed, content hash)
+		for (auto& kv : entries) {
+			residentBytes += kv.second.deviceMemorySize;
+			if (isReferenced(kv.second)) {
+				kv.second.lastUsed = currentTick;
+			}
+			else {
+				cachedBytes += kv.second.deviceMemorySize;
+				candidates.push_back({ kv.second.lastUsed, kv.first });
+			}
+		}
+		if (residentBytes <= residentBudget && cachedBytes <= cacheBudget) {
+			return;
+		}
+
+		std::sort(candidates.begin(), candidates.end());
+		for (const auto& candidate : candidates) {
+			if (residentBytes <= residentBudget && cachedBytes <= cacheBudget) break;
+			VkDeviceSize size = entries.at(candidate.second).deviceMemorySize;
+			residentBytes -= size;
+			cachedBytes -= size;
+			evict(candidate.second);
+		}
+	}
+
+	void ModelRegistry::setResidentBudget(VkDeviceSize budget)
+	{
+		residentBudget = budget;
+	}
+
+	void ModelRegistry::setCacheBudget(VkDeviceSize budget)
+	{
+		cacheBudget = budget;
+	}
+
+	ModelRegistry::Statistics ModelRegistry::getStatistics() const
+	{
+		Statistics stats{};
+		stats.loads = loadCount;
+		stats.cacheHits = cacheHitCount;
+		stats.evictions = evictionCount;
+		stats.residentBudget = residentBudget;
+		stats.cacheBudget = cacheBudget;
+		for (const auto& kv : entries) {
+			if (isReferenced(kv.second)) {
+				++stats.loadedAssets;
+			}
+			else {
+				++stats.cachedAssets;
+				stats.cachedMemorySize += kv.second.deviceMemorySize;
+			}
+			stats.deviceMemorySize += kv.second.deviceMemorySize;
+		}
+		return stats;
+	}
+
+	std::vector<ModelRegistry::AssetInfo> ModelRegistry::getLoadedAssets() const
+	{
+		std::vector<AssetInfo> assets;
+		for (const auto& kv : entries) {
+			assets.push_back({
+				kv.second.path,
+				kv.first,
+				kv.second.deviceMemorySize,
+				kv.second.model.use_count() - 1,
+				kv.second.lastUsed
+			});
+		}
+		return assets;
+	}
+
+	/**
+	 * Drops the registry's reference; the model's geometry ranges go back to the arena once frames still
+	 * in flight are done with them
+	 */
+	void ModelRegistry::evict(uint64_t contentHash)
+	{
+		entries.erase(contentHash);
+		for (auto it = pathToHash.begin(); it != pathToHash.end();) {
+			if (it->second == contentHash) {
+				it = pathToHash.erase(it);
+			}
+			else {
+				++it;
+			}
+		}
+		++evictionCount;
+	}
+
+	/**
+	 * Evicts the unreferenced model used longest ago; false if every model is still referenced
+	 */
+	bool ModelRegistry::evictLeastRecentlyUsed()
+	{
+		auto oldest = entries.end();
+		for (auto it = entries.begin(); it != entries.end(); ++it) {
+			if (!isReferenced(it->second) && (oldest == entries.end() || it->second.lastUsed < oldest->second.lastUsed)) {
+				oldest = it;
+			}
+		}
+		if (oldest == entries.end()) {
+			return false;
+		}
+		evict(oldest->first);
+		return true;
+	}
+
+	bool ModelRegistry::isReferenced(const Entry& entry)
+	{
+		return entry.model.use_count() > 1;
+	}
+
+	std::string ModelRegistry::normalizePath(const std::string& filePath)
+	{
+		std::error_code ec;
+		auto canonical = std::filesystem::weakly_canonical(std::filesystem::path(filePath), ec);
+		if (ec) {
+			return std::filesystem::path(filePath).lexically_normal().generic_string();
+		}
+		return canonical.generic_string();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,283 @@
+#include "OffscreenTarget.h"
+
+#include <array>
+#include <limits>
+#include <stdexcept>
+
+namespace Vulkan3DEngine
+{
+	OffscreenTarget::OffscreenTarget(DeviceManager& devManager, VkExtent2D extent, int framesInFlight)
+		: devManager{ devManager }, extent{ extent }
+	{
+		depthFormat = devManager.findSupportedFormat(
+			{ VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT },
+			VK_IMAGE_TILING_OPTIMAL,
+			VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT
+		);
+
+		createImages(framesInFlight);
+		createRenderPass();
+		createSyncObjects(framesInFlight);
+	}
+
+	OffscreenTarget::~OffscreenTarget()
+	{
+		VkDevice device = devManager.getDeviceHandle();
+
+		for (auto fence : inFlightFences) {
+			vkDestroyFence(device, fence, nullptr);
+		}
+		vkDestroyRenderPass(device, renderPass, nullptr);
+
+		for (size_t i = 0; i < colorImages.size(); ++i) {
+			vkDestroyImageView(device, colorImageViews[i], nullptr);
+			devManager.destroyImage(colorImages[i], colorImageAllocations[i]);
+			vkDestroyImageView(device, depthImageViews[i], nullptr);
+			devManager.destroyImage(depthImages[i], depthImageAllocations[i]);
+		}
+	}
+
+	VkRenderPass OffscreenTarget::getRenderPass()
+	{
+		return renderPass;
+	}
+
+	VkImage OffscreenTarget::getImage(int index)
+	{
+		return colorImages[index];
+	}
+
+	VkImageView OffscreenTarget::getImageView(int index)
+	{
+		return colorImageViews[index];
+	}
+
+	VkImage OffscreenTarget::getDepthImage(int frameIndex)
+	{
+		return depthImages[frameIndex];
+	}
+
+	VkImageView OffscreenTarget::getDepthImageView(int frameIndex)
+	{
+		return depthImageViews[frameIndex];
+	}
+
+	size_t OffscreenTarget::getImageCount()
+	{
+		return colorImages.size();
+	}
+
+	VkFormat OffscreenTarget::getSwapChainImageFormat()
+	{
+		return COLOR_FORMAT;
+	}
+
+	VkFormat OffscreenTarget::getSwapChainDepthFormat()
+	{
+		return depthFormat;
+	}
+
+	VkExtent2D OffscreenTarget::getSwapChainExtent()
+	{
+		return extent;
+	}
+
+	float OffscreenTarget::extentAspectRatio()
+	{
+		return static_cast<float>(extent.width) / static_cast<float>(extent.height);
+	}
+
+	VkImageLayout OffscreenTarget::getOutputLayout()
+	{
+		return VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	}
+
+	bool OffscreenTarget::supportsReadback()
+	{
+		return true;
+	}
+
+	/**
+	 * Every frame in flight renders into its own image, so once the frame's fence has signaled the image
+	 * is free again
+	 */
+	VkResult OffscreenTarget::acquireNextImage(uint32_t* imageIndex)
+	{
+		VkResult result = vkWaitForFences(
+			devManager.getDeviceHandle(),
+			1,
+			&inFlightFences[currentFrame],
+			VK_TRUE,
+			std::numeric_limits<uint64_t>::max()
+		);
+		*imageIndex = currentFrame;
+		return result;
+	}
+
+	VkResult OffscreenTarget::submitCommandBuffers(
+		const VkCommandBuffer* buffers,
+		uint32_t* imageIndex,
+		const std::vector<VkSemaphore>& uploadSemaphores
+	)
+	{
+		std::vector<VkPipelineStageFlags> waitStages(uploadSemaphores.size(), VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.waitSemaphoreCount = static_cast<uint32_t>(uploadSemaphores.size());
+		submitInfo.pWaitSemaphores = uploadSemaphores.data();
+		submitInfo.pWaitDstStageMask = waitStages.data();
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = buffers;
+
+		vkResetFences(devManager.getDeviceHandle(), 1, &inFlightFences[*imageIndex]);
+		VkResult result = vkQueueSubmit(devManager.getGraphicsQueueHandle(), 1, &submitInfo, inFlightFences[*imageIndex]);
+		if (result != VK_SUCCESS) {
+			throw std::runtime_error("Failed to submit draw command buffer");
+		}
+
+		currentFrame = (currentFrame + 1) % static_cast<uint32_t>(inFlightFences.size());
+		return result;
+	}
+
+	void OffscreenTarget::createImages(int count)
+	{
+		colorImages.resize(count);
+		colorImageAllocations.resize(count);
+		colorImageViews.resize(count);
+		depthImages.resize(count);
+		depthImageAllocations.resize(count);
+		depthImageViews.resize(count);
+
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.extent = { extent.width, extent.height, 1 };
+		imageInfo.mipLevels = 1;
+		imageInfo.arrayLayers = 1;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		for (int i = 0; i < count; ++i) {
+			imageInfo.format = COLOR_FORMAT;
+			imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+			devManager.createImageWithInfo(
+				imageInfo,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+				colorImages[i],
+				colorImageAllocations[i],
+				MemoryAllocator::Category::Other
+			);
+			colorImageViews[i] = createImageView(colorImages[i], COLOR_FORMAT, VK_IMAGE_ASPECT_COLOR_BIT);
+
+			imageInfo.format = depthFormat;
+			// depth is cleared on load and never stored, tile based GPUs can keep it in tile memory
+			imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+			devManager.createImageWithInfo(
+				imageInfo,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+				depthImages[i],
+				depthImageAllocations[i],
+				MemoryAllocator::Category::Depth,
+				VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT
+			);
+			depthImageViews[i] = createImageView(depthImages[i], depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
+		}
+	}
+
+	/**
+	 * Same attachments as the swap chain's render pass, so pipelines built against either are compatible
+	 * with the passes the frame graph creates. Nothing records with it, the graph makes its own framebuffers.
+	 */
+	void OffscreenTarget::createRenderPass()
+	{
+		VkAttachmentDescription colorAttachment{};
+		colorAttachment.format = COLOR_FORMAT;
+		colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+		colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		colorAttachment.finalLayout = getOutputLayout();
+
+		VkAttachmentDescription depthAttachment{};
+		depthAttachment.format = depthFormat;
+		depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+		depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+		VkAttachmentReference colorAttachmentRef{ 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+		VkAttachmentReference depthAttachmentRef{ 1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+
+		VkSubpassDescription subpass{};
+		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpass.colorAttachmentCount = 1;
+		subpass.pColorAttachments = &colorAttachmentRef;
+		subpass.pDepthStencilAttachment = &depthAttachmentRef;
+
+		VkSubpassDependency dependency{};
+		dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+		// only for compatibility, the frame graph records the barriers of the passes it creates
+		dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+			VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		dependency.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		dependency.dstSubpass = 0;
+		dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+			VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+		std::array<VkAttachmentDescription, 2> attachments = { colorAttachment, depthAttachment };
+		VkRenderPassCreateInfo renderPassInfo{};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+		renderPassInfo.pAttachments = attachments.data();
+		renderPassInfo.subpassCount = 1;
+		renderPassInfo.pSubpasses = &subpass;
+		renderPassInfo.dependencyCount = 1;
+		renderPassInfo.pDependencies = &dependency;
+
+		if (vkCreateRenderPass(devManager.getDeviceHandle(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create offscreen render pass");
+		}
+	}
+
+	void OffscreenTarget::createSyncObjects(int count)
+	{
+		VkFenceCreateInfo fenceInfo{};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+		inFlightFences.resize(count);
+		for (auto& fence : inFlightFences) {
+			if (vkCreateFence(devManager.getDeviceHandle(), &fenceInfo, nullptr, &fence) != VK_SUCCESS) {
+				throw std::runtime_error("Failed to create synchronization objects");
+			}
+		}
+	}
+
+	VkImageView OffscreenTarget::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectMask)
+	{
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = format;
+		viewInfo.subresourceRange.aspectMask = aspectMask;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.layerCount = 1;
+
+		VkImageView imageView;
+		if (vkCreateImageView(devManager.getDeviceHandle(), &viewInfo, nullptr, &imageView) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create offscreen image view");
+		}
+		return imageView;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,183 @@
+#include "ParallelCommandRecorder.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace Vulkan3DEngine
+{
+	ParallelCommandRecorder::ParallelCommandRecorder(DeviceManager& devManager, ThreadPool& threadPool, int frameCount)
+		: devManager{ devManager }, threadPool{ threadPool }
+	{
+		// one slot per worker plus one for the calling thread
+		size_t slotCount = threadPool.getThreadCount() + 1;
+
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = devManager.getQueueFamilies().graphicsFamily.value();
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;	// reset as a whole every frame
+
+		frameSlots.resize(frameCount);
+		for (auto& slots : frameSlots) {
+			slots.resize(slotCount);
+			for (auto& slot : slots) {
+				if (vkCreateCommandPool(devManager.getDeviceHandle(), &poolInfo, nullptr, &slot.commandPool) != VK_SUCCESS) {
+					throw std::runtime_error("Failed to create secondary command pool");
+				}
+			}
+		}
+	}
+
+	ParallelCommandRecorder::~ParallelCommandRecorder()
+	{
+		for (auto& slots : frameSlots) {
+			for (auto& slot : slots) {
+				vkDestroyCommandPool(devManager.getDeviceHandle(), slot.commandPool, nullptr);
+			}
+		}
+	}
+
+	/**
+	 * Recycles the frame's command buffers; call after the frame's in-flight fence has been waited on
+	 */
+	void ParallelCommandRecorder::beginFrame(int frameIndex, VkRenderPass renderPass, VkFramebuffer framebuffer, VkExtent2D extent)
+	{
+		currentFrame = frameIndex;
+		for (auto& slot : frameSlots[currentFrame]) {
+			if (slot.usedCount == 0) continue;
+			if (vkResetCommandPool(devManager.getDeviceHandle(), slot.commandPool, 0) != VK_SUCCESS) {
+				throw std::runtime_error("Failed to reset secondary command pool");
+			}
+			slot.usedCount = 0;
+		}
+
+		inheritanceInfo = {};
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.renderPass = renderPass;
+		inheritanceInfo.subpass = 0;
+		inheritanceInfo.framebuffer = framebuffer;
+		this->extent = extent;
+		recordedBuffers.clear();
+	}
+
+	/**
+	 * Splits itemCount items into chunks of at least minItemsPerChunk and records them concurrently,
+	 * returning once all chunks are recorded. The calling thread records chunks too, so a busy pool only
+	 * slows recording down instead of blocking it.
+	 */
+	void ParallelCommandRecorder::record(size_t itemCount, const RecordFunction& recordChunk, size_t minItemsPerChunk)
+	{
+		if (itemCount == 0) return;
+
+		size_t slotCount = frameSlots[currentFrame].size();
+		size_t chunkCount = std::clamp<size_t>((itemCount + minItemsPerChunk - 1) / minItemsPerChunk, 1, slotCount);
+		size_t itemsPerChunk = (itemCount + chunkCount - 1) / chunkCount;
+		chunkCount = (itemCount + itemsPerChunk - 1) / itemsPerChunk;
+
+		// buffers are allocated here so a worker only ever records into its chunk's buffer
+		auto job = std::make_shared<Job>();
+		job->inheritanceInfo = inheritanceInfo;
+		job->extent = extent;
+		for (size_t chunk = 0; chunk < chunkCount; ++chunk) {
+			job->commandBuffers.push_back(acquireCommandBuffer(chunk));
+		}
+		recordedBuffers.insert(recordedBuffers.end(), job->commandBuffers.begin(), job->commandBuffers.end());
+
+		// helpers starting after every chunk is claimed return without touching anything but the job,
+		// which they keep alive
+		for (size_t helper = 1; helper < chunkCount; ++helper) {
+			threadPool.submit([job, itemCount, itemsPerChunk, &recordChunk]() {
+				recordChunks(*job, itemCount, itemsPerChunk, recordChunk);
+			});
+		}
+		recordChunks(*job, itemCount, itemsPerChunk, recordChunk);
+
+		std::unique_lock<std::mutex> lock{ job->mutex };
+		job->finished.wait(lock, [&job, chunkCount]() { return job->completedChunks == chunkCount; });
+		if (job->error) {
+			std::rethrow_exception(job->error);
+		}
+	}
+
+	void ParallelCommandRecorder::execute(VkCommandBuffer primaryCommandBuffer)
+	{
+		if (recordedBuffers.empty()) return;
+		vkCmdExecuteCommands(
+			primaryCommandBuffer,
+			static_cast<uint32_t>(recordedBuffers.size()),
+			recordedBuffers.data()
+		);
+	}
+
+	size_t ParallelCommandRecorder::getSlotCount() const
+	{
+		return frameSlots[currentFrame].size();
+	}
+
+	VkCommandBuffer ParallelCommandRecorder::acquireCommandBuffer(size_t slotIndex)
+	{
+		auto& slot = frameSlots[currentFrame][slotIndex];
+		if (slot.usedCount == slot.commandBuffers.size()) {
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			allocInfo.commandPool = slot.commandPool;
+			allocInfo.commandBufferCount = 1;
+
+			VkCommandBuffer commandBuffer;
+			if (vkAllocateCommandBuffers(devManager.getDeviceHandle(), &allocInfo, &commandBuffer) != VK_SUCCESS) {
+				throw std::runtime_error("Failed to allocate secondary command buffer");
+			}
+			slot.commandBuffers.push_back(commandBuffer);
+		}
+		return slot.commandBuffers[slot.usedCount++];
+	}
+
+	void ParallelCommandRecorder::recordChunks(
+		Job& job,
+		size_t itemCount,
+		size_t itemsPerChunk,
+		const RecordFunction& recordChunk
+	)
+	{
+		size_t chunkCount = job.commandBuffers.size();
+		size_t chunk;
+		while ((chunk = job.nextChunk++) < chunkCount) {
+			try {
+				VkCommandBuffer commandBuffer = job.commandBuffers[chunk];
+
+				VkCommandBufferBeginInfo beginInfo{};
+				beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+				beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+				beginInfo.pInheritanceInfo = &job.inheritanceInfo;
+				if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+					throw std::runtime_error("Failed to begin recording secondary command buffer");
+				}
+
+				// dynamic state is not inherited from the primary command buffer
+				VkExtent2D extent = job.extent;
+				VkViewport viewport{ 0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f };
+				VkRect2D scissor{ { 0, 0 }, extent };
+				vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+				vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+				size_t begin = chunk * itemsPerChunk;
+				recordChunk(commandBuffer, begin, std::min(begin + itemsPerChunk, itemCount));
+
+				if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+					throw std::runtime_error("Failed to record secondary command buffer");
+				}
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> lock{ job.mutex };
+				if (!job.error) {
+					job.error = std::current_exception();
+				}
+			}
+
+			std::lock_guard<std::mutex> lock{ job.mutex };
+			if (++job.completedChunks == chunkCount) {
+				job.finished.notify_all();
+			}
+		}
+	}
+}
\ No newline at end of file
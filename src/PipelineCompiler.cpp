@@ -0,0 +1,134 @@
+#include "PipelineCompiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+
+namespace Vulkan3DEngine
+{
+	PipelineCompiler::PipelineCompiler(DeviceManager& devManager, ThreadPool& threadPool)
+		: devManager{ devManager }, threadPool{ threadPool }
+	{
+	}
+
+	PipelineCompiler::~PipelineCompiler()
+	{
+	}
+
+	void PipelineCompiler::enqueue(const std::string& name, Job job)
+	{
+		pendingJobs.push_back({ name, std::move(job) });
+	}
+
+	/**
+	 * Builds every queued pipeline and blocks until all are done. The first exception thrown by a job is
+	 * rethrown after the others have finished and the worker caches have been merged.
+	 */
+	void PipelineCompiler::compileAll()
+	{
+		if (pendingJobs.empty()) return;
+
+		using Clock = std::chrono::high_resolution_clock;
+		auto start = Clock::now();
+
+		std::vector<char> seedData = getDeviceCacheData();
+		VkPipelineCacheCreateInfo cacheInfo{};
+		cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		cacheInfo.initialDataSize = seedData.size();
+		cacheInfo.pInitialData = seedData.empty() ? nullptr : seedData.data();
+
+		// no more jobs than threads run at once, so one cache per thread is enough
+		size_t cacheCount = std::min<size_t>(threadPool.getThreadCount(), pendingJobs.size());
+		std::vector<VkPipelineCache> workerCaches(cacheCount, VK_NULL_HANDLE);
+		for (auto& cache : workerCaches) {
+			if (vkCreatePipelineCache(devManager.getDeviceHandle(), &cacheInfo, nullptr, &cache) != VK_SUCCESS) {
+				throw std::runtime_error("Failed to create worker pipeline cache");
+			}
+		}
+
+		std::mutex cacheMutex;
+		std::vector<VkPipelineCache> freeCaches = workerCaches;
+		auto acquireCache = [&]() {
+			std::lock_guard<std::mutex> lock{ cacheMutex };
+			VkPipelineCache cache = freeCaches.back();
+			freeCaches.pop_back();
+			return cache;
+		};
+		auto releaseCache = [&](VkPipelineCache cache) {
+			std::lock_guard<std::mutex> lock{ cacheMutex };
+			freeCaches.push_back(cache);
+		};
+
+		std::vector<std::future<double>> results;
+		for (auto& pending : pendingJobs) {
+			results.push_back(threadPool.submit([&pending, &acquireCache, &releaseCache]() {
+				VkPipelineCache cache = acquireCache();
+				auto jobStart = Clock::now();
+				try {
+					pending.job(cache);
+				}
+				catch (...) {
+					releaseCache(cache);
+					throw;
+				}
+				releaseCache(cache);
+				return std::chrono::duration<double, std::milli>(Clock::now() - jobStart).count();
+			}));
+		}
+		for (auto& result : results) {
+			result.wait();
+		}
+
+		vkMergePipelineCaches(
+			devManager.getDeviceHandle(),
+			devManager.getPipelineCacheHandle(),
+			static_cast<uint32_t>(workerCaches.size()),
+			workerCaches.data()
+		);
+		for (VkPipelineCache cache : workerCaches) {
+			vkDestroyPipelineCache(devManager.getDeviceHandle(), cache, nullptr);
+		}
+
+		std::vector<PendingJob> jobs = std::move(pendingJobs);
+		pendingJobs.clear();
+
+		double compileMilliseconds = 0.0;
+		for (size_t i = 0; i < jobs.size(); ++i) {
+			double milliseconds = results[i].get();
+			timings.push_back({ jobs[i].name, milliseconds });
+			compileMilliseconds += milliseconds;
+		}
+		double wallMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		std::cout << std::fixed << std::setprecision(1);
+		std::cout << "Compiled " << jobs.size() << " pipelines on " << cacheCount << " threads in " << wallMilliseconds
+			<< " ms (" << compileMilliseconds << " ms of compile time):" << std::endl;
+		for (size_t i = timings.size() - jobs.size(); i < timings.size(); ++i) {
+			std::cout << "\t" << timings[i].name << ": " << timings[i].milliseconds << " ms" << std::endl;
+		}
+		std::cout << std::defaultfloat;
+	}
+
+	const std::vector<PipelineCompiler::Timing>& PipelineCompiler::getTimings() const
+	{
+		return timings;
+	}
+
+	std::vector<char> PipelineCompiler::getDeviceCacheData() const
+	{
+		size_t dataSize = 0;
+		if (vkGetPipelineCacheData(devManager.getDeviceHandle(), devManager.getPipelineCacheHandle(), &dataSize, nullptr) != VK_SUCCESS) {
+			return {};
+		}
+		std::vector<char> data(dataSize);
+		if (vkGetPipelineCacheData(devManager.getDeviceHandle(), devManager.getPipelineCacheHandle(), &dataSize, data.data()) != VK_SUCCESS) {
+			return {};
+		}
+		data.resize(dataSize);
+		return data;
+	}
+}
\ No newline at end of file
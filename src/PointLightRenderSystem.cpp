@@ -11,6 +11,7 @@
 #include <array>
 #include <cassert>
 #include <map>
+#include <vector>
 
 namespace Vulkan3DEngine
 {
@@ -25,12 +26,13 @@ namespace Vulkan3DEngine
 		DeviceManager& devManager,
 		VkRenderPass renderPass,
 		VkDescriptorSetLayout globalSetLayout,
+		PipelineCompiler* pipelineCompiler,
 		const std::string& vertexShaderPath,
 		const std::string& fragmentShaderPath
 	)
 	{
 		auto pointLightRenderSys = std::unique_ptr<PointLightRenderSystem>(new PointLightRenderSystem(devManager));
-		pointLightRenderSys->init(renderPass, globalSetLayout, vertexShaderPath, fragmentShaderPath);
+		pointLightRenderSys->init(renderPass, globalSetLayout, vertexShaderPath, fragmentShaderPath, pipelineCompiler);
 		return pointLightRenderSys;
 	}
 
@@ -63,26 +65,12 @@ namespace Vulkan3DEngine
 		}
 	}
 
-	void PointLightRenderSystem::createPipeline(
-		VkRenderPass renderPass,
-		const std::string& vertexShaderPath,
-		const std::string& fragmentShaderPath
-	)
+	void PointLightRenderSystem::configurePipeline(PipelineConfigInfo& pipelineConfig)
 	{
-		assert(pipelineLayout != nullptr && "Pipeline cannot be created before the pipeline layout");
-		PipelineConfigInfo pipelineConfig{};
 		GfxPipeline::defaultPipelineConfigInfo(pipelineConfig);
 		GfxPipeline::enableAlphaBlending(pipelineConfig);
 		pipelineConfig.bindingDescriptions.clear();
 		pipelineConfig.attribDescriptions.clear();
-		pipelineConfig.renderPass = renderPass;
-		pipelineConfig.pipelineLayout = pipelineLayout;
-		gfxPipeline = std::make_unique<GfxPipeline>(
-			devManager,
-			vertexShaderPath,
-			fragmentShaderPath,
-			pipelineConfig
-		);
 	}
 
 	void PointLightRenderSystem::update(FrameData& frameData, GlobalUbo& ubo)
@@ -128,40 +116,47 @@ namespace Vulkan3DEngine
 			sorted[distanceSq] = obj.getId();
 		}
 
-		gfxPipeline->bind(frameData.cmdBuffer);
-
-		vkCmdBindDescriptorSets(
-			frameData.cmdBuffer,
-			VK_PIPELINE_BIND_POINT_GRAPHICS,
-			pipelineLayout,
-			0,
-			1,
-			&frameData.globalDescSet,
-			0,
-			nullptr
-		);
-
-		
+		std::vector<Entity::id_t> backToFront;
 		for (auto iter = sorted.rbegin(); iter != sorted.rend(); ++iter) {
-			auto& obj = frameData.entities.at(iter->second);
-
-			const TransformComponent& transform = *obj.getComponent<TransformComponent>();
-			const PointLightComponent& light = *obj.getComponent<PointLightComponent>();
+			backToFront.push_back(iter->second);
+		}
 
-			PointLightPushConstants pushConstants{};
-			pushConstants.position = glm::vec4(transform.translation, 1.0f);
-			pushConstants.color = glm::vec4(light.color, light.intensity);
-			pushConstants.radius = transform.scale.x;
+		// chunks are executed in order, so the back to front order survives parallel recording
+		frameData.commandRecorder.record(backToFront.size(), [&](VkCommandBuffer commandBuffer, size_t begin, size_t end) {
+			gfxPipeline->bind(commandBuffer);
 
-			vkCmdPushConstants(
-				frameData.cmdBuffer,
+			vkCmdBindDescriptorSets(
+				commandBuffer,
+				VK_PIPELINE_BIND_POINT_GRAPHICS,
 				pipelineLayout,
-				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
 				0,
-				sizeof(PointLightPushConstants),
-				&pushConstants
+				1,
+				&frameData.globalDescSet,
+				1,
+				&frameData.globalUboOffset
 			);
-			vkCmdDraw(frameData.cmdBuffer, 6, 1, 0, 0);
-		}
+
+			for (size_t i = begin; i < end; ++i) {
+				auto& obj = frameData.entities.at(backToFront[i]);
+
+				const TransformComponent& transform = *obj.getComponent<TransformComponent>();
+				const PointLightComponent& light = *obj.getComponent<PointLightComponent>();
+
+				PointLightPushConstants pushConstants{};
+				pushConstants.position = glm::vec4(transform.translation, 1.0f);
+				pushConstants.color = glm::vec4(light.color, light.intensity);
+				pushConstants.radius = transform.scale.x;
+
+				vkCmdPushConstants(
+					commandBuffer,
+					pipelineLayout,
+					VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+					0,
+					sizeof(PointLightPushConstants),
+					&pushConstants
+				);
+				vkCmdDraw(commandBuffer, 6, 1, 0, 0);
+			}
+		});
 	}
 }
\ No newline at end of file
@@ -0,0 +1,738 @@
+#include "RenderGraph.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace Vulkan3DEngine
+{
+	// what has happened to an image so far while walking the passes in execution order
+	struct TrackedImageState
+	{
+		VkImageLayout layout;
+		VkPipelineStageFlags writeStages;		// stages of the last write, not yet waited on by later writes
+		VkAccessFlags writeAccess;
+		VkPipelineStageFlags readStages;		// stages reading since the last write
+		VkPipelineStageFlags visibleStages;		// stages the last write has been made visible to
+	};
+
+	static constexpr VkAccessFlags WRITE_ACCESS_MASK =
+		VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+		VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+		VK_ACCESS_SHADER_WRITE_BIT |
+		VK_ACCESS_TRANSFER_WRITE_BIT |
+		VK_ACCESS_HOST_WRITE_BIT |
+		VK_ACCESS_MEMORY_WRITE_BIT;
+
+	RenderGraph::PassBuilder::PassBuilder(RenderGraph& graph, PassHandle pass) : graph{ graph }, pass{ pass }
+	{
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::read(ResourceHandle resource, Access access)
+	{
+		assert(!isWriteAccess(access) && "Use write for write accesses");
+		graph.passes[pass].accesses.push_back({ resource, access });
+		graph.resources[resource].usage |= getUsage(access);
+		return *this;
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::write(ResourceHandle resource, Access access)
+	{
+		assert(isWriteAccess(access) && "Use read for read only accesses");
+		graph.passes[pass].accesses.push_back({ resource, access });
+		graph.resources[resource].usage |= getUsage(access);
+		return *this;
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::clearColor(ResourceHandle resource, VkClearColorValue value)
+	{
+		ResourceAccess access{ resource, Access::ColorAttachment, true };
+		access.clearValue.color = value;
+		graph.passes[pass].accesses.push_back(access);
+		graph.resources[resource].usage |= getUsage(Access::ColorAttachment);
+		return *this;
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::clearDepth(ResourceHandle resource, VkClearDepthStencilValue value)
+	{
+		ResourceAccess access{ resource, Access::DepthAttachment, true };
+		access.clearValue.depthStencil = value;
+		graph.passes[pass].accesses.push_back(access);
+		graph.resources[resource].usage |= getUsage(Access::DepthAttachment);
+		return *this;
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::setSubpassContents(VkSubpassContents contents)
+	{
+		graph.passes[pass].subpassContents = contents;
+		return *this;
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::setSideEffects()
+	{
+		graph.passes[pass].hasSideEffects = true;
+		return *this;
+	}
+
+	RenderGraph::RenderGraph(DeviceManager& devManager) : devManager{ devManager }
+	{
+	}
+
+	RenderGraph::~RenderGraph()
+	{
+		VkDevice device = devManager.getDeviceHandle();
+		for (auto& pass : passes) {
+			for (auto& [views, framebuffer] : pass.framebuffers) {
+				vkDestroyFramebuffer(device, framebuffer, nullptr);
+			}
+			if (pass.renderPass != VK_NULL_HANDLE) {
+				vkDestroyRenderPass(device, pass.renderPass, nullptr);
+			}
+		}
+		for (auto& resource : resources) {
+			if (resource.imported) continue;
+			if (resource.view != VK_NULL_HANDLE) {
+				vkDestroyImageView(device, resource.view, nullptr);
+			}
+			if (resource.image != VK_NULL_HANDLE) {
+				vkDestroyImage(device, resource.image, nullptr);
+			}
+		}
+		for (auto& block : memoryBlocks) {
+			devManager.getMemoryAllocator().free(block.allocation);
+		}
+	}
+
+	RenderGraph::ResourceHandle RenderGraph::createImage(const std::string& name, const ImageDesc& desc)
+	{
+		assert(!compiled && "Cannot add resources to a compiled render graph");
+		Resource resource{};
+		resource.name = name;
+		resource.desc = desc;
+		resource.usage = desc.extraUsage;
+		resources.push_back(resource);
+		return static_cast<ResourceHandle>(resources.size() - 1);
+	}
+
+	RenderGraph::ResourceHandle RenderGraph::importImage(
+		const std::string& name,
+		const ImageDesc& desc,
+		const ImageState& initialState,
+		const ImageState& finalState
+	)
+	{
+		assert(!compiled && "Cannot add resources to a compiled render graph");
+		Resource resource{};
+		resource.name = name;
+		resource.desc = desc;
+		resource.imported = true;
+		resource.initialState = initialState;
+		resource.finalState = finalState;
+		resources.push_back(resource);
+		return static_cast<ResourceHandle>(resources.size() - 1);
+	}
+
+	void RenderGraph::setImportedImage(ResourceHandle resource, VkImage image, VkImageView view)
+	{
+		assert(resources[resource].imported && "Only imported images can be replaced");
+		resources[resource].image = image;
+		resources[resource].view = view;
+	}
+
+	RenderGraph::PassHandle RenderGraph::addPass(
+		const std::string& name,
+		const std::function<void(PassBuilder& builder)>& setup,
+		ExecuteFunction execute
+	)
+	{
+		assert(!compiled && "Cannot add passes to a compiled render graph");
+		passes.push_back({});
+		passes.back().name = name;
+		passes.back().execute = std::move(execute);
+
+		PassHandle pass = static_cast<PassHandle>(passes.size() - 1);
+		PassBuilder builder{ *this, pass };
+		setup(builder);
+		return pass;
+	}
+
+	void RenderGraph::compile()
+	{
+		assert(!compiled && "Render graph is already compiled");
+		statistics.passCount = static_cast<uint32_t>(passes.size());
+
+		cullPasses();
+		allocateTransientImages();
+		computeBarriers();
+		createRenderPasses();
+		compiled = true;
+	}
+
+	/**
+	 * Records all passes that survived culling, each preceded by the barriers it needs
+	 */
+	void RenderGraph::execute(VkCommandBuffer commandBuffer)
+	{
+		assert(compiled && "Render graph must be compiled before it is executed");
+
+		for (PassHandle passHandle : executionOrder) {
+			Pass& pass = passes[passHandle];
+			recordBarriers(commandBuffer, pass.barriers);
+
+			PassContext context{ commandBuffer, pass.renderPass, VK_NULL_HANDLE, pass.extent };
+			if (pass.renderPass != VK_NULL_HANDLE) {
+				context.framebuffer = getFramebuffer(pass);
+
+				VkRenderPassBeginInfo beginInfo{};
+				beginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+				beginInfo.renderPass = pass.renderPass;
+				beginInfo.framebuffer = context.framebuffer;
+				beginInfo.renderArea = { { 0, 0 }, pass.extent };
+				beginInfo.clearValueCount = static_cast<uint32_t>(pass.clearValues.size());
+				beginInfo.pClearValues = pass.clearValues.data();
+				vkCmdBeginRenderPass(commandBuffer, &beginInfo, pass.subpassContents);
+
+				if (pass.subpassContents == VK_SUBPASS_CONTENTS_INLINE) {
+					VkViewport viewport{ 0.0f, 0.0f, static_cast<float>(pass.extent.width), static_cast<float>(pass.extent.height), 0.0f, 1.0f };
+					VkRect2D scissor{ { 0, 0 }, pass.extent };
+					vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+					vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+				}
+			}
+
+			pass.execute(context);
+
+			if (pass.renderPass != VK_NULL_HANDLE) {
+				vkCmdEndRenderPass(commandBuffer);
+			}
+		}
+
+		recordBarriers(commandBuffer, finalBarriers);
+	}
+
+	VkRenderPass RenderGraph::getRenderPass(PassHandle pass) const
+	{
+		assert(compiled && "Render passes are created by compile");
+		return passes[pass].renderPass;
+	}
+
+	VkImageView RenderGraph::getImageView(ResourceHandle resource) const
+	{
+		return resources[resource].view;
+	}
+
+	RenderGraph::Statistics RenderGraph::getStatistics() const
+	{
+		return statistics;
+	}
+
+	/**
+	 * Walks the passes backwards from the imported images that are kept after the graph, keeping passes
+	 * that write something a kept pass or the outside world still needs
+	 */
+	void RenderGraph::cullPasses()
+	{
+		std::vector<bool> needed(resources.size());
+		for (size_t i = 0; i < resources.size(); ++i) {
+			needed[i] = resources[i].imported && resources[i].finalState.layout != VK_IMAGE_LAYOUT_UNDEFINED;
+		}
+
+		for (size_t i = passes.size(); i-- > 0; ) {
+			Pass& pass = passes[i];
+			pass.culled = !pass.hasSideEffects && std::none_of(
+				pass.accesses.begin(),
+				pass.accesses.end(),
+				[&needed](const ResourceAccess& access) { return isWriteAccess(access.access) && needed[access.resource]; }
+			);
+			if (pass.culled) {
+				++statistics.culledPassCount;
+				continue;
+			}
+
+			// a cleared image does not depend on earlier writers, everything else does
+			for (auto& access : pass.accesses) {
+				if (access.clear) {
+					needed[access.resource] = false;
+				}
+			}
+			for (auto& access : pass.accesses) {
+				if (!access.clear) {
+					needed[access.resource] = true;
+				}
+			}
+		}
+
+		for (PassHandle i = 0; i < passes.size(); ++i) {
+			if (!passes[i].culled) {
+				executionOrder.push_back(i);
+			}
+		}
+	}
+
+	/**
+	 * Creates the transient images used by the remaining passes and packs them into as few memory
+	 * blocks as possible: images share a block when their lifetimes, in execution order, do not overlap.
+	 */
+	void RenderGraph::allocateTransientImages()
+	{
+		for (uint32_t order = 0; order < executionOrder.size(); ++order) {
+			for (auto& access : passes[executionOrder[order]].accesses) {
+				Resource& resource = resources[access.resource];
+				resource.firstUse = std::min(resource.firstUse, order);
+				resource.lastUse = std::max(resource.lastUse, order);
+			}
+		}
+
+		VkDevice device = devManager.getDeviceHandle();
+		std::vector<VkMemoryRequirements> requirements(resources.size());
+		std::vector<ResourceHandle> transients;
+		for (ResourceHandle handle = 0; handle < resources.size(); ++handle) {
+			Resource& resource = resources[handle];
+			if (resource.imported || resource.firstUse == UINT32_MAX) continue;
+
+			VkImageCreateInfo imageInfo{};
+			imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+			imageInfo.imageType = VK_IMAGE_TYPE_2D;
+			imageInfo.format = resource.desc.format;
+			imageInfo.extent = { resource.desc.extent.width, resource.desc.extent.height, 1 };
+			imageInfo.mipLevels = 1;
+			imageInfo.arrayLayers = 1;
+			imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+			imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+			imageInfo.usage = resource.usage;
+			imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+			if (vkCreateImage(device, &imageInfo, nullptr, &resource.image) != VK_SUCCESS) {
+				throw std::runtime_error("Failed to create render graph image " + resource.name);
+			}
+			vkGetImageMemoryRequirements(device, resource.image, &requirements[handle]);
+			transients.push_back(handle);
+			statistics.unaliasedBytes += requirements[handle].size;
+		}
+
+		// largest first, so smaller images fill the blocks opened by larger ones
+		std::sort(transients.begin(), transients.end(), [&requirements](ResourceHandle a, ResourceHandle b) {
+			return requirements[a].size > requirements[b].size;
+		});
+
+		for (ResourceHandle handle : transients) {
+			Resource& resource = resources[handle];
+			const VkMemoryRequirements& required = requirements[handle];
+
+			for (size_t i = 0; i < memoryBlocks.size() && resource.memoryBlock < 0; ++i) {
+				MemoryBlock& block = memoryBlocks[i];
+				if ((block.requirements.memoryTypeBits & required.memoryTypeBits) == 0) continue;
+
+				bool overlaps = std::any_of(block.resources.begin(), block.resources.end(), [&](ResourceHandle other) {
+					return resource.firstUse <= resources[other].lastUse && resources[other].firstUse <= resource.lastUse;
+				});
+				if (overlaps) continue;
+
+				block.requirements.size = std::max(block.requirements.size, required.size);
+				block.requirements.alignment = std::max(block.requirements.alignment, required.alignment);
+				block.requirements.memoryTypeBits &= required.memoryTypeBits;
+				block.resources.push_back(handle);
+				resource.memoryBlock = static_cast<int>(i);
+			}
+
+			if (resource.memoryBlock < 0) {
+				memoryBlocks.push_back({ required, { handle } });
+				resource.memoryBlock = static_cast<int>(memoryBlocks.size() - 1);
+			}
+		}
+
+		for (auto& block : memoryBlocks) {
+			uint32_t memoryTypeIndex = devManager.findMemoryType(block.requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+			block.allocation = devManager.getMemoryAllocator().allocate(
+				block.requirements,
+				memoryTypeIndex,
+				MemoryAllocator::ResourceKind::Optimal
+			);
+			statistics.transientBytes += block.requirements.size;
+
+			// users in execution order, each one takes the memory over from the previous
+			std::sort(block.resources.begin(), block.resources.end(), [this](ResourceHandle a, ResourceHandle b) {
+				return resources[a].firstUse < resources[b].firstUse;
+			});
+
+			for (ResourceHandle handle : block.resources) {
+				Resource& resource = resources[handle];
+				if (vkBindImageMemory(device, resource.image, block.allocation.memory, block.allocation.offset) != VK_SUCCESS) {
+					throw std::runtime_error("Failed to bind render graph image memory");
+				}
+
+				// depth/stencil images are viewed through their depth aspect, which is what attachments and samplers use
+				VkImageAspectFlags aspectMask = getAspectMask(resource.desc.format);
+				if (aspectMask & VK_IMAGE_ASPECT_DEPTH_BIT) {
+					aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+				}
+
+				VkImageViewCreateInfo viewInfo{};
+				viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+				viewInfo.image = resource.image;
+				viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+				viewInfo.format = resource.desc.format;
+				viewInfo.subresourceRange.aspectMask = aspectMask;
+				viewInfo.subresourceRange.levelCount = 1;
+				viewInfo.subresourceRange.layerCount = 1;
+
+				if (vkCreateImageView(device, &viewInfo, nullptr, &resource.view) != VK_SUCCESS) {
+					throw std::runtime_error("Failed to create render graph image view " + resource.name);
+				}
+			}
+		}
+
+		statistics.transientImageCount = static_cast<uint32_t>(transients.size());
+		statistics.memoryBlockCount = static_cast<uint32_t>(memoryBlocks.size());
+	}
+
+	/**
+	 * Simulates the accesses of one execution and emits a barrier only where an access needs a layout
+	 * transition or has a hazard with an earlier access: read after write, write after write or write
+	 * after read. Reads of a write already made visible to their stage need nothing.
+	 */
+	void RenderGraph::computeBarriers()
+	{
+		// the last access of each image in an execution, which the next execution has to wait for
+		std::vector<ImageState> lastAccess(resources.size());
+		for (PassHandle passHandle : executionOrder) {
+			for (auto& access : passes[passHandle].accesses) {
+				lastAccess[access.resource] = getAccessState(access.access);
+			}
+		}
+
+		std::vector<TrackedImageState> states(resources.size());
+		for (ResourceHandle handle = 0; handle < resources.size(); ++handle) {
+			Resource& resource = resources[handle];
+			if (resource.imported) {
+				states[handle] = { resource.initialState.layout, resource.initialState.stageMask, resource.initialState.accessMask, 0, 0 };
+				continue;
+			}
+			if (resource.memoryBlock < 0) continue;
+
+			// a transient image takes its memory over from the previous user of the block, which for the
+			// first user is the last one of the previous execution
+			auto& users = memoryBlocks[resource.memoryBlock].resources;
+			size_t index = std::find(users.begin(), users.end(), handle) - users.begin();
+			ResourceHandle previous = users[(index + users.size() - 1) % users.size()];
+			states[handle] = { VK_IMAGE_LAYOUT_UNDEFINED, lastAccess[previous].stageMask, lastAccess[previous].accessMask & WRITE_ACCESS_MASK, 0, 0 };
+		}
+
+		for (PassHandle passHandle : executionOrder) {
+			Pass& pass = passes[passHandle];
+			for (auto& access : pass.accesses) {
+				TrackedImageState& state = states[access.resource];
+				ImageState target = getAccessState(access.access);
+				bool isWrite = isWriteAccess(access.access);
+
+				bool needsBarrier = target.layout != state.layout ||
+					(isWrite && (state.writeStages != 0 || state.readStages != 0)) ||
+					(!isWrite && state.writeStages != 0 && (state.visibleStages & target.stageMask) != target.stageMask);
+
+				if (needsBarrier) {
+					// cleared attachments and fresh transient images do not need their old contents
+					bool discard = access.clear || (!resources[access.resource].imported && state.layout == VK_IMAGE_LAYOUT_UNDEFINED);
+					pass.barriers.barriers.push_back({
+						access.resource,
+						discard ? VK_IMAGE_LAYOUT_UNDEFINED : state.layout,
+						target.layout,
+						state.writeAccess,
+						target.accessMask
+					});
+					pass.barriers.srcStageMask |= state.writeStages | state.readStages;
+					pass.barriers.dstStageMask |= target.stageMask;
+					state.layout = target.layout;
+				}
+
+				if (isWrite) {
+					state.writeStages = target.stageMask;
+					state.writeAccess = target.accessMask & WRITE_ACCESS_MASK;
+					state.readStages = 0;
+					state.visibleStages = 0;
+				}
+				else {
+					state.readStages |= target.stageMask;
+					state.visibleStages |= needsBarrier ? target.stageMask : 0;
+				}
+			}
+			statistics.barrierCount += static_cast<uint32_t>(pass.barriers.barriers.size());
+		}
+
+		for (ResourceHandle handle = 0; handle < resources.size(); ++handle) {
+			Resource& resource = resources[handle];
+			if (!resource.imported || resource.finalState.layout == VK_IMAGE_LAYOUT_UNDEFINED) continue;
+
+			// like a read, the final state needs nothing if the image is already in its layout and the last
+			// write is visible to the final stages, e.g. after a pass that copies the image out
+			TrackedImageState& state = states[handle];
+			const ImageState& target = resource.finalState;
+			bool needsBarrier = target.layout != state.layout ||
+				(target.accessMask & WRITE_ACCESS_MASK) != 0 ||
+				(state.writeStages != 0 && (state.visibleStages & target.stageMask) != target.stageMask);
+			if (!needsBarrier) continue;
+
+			finalBarriers.barriers.push_back({
+				handle,
+				state.layout,
+				resource.finalState.layout,
+				state.writeAccess,
+				resource.finalState.accessMask
+			});
+			finalBarriers.srcStageMask |= state.writeStages | state.readStages;
+			finalBarriers.dstStageMask |= resource.finalState.stageMask;
+		}
+		statistics.barrierCount += static_cast<uint32_t>(finalBarriers.barriers.size());
+	}
+
+	/**
+	 * One single subpass render pass per pass with attachments. Layout transitions are done by the
+	 * graph's barriers, so attachments stay in one layout; contents are only loaded or stored when an
+	 * earlier or later pass, or the outside world, needs them.
+	 */
+	void RenderGraph::createRenderPasses()
+	{
+		for (uint32_t order = 0; order < executionOrder.size(); ++order) {
+			Pass& pass = passes[executionOrder[order]];
+
+			std::vector<VkAttachmentDescription> attachments;
+			std::vector<VkAttachmentReference> colorReferences;
+			VkAttachmentReference depthReference{};
+			bool hasDepth = false;
+
+			for (auto& access : pass.accesses) {
+				if (!isAttachmentAccess(access.access)) continue;
+				const Resource& resource = resources[access.resource];
+
+				bool usedLater = std::any_of(executionOrder.begin() + order + 1, executionOrder.end(), [&](PassHandle later) {
+					auto& laterAccesses = passes[later].accesses;
+					return std::any_of(laterAccesses.begin(), laterAccesses.end(), [&](const ResourceAccess& laterAccess) {
+						return laterAccess.resource == access.resource;
+					});
+				});
+				bool keptAfterGraph = resource.imported && resource.finalState.layout != VK_IMAGE_LAYOUT_UNDEFINED;
+				VkImageLayout layout = getAccessState(access.access).layout;
+
+				VkAttachmentDescription attachment{};
+				attachment.format = resource.desc.format;
+				attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+				if (access.clear) {
+					attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+				}
+				else if (!resource.imported && resource.firstUse == order) {
+					attachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+				}
+				else {
+					attachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+				}
+				attachment.storeOp = usedLater || keptAfterGraph ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+				attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+				attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+				attachment.initialLayout = layout;
+				attachment.finalLayout = layout;
+
+				VkAttachmentReference reference{ static_cast<uint32_t>(attachments.size()), layout };
+				if (access.access == Access::ColorAttachment) {
+					colorReferences.push_back(reference);
+				}
+				else {
+					assert(!hasDepth && "A pass can only have one depth attachment");
+					depthReference = reference;
+					hasDepth = true;
+				}
+
+				if (attachments.empty()) {
+					pass.extent = resource.desc.extent;
+				}
+				attachments.push_back(attachment);
+				pass.attachments.push_back(access.resource);
+				pass.clearValues.push_back(access.clearValue);
+			}
+			if (attachments.empty()) continue;
+
+			VkSubpassDescription subpass{};
+			subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+			subpass.colorAttachmentCount = static_cast<uint32_t>(colorReferences.size());
+			subpass.pColorAttachments = colorReferences.data();
+			subpass.pDepthStencilAttachment = hasDepth ? &depthReference : nullptr;
+
+			VkRenderPassCreateInfo renderPassInfo{};
+			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+			renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+			renderPassInfo.pAttachments = attachments.data();
+			renderPassInfo.subpassCount = 1;
+			renderPassInfo.pSubpasses = &subpass;
+
+			if (vkCreateRenderPass(devManager.getDeviceHandle(), &renderPassInfo, nullptr, &pass.renderPass) != VK_SUCCESS) {
+				throw std::runtime_error("Failed to create render pass for " + pass.name);
+			}
+		}
+	}
+
+	VkFramebuffer RenderGraph::getFramebuffer(Pass& pass)
+	{
+		std::vector<VkImageView> views;
+		for (ResourceHandle resource : pass.attachments) {
+			assert(resources[resource].view != VK_NULL_HANDLE && "Imported image was not set");
+			views.push_back(resources[resource].view);
+		}
+
+		auto it = pass.framebuffers.find(views);
+		if (it != pass.framebuffers.end()) {
+			return it->second;
+		}
+
+		VkFramebufferCreateInfo framebufferInfo{};
+		framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		framebufferInfo.renderPass = pass.renderPass;
+		framebufferInfo.attachmentCount = static_cast<uint32_t>(views.size());
+		framebufferInfo.pAttachments = views.data();
+		framebufferInfo.width = pass.extent.width;
+		framebufferInfo.height = pass.extent.height;
+		framebufferInfo.layers = 1;
+
+		VkFramebuffer framebuffer;
+		if (vkCreateFramebuffer(devManager.getDeviceHandle(), &framebufferInfo, nullptr, &framebuffer) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create framebuffer for " + pass.name);
+		}
+		pass.framebuffers.emplace(std::move(views), framebuffer);
+		return framebuffer;
+	}
+
+	void RenderGraph::recordBarriers(VkCommandBuffer commandBuffer, const BarrierBatch& batch) const
+	{
+		if (batch.barriers.empty()) return;
+
+		std::vector<VkImageMemoryBarrier> imageBarriers;
+		imageBarriers.reserve(batch.barriers.size());
+		for (auto& barrier : batch.barriers) {
+			const Resource& resource = resources[barrier.resource];
+			assert(resource.image != VK_NULL_HANDLE && "Imported image was not set");
+
+			VkImageMemoryBarrier imageBarrier{};
+			imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			imageBarrier.srcAccessMask = barrier.srcAccessMask;
+			imageBarrier.dstAccessMask = barrier.dstAccessMask;
+			imageBarrier.oldLayout = barrier.oldLayout;
+			imageBarrier.newLayout = barrier.newLayout;
+			imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			imageBarrier.image = resource.image;
+			imageBarrier.subresourceRange = {
+				getAspectMask(resource.desc.format),
+				0,
+				VK_REMAINING_MIP_LEVELS,
+				0,
+				VK_REMAINING_ARRAY_LAYERS
+			};
+			imageBarriers.push_back(imageBarrier);
+		}
+
+		// nothing to wait for, e.g. the first use of an image
+		VkPipelineStageFlags srcStageMask = batch.srcStageMask;
+		if (srcStageMask == 0) {
+			srcStageMask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+		}
+
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			srcStageMask,
+			batch.dstStageMask,
+			0,
+			0,
+			nullptr,
+			0,
+			nullptr,
+			static_cast<uint32_t>(imageBarriers.size()),
+			imageBarriers.data()
+		);
+	}
+
+	RenderGraph::ImageState RenderGraph::getAccessState(Access access)
+	{
+		constexpr VkPipelineStageFlags fragmentTests =
+			VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+
+		switch (access) {
+		case Access::ColorAttachment:
+			return {
+				VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+				VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+				VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+			};
+		case Access::DepthAttachment:
+			return {
+				VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+				fragmentTests,
+				VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
+			};
+		case Access::DepthRead:
+			return { VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, fragmentTests, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT };
+		case Access::SampledRead:
+			return { VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT };
+		case Access::StorageRead:
+			return { VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT };
+		case Access::StorageWrite:
+			return {
+				VK_IMAGE_LAYOUT_GENERAL,
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+			};
+		case Access::TransferRead:
+			return { VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT };
+		default:
+			return { VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT };
+		}
+	}
+
+	bool RenderGraph::isWriteAccess(Access access)
+	{
+		return access == Access::ColorAttachment ||
+			access == Access::DepthAttachment ||
+			access == Access::StorageWrite ||
+			access == Access::TransferWrite;
+	}
+
+	bool RenderGraph::isAttachmentAccess(Access access)
+	{
+		return access == Access::ColorAttachment || access == Access::DepthAttachment || access == Access::DepthRead;
+	}
+
+	VkImageUsageFlags RenderGraph::getUsage(Access access)
+	{
+		switch (access) {
+		case Access::ColorAttachment:
+			return VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+		case Access::DepthAttachment:
+		case Access::DepthRead:
+			return VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+		case Access::SampledRead:
+			return VK_IMAGE_USAGE_SAMPLED_BIT;
+		case Access::StorageRead:
+		case Access::StorageWrite:
+			return VK_IMAGE_USAGE_STORAGE_BIT;
+		case Access::TransferRead:
+			return VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		default:
+			return VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+		}
+	}
+
+	VkImageAspectFlags RenderGraph::getAspectMask(VkFormat format)
+	{
+		switch (format) {
+		case VK_FORMAT_D16_UNORM:
+		case VK_FORMAT_X8_D24_UNORM_PACK32:
+		case VK_FORMAT_D32_SFLOAT:
+			return VK_IMAGE_ASPECT_DEPTH_BIT;
+		case VK_FORMAT_D16_UNORM_S8_UINT:
+		case VK_FORMAT_D24_UNORM_S8_UINT:
+		case VK_FORMAT_D32_SFLOAT_S8_UINT:
+			return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+		case VK_FORMAT_S8_UINT:
+			return VK_IMAGE_ASPECT_STENCIL_BIT;
+		default:
+			return VK_IMAGE_ASPECT_COLOR_BIT;
+		}
+	}
+}
\ No newline at end of file
@@ -1,5 +1,10 @@
 #include "RenderSystem.h"
 
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+
 namespace Vulkan3DEngine
 {
 
@@ -11,16 +16,102 @@ namespace Vulkan3DEngine
 		VkRenderPass renderPass, 
 		VkDescriptorSetLayout globalSetLayout, 
 		const std::string& vertexShaderPath, 
-		const std::string& fragmentShaderPath
+		const std::string& fragmentShaderPath,
+		PipelineCompiler* pipelineCompiler
 	)
 	{
+		this->renderPass = renderPass;
+		this->vertexShaderPath = vertexShaderPath;
+		this->fragmentShaderPath = fragmentShaderPath;
 		createPipelineLayout(globalSetLayout);
-		createPipeline(renderPass, vertexShaderPath, fragmentShaderPath);
+
+		// with a compiler the pipeline is only built by PipelineCompiler::compileAll, before the first render
+		if (pipelineCompiler == nullptr) {
+			gfxPipeline = devManager.getPipelineStateCache().getPipeline(
+				vertexShaderPath,
+				fragmentShaderPath,
+				*createPipelineConfig()
+			);
+			return;
+		}
+		pipelineCompiler->enqueue(
+			vertexShaderPath + " + " + fragmentShaderPath,
+			[this](VkPipelineCache pipelineCache) {
+				gfxPipeline = devManager.getPipelineStateCache().getPipeline(
+					this->vertexShaderPath,
+					this->fragmentShaderPath,
+					*createPipelineConfig(),
+					pipelineCache
+				);
+			}
+		);
 	}
 
+	/**
+	 * Starts rebuilding the pipeline on the thread pool if it uses one of the changed shaders. The current
+	 * pipeline keeps rendering until the new one is swapped in by nextFrame.
+	 *
+	 * @return Whether this system uses any of the shaders
+	 */
+	bool RenderSystem::reloadShaders(const std::vector<std::string>& changedShaders, ThreadPool& threadPool)
+	{
+		bool affected = std::any_of(changedShaders.begin(), changedShaders.end(), [this](const std::string& path) {
+			return path == vertexShaderPath || path == fragmentShaderPath;
+		});
+		if (!affected) {
+			return false;
+		}
+
+		// the task does not touch this system, so it may outlive it; a reload still in progress is superseded
+		std::shared_ptr<PipelineConfigInfo> pipelineConfig = createPipelineConfig();
+		pendingPipeline = threadPool.submit(
+			[&devManager = devManager, pipelineConfig, vert = vertexShaderPath, frag = fragmentShaderPath]() {
+				return devManager.getPipelineStateCache().getPipeline(vert, frag, *pipelineConfig);
+			}
+		);
+		return true;
+	}
+
+	/**
+	 * Call once per frame before recording. Swaps in a rebuilt pipeline if one is ready; the replaced one
+	 * is retired to the deletion queue, as frames in flight may still be using it. Once it is released,
+	 * the shader modules that no pipeline uses any more are destroyed with it.
+	 */
+	void RenderSystem::nextFrame(DeferredDeletionQueue& deletionQueue)
+	{
+		if (!pendingPipeline.valid() || pendingPipeline.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+			return;
+		}
+		try {
+			auto pipeline = pendingPipeline.get();
+			deletionQueue.enqueue([&devManager = devManager, retired = std::move(gfxPipeline)]() mutable {
+				retired.reset();
+				devManager.getPipelineStateCache().releaseUnusedShaderModules();
+			});
+			gfxPipeline = std::move(pipeline);
+		}
+		catch (const std::exception& e) {
+			std::cerr << "Failed to rebuild pipeline for " << vertexShaderPath << " + " << fragmentShaderPath
+				<< ", keeping the previous one: " << e.what() << std::endl;
+		}
+	}
+
+	std::unique_ptr<PipelineConfigInfo> RenderSystem::createPipelineConfig()
+	{
+		assert(pipelineLayout != nullptr && "Pipeline cannot be created before the pipeline layout");
+		auto pipelineConfig = std::make_unique<PipelineConfigInfo>();
+		configurePipeline(*pipelineConfig);
+		pipelineConfig->renderPass = renderPass;
+		pipelineConfig->pipelineLayout = pipelineLayout;
+		return pipelineConfig;
+	}
 
 	RenderSystem::~RenderSystem()
 	{
+		// the pipeline must be destroyed before the device, not later on the worker
+		if (pendingPipeline.valid()) {
+			pendingPipeline.wait();
+		}
 		if (pipelineLayout != VK_NULL_HANDLE) {
 			vkDestroyPipelineLayout(devManager.getDeviceHandle(), pipelineLayout, nullptr);
 		}
@@ -4,19 +4,32 @@
 
 #include <stdexcept>
 #include <cassert>
-#include <array>
 
 namespace Vulkan3DEngine
 {
-	Renderer::Renderer(WindowManager& winManager, DeviceManager& devManager)
-		: winManager{ winManager }, devManager{ devManager }
+	Renderer::Renderer(WindowManager& winManager, DeviceManager& devManager, int framesInFlight)
+		: winManager{ winManager }, devManager{ devManager }, framesInFlight{ framesInFlight }, deletionQueue{ framesInFlight }
 	{
-		recreateSwapChain();
+		assert(
+			framesInFlight >= AppConstants::MIN_FRAMES_IN_FLIGHT && framesInFlight <= AppConstants::MAX_FRAMES_IN_FLIGHT &&
+			"Unsupported number of frames in flight"
+		);
+		if (winManager.isHeadless()) {
+			offscreenTarget = std::make_unique<OffscreenTarget>(devManager, winManager.getExtent(), framesInFlight);
+			renderTarget = offscreenTarget.get();
+		}
+		else {
+			recreateSwapChain();
+		}
 		createCommandBuffers();
+		createTimestampQueryPool();
 	}
 
 	Renderer::~Renderer()
 	{
+		if (timestampQueryPool != VK_NULL_HANDLE) {
+			vkDestroyQueryPool(devManager.getDeviceHandle(), timestampQueryPool, nullptr);
+		}
 		destroyCommandBuffers();
 	}
 
@@ -24,7 +37,9 @@ namespace Vulkan3DEngine
 	{
 		assert(!isFrameStarted && "Cannot begin a new frame if one is already in progress");
 
-		auto result = swapManager->acquireNextImage(&currentImageIndex);
+		auto waitStart = std::chrono::steady_clock::now();
+		auto result = renderTarget->acquireNextImage(&currentImageIndex);
+		auto waitEnd = std::chrono::steady_clock::now();
 
 		if (result == VK_ERROR_OUT_OF_DATE_KHR) {
 			recreateSwapChain();
@@ -34,8 +49,20 @@ namespace Vulkan3DEngine
 		if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
 			throw std::runtime_error("Failed to acquire next image from the swap chain");
 		}
+
+		// the first frame only starts the clock
+		if (firstFrameStart == std::chrono::steady_clock::time_point{}) {
+			firstFrameStart = waitEnd;
+		}
+		else {
+			++frameStatistics.frameCount;
+			frameStatistics.waitSeconds += std::chrono::duration<double>(waitEnd - waitStart).count();
+			frameStatistics.wallSeconds = std::chrono::duration<double>(waitEnd - firstFrameStart).count();
+		}
 		
 		isFrameStarted = true;
+		deletionQueue.nextFrame();
+		readTimestamps();
 
 		auto cmdBuffer = getCurrentCommandBuffer();
 
@@ -46,6 +73,12 @@ namespace Vulkan3DEngine
 			throw std::runtime_error("Failed to begin recording command buffer");
 		}
 
+		if (timestampQueryPool != VK_NULL_HANDLE) {
+			uint32_t firstQuery = static_cast<uint32_t>(currentFrameIndex) * 2;
+			vkCmdResetQueryPool(cmdBuffer, timestampQueryPool, firstQuery, 2);
+			vkCmdWriteTimestamp(cmdBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampQueryPool, firstQuery);
+		}
+
 		return cmdBuffer;
 	}
 
@@ -54,11 +87,24 @@ namespace Vulkan3DEngine
 		assert(isFrameStarted && "Cannot end a frame if it is not in progress");
 
 		auto cmdBuffer = getCurrentCommandBuffer();
+		if (timestampQueryPool != VK_NULL_HANDLE) {
+			uint32_t lastQuery = static_cast<uint32_t>(currentFrameIndex) * 2 + 1;
+			vkCmdWriteTimestamp(cmdBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampQueryPool, lastQuery);
+			timestampsPending[currentFrameIndex] = true;
+		}
 		if (vkEndCommandBuffer(cmdBuffer) != VK_SUCCESS) {
 			throw std::runtime_error("Failed to record command buffer");
 		}
 
-		auto result = swapManager->submitCommandBuffers(&cmdBuffer, &currentImageIndex);
+		// uploads seen complete while recording are made visible to this frame by waiting for their semaphores
+		UploadBatcher& uploadBatcher = devManager.getUploadBatcher();
+		std::vector<VkSemaphore> uploadSemaphores = uploadBatcher.takeCompletedSemaphores();
+		auto result = renderTarget->submitCommandBuffers(&cmdBuffer, &currentImageIndex, uploadSemaphores);
+		if (!uploadSemaphores.empty()) {
+			deletionQueue.enqueue([&uploadBatcher, uploadSemaphores]() {
+				uploadBatcher.recycleSemaphores(uploadSemaphores);
+			});
+		}
 
 		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || winManager.windowWasResized()) {
 			winManager.resetWindowResizedFlag();
@@ -69,7 +115,7 @@ namespace Vulkan3DEngine
 		}
 
 		isFrameStarted = false;
-		currentFrameIndex = (currentFrameIndex + 1) % AppConstants::MAX_FRAMES_IN_FLIGHT;
+		currentFrameIndex = (currentFrameIndex + 1) % framesInFlight;
 	}
 
 	bool Renderer::isFrameInProgress() const
@@ -83,71 +129,98 @@ namespace Vulkan3DEngine
 		return currentFrameIndex;
 	}
 
+	int Renderer::getFramesInFlight() const
+	{
+		return framesInFlight;
+	}
+
+	/**
+	 * Advanced at the start of every frame, once an image was acquired and the frame's fence has been
+	 * waited on. Anything frames in flight may still use is released through it.
+	 */
+	DeferredDeletionQueue& Renderer::getDeletionQueue()
+	{
+		return deletionQueue;
+	}
+
+	Renderer::FrameStatistics Renderer::getFrameStatistics() const
+	{
+		return frameStatistics;
+	}
+
 	VkCommandBuffer Renderer::getCurrentCommandBuffer() const
 	{
 		assert(isFrameStarted && "Cannot get command buffer if frame is not in progress");
 		return commandBuffers[currentFrameIndex];
 	}
 
-	void Renderer::beginSwapChainRenderPass(VkCommandBuffer cmdBuffer)
+	VkRenderPass Renderer::getSwapChainRenderPass() const
 	{
-		assert(isFrameStarted && "Cannot begin render pass if a frame is not in progress");
-		assert(
-			cmdBuffer == getCurrentCommandBuffer() && 
-			"Cannot begin render pass on a command buffer from a different frame"
-		);
+		return renderTarget->getRenderPass();
+	}
 
-		VkRenderPassBeginInfo renderPassBeginInfo{};
-		renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		renderPassBeginInfo.renderPass = swapManager->getRenderPass();
-		renderPassBeginInfo.framebuffer = swapManager->getFrameBuffer(currentImageIndex);
-		renderPassBeginInfo.renderArea.offset = { 0, 0 };
-		renderPassBeginInfo.renderArea.extent = swapManager->getSwapChainExtent();
+	VkExtent2D Renderer::getSwapChainExtent() const
+	{
+		return renderTarget->getSwapChainExtent();
+	}
 
-		std::array<VkClearValue, 2> clearValues{};
-		clearValues[0].color = { 0.01f, 0.01f, 0.01f, 1.0f };
-		clearValues[1].depthStencil = { 1.0f, 0 };
+	VkFormat Renderer::getSwapChainImageFormat() const
+	{
+		return renderTarget->getSwapChainImageFormat();
+	}
 
-		renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-		renderPassBeginInfo.pClearValues = clearValues.data();
+	VkFormat Renderer::getSwapChainDepthFormat() const
+	{
+		return renderTarget->getSwapChainDepthFormat();
+	}
 
-		vkCmdBeginRenderPass(cmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+	VkImageLayout Renderer::getOutputLayout() const
+	{
+		return renderTarget->getOutputLayout();
+	}
 
-		VkViewport viewport{};
-		viewport.x = 0.0f;
-		viewport.y = 0.0f;
-		viewport.width = static_cast<float>(swapManager->getSwapChainExtent().width);
-		viewport.height = static_cast<float>(swapManager->getSwapChainExtent().height);
-		viewport.minDepth = 0.0f;
-		viewport.maxDepth = 1.0f;
-		VkRect2D scissor{ { 0, 0 }, swapManager->getSwapChainExtent() };
-		vkCmdSetViewport(cmdBuffer, 0, 1, &viewport);
-		vkCmdSetScissor(cmdBuffer, 0, 1, &scissor);
+	bool Renderer::supportsReadback() const
+	{
+		return renderTarget->supportsReadback();
 	}
 
-	void Renderer::endSwapChainRenderPass(VkCommandBuffer cmdBuffer)
+	uint32_t Renderer::getSwapChainGeneration() const
 	{
-		assert(isFrameStarted && "Cannot end render pass if a frame is not in progress");
-		assert(
-			cmdBuffer == getCurrentCommandBuffer() &&
-			"Cannot end render pass on a command buffer from a different frame"
-		);
-		vkCmdEndRenderPass(cmdBuffer);
+		return swapChainGeneration;
 	}
 
-	VkRenderPass Renderer::getSwapChainRenderPass() const
+	VkImage Renderer::getCurrentImage() const
 	{
-		return swapManager->getRenderPass();
+		assert(isFrameStarted && "Cannot get swap chain image if frame is not in progress");
+		return renderTarget->getImage(currentImageIndex);
+	}
+
+	VkImageView Renderer::getCurrentImageView() const
+	{
+		assert(isFrameStarted && "Cannot get swap chain image view if frame is not in progress");
+		return renderTarget->getImageView(currentImageIndex);
+	}
+
+	VkImage Renderer::getCurrentDepthImage() const
+	{
+		assert(isFrameStarted && "Cannot get depth image if frame is not in progress");
+		return renderTarget->getDepthImage(currentFrameIndex);
+	}
+
+	VkImageView Renderer::getCurrentDepthImageView() const
+	{
+		assert(isFrameStarted && "Cannot get depth image view if frame is not in progress");
+		return renderTarget->getDepthImageView(currentFrameIndex);
 	}
 
 	float Renderer::getAspectRatio() const
 	{
-		return swapManager->extentAspectRatio();
+		return renderTarget->extentAspectRatio();
 	}
 
 	void Renderer::createCommandBuffers()
 	{
-		commandBuffers.resize(AppConstants::MAX_FRAMES_IN_FLIGHT);
+		commandBuffers.resize(framesInFlight);
 
 		VkCommandBufferAllocateInfo allocInfo{};
 		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -171,26 +244,79 @@ namespace Vulkan3DEngine
 		commandBuffers.clear();
 	}
 
+	void Renderer::createTimestampQueryPool()
+	{
+		const VkPhysicalDeviceProperties& properties = devManager.getPhysicalDeviceProperties();
+		if (!properties.limits.timestampComputeAndGraphics) {
+			return;
+		}
+
+		VkQueryPoolCreateInfo queryPoolInfo{};
+		queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		queryPoolInfo.queryCount = static_cast<uint32_t>(framesInFlight) * 2;
+
+		if (vkCreateQueryPool(devManager.getDeviceHandle(), &queryPoolInfo, nullptr, &timestampQueryPool) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create timestamp query pool");
+		}
+		timestampsPending.resize(framesInFlight, false);
+	}
+
+	/**
+	 * Collects the GPU time of the last frame recorded into the current frame's command buffer, whose fence
+	 * has just been waited on
+	 */
+	void Renderer::readTimestamps()
+	{
+		if (timestampQueryPool == VK_NULL_HANDLE || !timestampsPending[currentFrameIndex]) {
+			return;
+		}
+		timestampsPending[currentFrameIndex] = false;
+
+		uint64_t timestamps[2];
+		VkResult result = vkGetQueryPoolResults(
+			devManager.getDeviceHandle(),
+			timestampQueryPool,
+			static_cast<uint32_t>(currentFrameIndex) * 2,
+			2,
+			sizeof(timestamps),
+			timestamps,
+			sizeof(uint64_t),
+			VK_QUERY_RESULT_64_BIT
+		);
+		if (result != VK_SUCCESS) {
+			return;
+		}
+
+		float timestampPeriod = devManager.getPhysicalDeviceProperties().limits.timestampPeriod;
+		frameStatistics.gpuSeconds += static_cast<double>(timestamps[1] - timestamps[0]) * timestampPeriod * 1e-9;
+		++frameStatistics.gpuFrameCount;
+	}
+
 	void Renderer::recreateSwapChain()
 	{
-		VkExtent2D extent{};
-		do {
-			extent = winManager.getExtent();
+		// only block while minimized, a resize must not wait for the next window event
+		VkExtent2D extent = winManager.getExtent();
+		while (extent.width == 0 || extent.height == 0) {
 			glfwWaitEvents();
-		} while (extent.width == 0 || extent.height == 0);
-
-		vkDeviceWaitIdle(devManager.getDeviceHandle());
+			extent = winManager.getExtent();
+		}
 
 		if (swapManager == nullptr) {
-			swapManager = std::make_unique<SwapChainManager>(devManager, extent);
+			swapManager = std::make_unique<SwapChainManager>(devManager, extent, framesInFlight);
 		}
 		else {
+			// no wait for the device: the new swap chain is created from the old one, which stays alive
+			// until the frames already submitted with it have finished
 			std::shared_ptr<SwapChainManager> oldSwapManager = std::move(swapManager);
-			swapManager = std::make_unique<SwapChainManager>(devManager, extent, oldSwapManager);
+			swapManager = std::make_unique<SwapChainManager>(devManager, extent, framesInFlight, oldSwapManager);
 
 			if (!oldSwapManager->areSwapChainFormatsEqual(*swapManager.get())) {
 				throw std::runtime_error("Swap chain image/depth format has changed");
 			}
+			deletionQueue.retire(std::move(oldSwapManager));
 		}
+		renderTarget = swapManager.get();
+		++swapChainGeneration;
 	}
 }
\ No newline at end of file
@@ -0,0 +1,156 @@
+#include "ShaderWatcher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace Vulkan3DEngine
+{
+	ShaderWatcher::ShaderWatcher(
+		const std::string& sourceDirectory,
+		const std::string& outputDirectory,
+		const std::string& compilerPath
+	) : sourceDirectory{ sourceDirectory }, outputDirectory{ outputDirectory }, compilerPath{ compilerPath }
+	{
+#ifdef __linux__
+		inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (inotifyFd < 0) {
+			throw std::runtime_error("Failed to initialize shader watcher");
+		}
+		// editors either rewrite the file in place or rename a temporary over it
+		if (inotify_add_watch(inotifyFd, sourceDirectory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+			close(inotifyFd);
+			throw std::runtime_error("Failed to watch shader directory " + sourceDirectory);
+		}
+#else
+		std::error_code error;
+		for (auto& entry : std::filesystem::directory_iterator(sourceDirectory, error)) {
+			writeTimes[entry.path().filename().string()] = entry.last_write_time(error);
+		}
+#endif
+		thread = std::thread(&ShaderWatcher::watch, this);
+	}
+
+	ShaderWatcher::~ShaderWatcher()
+	{
+		running = false;
+		thread.join();
+#ifdef __linux__
+		close(inotifyFd);
+#endif
+	}
+
+	/**
+	 * Returns the SPIR-V files rebuilt since the last call
+	 */
+	std::vector<std::string> ShaderWatcher::takeCompiledShaders()
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		return std::exchange(compiledShaders, {});
+	}
+
+	void ShaderWatcher::watch()
+	{
+		while (running) {
+			for (auto& fileName : waitForChanges()) {
+				compile(fileName);
+			}
+		}
+	}
+
+	/**
+	 * Blocks for a short while and returns the names of the files changed in the meantime
+	 */
+	std::vector<std::string> ShaderWatcher::waitForChanges()
+	{
+		std::vector<std::string> changed;
+#ifdef __linux__
+		pollfd pollInfo{ inotifyFd, POLLIN, 0 };
+		if (poll(&pollInfo, 1, 200) <= 0) {
+			return changed;
+		}
+
+		alignas(inotify_event) char buffer[4096];
+		ssize_t length;
+		while ((length = read(inotifyFd, buffer, sizeof(buffer))) > 0) {
+			for (char* ptr = buffer; ptr < buffer + length; ) {
+				auto* event = reinterpret_cast<inotify_event*>(ptr);
+				if (event->len > 0 && std::find(changed.begin(), changed.end(), event->name) == changed.end()) {
+					changed.push_back(event->name);
+				}
+				ptr += sizeof(inotify_event) + event->len;
+			}
+		}
+#else
+		std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+		std::error_code error;
+		for (auto& entry : std::filesystem::directory_iterator(sourceDirectory, error)) {
+			auto fileName = entry.path().filename().string();
+			auto writeTime = entry.last_write_time(error);
+			auto& knownTime = writeTimes[fileName];
+			if (writeTime != knownTime) {
+				knownTime = writeTime;
+				changed.push_back(fileName);
+			}
+		}
+#endif
+		return changed;
+	}
+
+	/**
+	 * Compiles into a temporary file and renames it over the previous SPIR-V, so a reader never sees a
+	 * partially written file and a shader with errors leaves the last working version in place.
+	 */
+	void ShaderWatcher::compile(const std::string& fileName)
+	{
+		std::string outputName = getOutputName(fileName);
+		if (outputName.empty()) return;
+
+		std::string sourcePath = sourceDirectory + "/" + fileName;
+		std::string outputPath = outputDirectory + "/" + outputName;
+		std::string tempPath = outputPath + ".tmp";
+
+		std::string command = "\"" + compilerPath + "\" \"" + sourcePath + "\" -o \"" + tempPath + "\"";
+#ifdef _WIN32
+		command = "\"" + command + "\"";	// cmd strips the outer pair of quotes
+#endif
+
+		std::error_code error;
+		if (std::system(command.c_str()) != 0) {
+			std::cerr << "Failed to compile shader " << sourcePath << ", keeping the previous version" << std::endl;
+			std::filesystem::remove(tempPath, error);
+			return;
+		}
+		std::filesystem::rename(tempPath, outputPath, error);
+		if (error) {
+			std::cerr << "Failed to replace " << outputPath << ": " << error.message() << std::endl;
+			return;
+		}
+		std::cout << "Recompiled " << sourcePath << std::endl;
+
+		std::lock_guard<std::mutex> lock{ mutex };
+		if (std::find(compiledShaders.begin(), compiledShaders.end(), outputPath) == compiledShaders.end()) {
+			compiledShaders.push_back(outputPath);
+		}
+	}
+
+	std::string ShaderWatcher::getOutputName(const std::string& fileName)
+	{
+		std::filesystem::path path{ fileName };
+		auto extension = path.extension().string();
+		if (extension != ".vert" && extension != ".frag") {
+			return {};
+		}
+		return path.stem().string() + "_" + extension.substr(1) + ".spv";
+	}
+}
\ No newline at end of file
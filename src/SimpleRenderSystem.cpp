@@ -9,120 +9,244 @@
 
 #include <stdexcept>
 #include <array>
+#include <cstring>
 
 namespace Vulkan3DEngine
 {
-	struct SimplePushConstantData
+	struct SimpleDrawData
 	{
 		glm::mat4 modelMatrix{ 1.f };
 		glm::mat4 normalMatrix{ 1.f };
 	};
 
+	// constant_id values of the specialization constants in simple.frag
+	static constexpr uint32_t LIGHT_COUNT_CONSTANT_ID = 0;
+	static constexpr uint32_t SPECULAR_EXPONENT_CONSTANT_ID = 1;
+	static constexpr uint32_t ENABLE_SPECULAR_CONSTANT_ID = 2;
+
+	struct SimpleBindlessPushConstants
+	{
+		uint32_t drawBufferIndex;	// bindless storage buffer slot holding this frame's draw data
+	};
+
+	struct SimpleDrawItem
+	{
+		const TransformComponent* transform;
+		Model* model;
+	};
+
+	static SimpleDrawData makeDrawData(const TransformComponent& transform)
+	{
+		SimpleDrawData drawData{};
+		drawData.modelMatrix = MathUtils::createTransformationMatrix(
+			transform.translation,
+			transform.rotation,
+			transform.scale
+		);
+		drawData.normalMatrix = MathUtils::createNormalMatrix(
+			transform.rotation,
+			transform.scale
+		);
+		return drawData;
+	}
+
 	std::unique_ptr<SimpleRenderSystem> SimpleRenderSystem::create(
 		DeviceManager& devManager, 
 		VkRenderPass renderPass, 
 		VkDescriptorSetLayout globalSetLayout, 
+		FrameAllocator& frameAllocator,
+		BindlessResources* bindlessResources,
+		PipelineCompiler* pipelineCompiler,
 		const std::string& vertexShaderPath, 
-		const std::string& fragmentShaderPath
+		const std::string& fragmentShaderPath,
+		const std::string& bindlessVertexShaderPath
 	)
 	{
-		auto simpleRenderSystem = std::unique_ptr<SimpleRenderSystem>(new SimpleRenderSystem(devManager));
-		simpleRenderSystem->init(renderPass, globalSetLayout, vertexShaderPath, fragmentShaderPath);
+		auto simpleRenderSystem = std::unique_ptr<SimpleRenderSystem>(
+			new SimpleRenderSystem(devManager, frameAllocator, bindlessResources)
+		);
+		simpleRenderSystem->init(
+			renderPass,
+			globalSetLayout,
+			bindlessResources ? bindlessVertexShaderPath : vertexShaderPath,
+			fragmentShaderPath,
+			pipelineCompiler
+		);
 		return simpleRenderSystem;
 	}
 
-	SimpleRenderSystem::SimpleRenderSystem(DeviceManager& devManager) : RenderSystem(devManager)
+	SimpleRenderSystem::SimpleRenderSystem(
+		DeviceManager& devManager,
+		FrameAllocator& frameAllocator,
+		BindlessResources* bindlessResources
+	) : RenderSystem(devManager), bindlessResources{ bindlessResources }
 	{
+		if (bindlessResources) {
+			for (int i = 0; i < frameAllocator.getFrameCount(); ++i) {
+				drawBufferSlots.push_back(bindlessResources->registerStorageBuffer(frameAllocator.getBuffer(i)));
+			}
+			return;
+		}
+
+		drawSetLayoutManager = DescriptorSetLayoutManager::Builder(devManager)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT)
+			.build();
+
+		int frameCount = frameAllocator.getFrameCount();
+		drawPoolManager = DescriptorPoolManager::Builder(devManager)
+			.setMaxSets(frameCount)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, frameCount)
+			.build();
+
+		drawDescriptorSets.resize(frameCount);
+		for (int i = 0; i < frameCount; ++i) {
+			auto bufferInfo = frameAllocator.descriptorInfo(i, sizeof(SimpleDrawData));
+			if (!DescriptorWriter(*drawSetLayoutManager, *drawPoolManager)
+				.writeBuffer(0, &bufferInfo)
+				.build(drawDescriptorSets[i])) {
+				throw std::runtime_error("Failed to allocate draw descriptor set");
+			}
+		}
 	}
 
 	SimpleRenderSystem::~SimpleRenderSystem()
 	{
+		for (uint32_t slot : drawBufferSlots) {
+			bindlessResources->release(BindlessResources::Kind::StorageBuffer, slot);
+		}
 	}
 
 	void SimpleRenderSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout)
 	{
+		std::vector<VkDescriptorSetLayout> descriptorSetLayouts{
+			globalSetLayout,
+			bindlessResources ? bindlessResources->getDescriptorSetLayout() : drawSetLayoutManager->getDescriptorSetLayout()
+		};
+
 		VkPushConstantRange pushConstantRange{};
-		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 		pushConstantRange.offset = 0;
-		pushConstantRange.size = sizeof(SimplePushConstantData);
-
-		std::vector<VkDescriptorSetLayout> descriptorSetLayouts{ globalSetLayout };
+		pushConstantRange.size = sizeof(SimpleBindlessPushConstants);
 
 		VkPipelineLayoutCreateInfo createInfo{};
 		createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 		createInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
 		createInfo.pSetLayouts = descriptorSetLayouts.data();
-		createInfo.pushConstantRangeCount = 1;
-		createInfo.pPushConstantRanges = &pushConstantRange;
+		createInfo.pushConstantRangeCount = bindlessResources ? 1 : 0;
+		createInfo.pPushConstantRanges = bindlessResources ? &pushConstantRange : nullptr;
 
 		if (vkCreatePipelineLayout(devManager.getDeviceHandle(), &createInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
 			throw std::runtime_error("Failed to create pipeline layout");
 		}
 	}
 
-	void SimpleRenderSystem::createPipeline(
-		VkRenderPass renderPass,
-		const std::string& vertexShaderPath,
-		const std::string& fragmentShaderPath
-	)
+	void SimpleRenderSystem::configurePipeline(PipelineConfigInfo& pipelineConfig)
 	{
-		assert(pipelineLayout != nullptr && "Pipeline cannot be created before the pipeline layout");
-		PipelineConfigInfo pipelineConfig{};
 		GfxPipeline::defaultPipelineConfigInfo(pipelineConfig);
-		pipelineConfig.renderPass = renderPass;
-		pipelineConfig.pipelineLayout = pipelineLayout;
-		gfxPipeline = std::make_unique<GfxPipeline>(
-			devManager,
-			vertexShaderPath,
-			fragmentShaderPath,
-			pipelineConfig
-		);
+		pipelineConfig.fragSpecialization
+			.set(LIGHT_COUNT_CONSTANT_ID, static_cast<int32_t>(AppConstants::MAX_LIGHTS))
+			.set(SPECULAR_EXPONENT_CONSTANT_ID, AppConstants::SPECULAR_EXPONENT)
+			.set(ENABLE_SPECULAR_CONSTANT_ID, static_cast<VkBool32>(AppConstants::ENABLE_SPECULAR));
 	}
 
 	void SimpleRenderSystem::render(FrameData& frameData)
 	{
-		gfxPipeline->bind(frameData.cmdBuffer);
-
-		vkCmdBindDescriptorSets(
-			frameData.cmdBuffer,
-			VK_PIPELINE_BIND_POINT_GRAPHICS,
-			pipelineLayout,
-			0,
-			1,
-			&frameData.globalDescSet,
-			0,
-			nullptr
-		);
-
+		std::vector<SimpleDrawItem> draws;
 		for (auto& kvPair : frameData.entities) {
 			auto& obj = kvPair.second;
 			if (!obj.hasComponent<ModelComponent>() || !obj.hasComponent<TransformComponent>()) continue;
+			if (!obj.getComponent<ModelComponent>()->model->isReady()) continue;
 
-			const TransformComponent& transform = *obj.getComponent<TransformComponent>();
-			SimplePushConstantData pushConstant{};
-			pushConstant.modelMatrix = MathUtils::createTransformationMatrix(
-				transform.translation,
-				transform.rotation,
-				transform.scale
+			draws.push_back({ obj.getComponent<TransformComponent>(), obj.getComponent<ModelComponent>()->model.get() });
+		}
+
+		if (bindlessResources) {
+			renderBindless(frameData, draws);
+			return;
+		}
+
+		// draws are split into chunks recorded on several threads, each binding its own state
+		frameData.commandRecorder.record(draws.size(), [&](VkCommandBuffer commandBuffer, size_t begin, size_t end) {
+			gfxPipeline->bind(commandBuffer);
+
+			vkCmdBindDescriptorSets(
+				commandBuffer,
+				VK_PIPELINE_BIND_POINT_GRAPHICS,
+				pipelineLayout,
+				0,
+				1,
+				&frameData.globalDescSet,
+				1,
+				&frameData.globalUboOffset
 			);
-			pushConstant.normalMatrix = MathUtils::createNormalMatrix(
-				transform.rotation,
-				transform.scale
+
+			// all models live in the shared arena, so vertex and index buffers are bound once
+			frameData.geometryArena.bind(commandBuffer);
+
+			for (size_t i = begin; i < end; ++i) {
+				uint32_t drawOffset = frameData.frameAllocator.push(makeDrawData(*draws[i].transform)).offset;
+				vkCmdBindDescriptorSets(
+					commandBuffer,
+					VK_PIPELINE_BIND_POINT_GRAPHICS,
+					pipelineLayout,
+					1,
+					1,
+					&drawDescriptorSets[frameData.frameIndex],
+					1,
+					&drawOffset
+				);
+
+				draws[i].model->draw(commandBuffer);
+			}
+		});
+	}
+
+	void SimpleRenderSystem::renderBindless(FrameData& frameData, const std::vector<SimpleDrawItem>& draws)
+	{
+		if (draws.empty()) return;
+
+		// the shader indexes the whole buffer in SimpleDrawData sized elements, so the first element is
+		// placed on a multiple of that size; the extra element leaves room for the padding
+		constexpr VkDeviceSize drawDataSize = sizeof(SimpleDrawData);
+		FrameAllocator::Slice slice = frameData.frameAllocator.allocate((draws.size() + 1) * drawDataSize);
+		VkDeviceSize firstByte = (slice.offset + drawDataSize - 1) / drawDataSize * drawDataSize;
+		auto* drawData = reinterpret_cast<SimpleDrawData*>(static_cast<char*>(slice.mapped) + (firstByte - slice.offset));
+		uint32_t firstDraw = static_cast<uint32_t>(firstByte / drawDataSize);
+
+		SimpleBindlessPushConstants push{ drawBufferSlots[frameData.frameIndex] };
+
+		// each chunk writes the draw data of its own range, so packing is spread across threads too
+		frameData.commandRecorder.record(draws.size(), [&](VkCommandBuffer commandBuffer, size_t begin, size_t end) {
+			gfxPipeline->bind(commandBuffer);
+
+			vkCmdBindDescriptorSets(
+				commandBuffer,
+				VK_PIPELINE_BIND_POINT_GRAPHICS,
+				pipelineLayout,
+				0,
+				1,
+				&frameData.globalDescSet,
+				1,
+				&frameData.globalUboOffset
 			);
+			bindlessResources->bind(commandBuffer, pipelineLayout, 1);
 
 			vkCmdPushConstants(
-				frameData.cmdBuffer,
+				commandBuffer,
 				pipelineLayout,
-				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+				VK_SHADER_STAGE_VERTEX_BIT,
 				0,
-				sizeof(SimplePushConstantData),
-				&pushConstant
+				sizeof(SimpleBindlessPushConstants),
+				&push
 			);
 
-			const ModelComponent& modelComp = *obj.getComponent<ModelComponent>();
-			modelComp.model->bind(frameData.cmdBuffer);
-			modelComp.model->draw(frameData.cmdBuffer);
-		}
+			frameData.geometryArena.bind(commandBuffer);
+
+			for (size_t i = begin; i < end; ++i) {
+				drawData[i] = makeDrawData(*draws[i].transform);
+				draws[i].model->draw(commandBuffer, firstDraw + static_cast<uint32_t>(i));
+			}
+		});
 	}
 
 	void SimpleRenderSystem::update(FrameData& frameData, GlobalUbo& ubo)
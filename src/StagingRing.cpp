@@ -0,0 +1,187 @@
+#include "StagingRing.h"
+
+#include "BufferManager.h"
+#include "DeviceManager.h"
+
+#include <stdexcept>
+
+namespace Vulkan3DEngine
+{
+	StagingRing::StagingRing(DeviceManager& deviceManager, VkDeviceSize capacity)
+		: deviceManager{ deviceManager }, capacity{ capacity }
+	{
+		deviceManager.createBuffer(
+			capacity,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			buffer,
+			allocation,
+			MemoryAllocator::Category::Staging
+		);
+	}
+
+	StagingRing::~StagingRing()
+	{
+		VkDevice device = deviceManager.getDeviceHandle();
+		for (auto& batch : inFlight) {
+			vkWaitForFences(device, 1, &batch.fence, VK_TRUE, UINT64_MAX);
+			vkDestroyFence(device, batch.fence, nullptr);
+		}
+		inFlight.clear();
+		for (auto fence : freeFences) {
+			vkDestroyFence(device, fence, nullptr);
+		}
+		pendingOverflowBuffers.clear();
+		deviceManager.destroyBuffer(buffer, allocation);
+	}
+
+	/**
+	 * Reserves a mapped range of the ring. If the ring is full, waits for the oldest submission to
+	 * retire its regions; requests that can never fit get a temporary buffer released with their batch.
+	 *
+	 * @param size Size of the region in bytes
+	 * @param alignment (Optional) Alignment of the region offset
+	 *
+	 * @return Region to write into and copy from; valid until the fence of the next commit signals
+	 */
+	StagingRing::Region StagingRing::allocate(VkDeviceSize size, VkDeviceSize alignment)
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+
+		if (size > capacity) {
+			return allocateOverflow(size);
+		}
+
+		reclaim();
+		while (true) {
+			VkDeviceSize offset = (head + alignment - 1) / alignment * alignment;
+			VkDeviceSize needed = offset - head + size;
+			if (offset + size > capacity) {
+				offset = 0;
+				needed = capacity - head + size;
+			}
+
+			if (usedBytes + needed <= capacity) {
+				head = offset + size;
+				usedBytes += needed;
+				pendingBytes += needed;
+				return { buffer, offset, size, static_cast<char*>(allocation.mapped) + offset };
+			}
+
+			// Only uncommitted regions are left, waiting would never free anything
+			if (inFlight.empty()) {
+				return allocateOverflow(size);
+			}
+			waitOldest();
+		}
+	}
+
+	/**
+	 * Closes the batch of regions allocated since the last commit.
+	 *
+	 * The returned fence must be passed to the queue submission that reads the regions; they are
+	 * recycled once it signals.
+	 */
+	StagingRing::Submission StagingRing::commit()
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+
+		Batch batch{ acquireFence(), nextSerial++, pendingBytes, std::move(pendingOverflowBuffers) };
+		pendingBytes = 0;
+		pendingOverflowBuffers.clear();
+
+		Submission submission{ batch.fence, batch.serial };
+		inFlight.push_back(std::move(batch));
+		return submission;
+	}
+
+	bool StagingRing::isComplete(uint64_t serial)
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		reclaim();
+		return serial <= completedSerial;
+	}
+
+	void StagingRing::wait(uint64_t serial)
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		while (completedSerial < serial && !inFlight.empty()) {
+			waitOldest();
+		}
+	}
+
+	VkDeviceSize StagingRing::getCapacity() const
+	{
+		return capacity;
+	}
+
+	VkDeviceSize StagingRing::getUsedBytes() const
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		return usedBytes;
+	}
+
+	StagingRing::Region StagingRing::allocateOverflow(VkDeviceSize size)
+	{
+		auto overflowBuffer = std::make_unique<BufferManager>(
+			deviceManager,
+			size,
+			1,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			1,
+			MemoryAllocator::Category::Staging
+		);
+		overflowBuffer->map();
+
+		Region region{ overflowBuffer->getBuffer(), 0, size, overflowBuffer->getMappedMemory() };
+		pendingOverflowBuffers.push_back(std::move(overflowBuffer));
+		return region;
+	}
+
+	void StagingRing::reclaim()
+	{
+		VkDevice device = deviceManager.getDeviceHandle();
+		while (!inFlight.empty() && vkGetFenceStatus(device, inFlight.front().fence) == VK_SUCCESS) {
+			Batch& batch = inFlight.front();
+			usedBytes -= batch.bytes;
+			completedSerial = batch.serial;
+
+			vkResetFences(device, 1, &batch.fence);
+			freeFences.push_back(batch.fence);
+			inFlight.pop_front();
+		}
+
+		// Restart at the beginning when idle so small uploads never need to wrap
+		if (usedBytes == 0) {
+			head = 0;
+		}
+	}
+
+	void StagingRing::waitOldest()
+	{
+		VkFence fence = inFlight.front().fence;
+		if (vkWaitForFences(deviceManager.getDeviceHandle(), 1, &fence, VK_TRUE, UINT64_MAX) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to wait for staging ring fence");
+		}
+		reclaim();
+	}
+
+	VkFence StagingRing::acquireFence()
+	{
+		if (!freeFences.empty()) {
+			VkFence fence = freeFences.back();
+			freeFences.pop_back();
+			return fence;
+		}
+
+		VkFenceCreateInfo fenceInfo{};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+		VkFence fence;
+		if (vkCreateFence(deviceManager.getDeviceHandle(), &fenceInfo, nullptr, &fence) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create staging ring fence");
+		}
+		return fence;
+	}
+}
\ No newline at end of file
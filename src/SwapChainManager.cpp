@@ -1,7 +1,6 @@
 #include "SwapChainManager.h"
 
-#include "Constants.h"
-
+#include <algorithm>
 #include <array>
 #include <cstdlib>
 #include <cstring>
@@ -9,11 +8,12 @@
 #include <limits>
 #include <set>
 #include <stdexcept>
+#include <utility>
 
 namespace Vulkan3DEngine
 {
-	SwapChainManager::SwapChainManager(DeviceManager& deviceManager, VkExtent2D windowExtent)
-		: deviceManager{ deviceManager }, windowExtent{ windowExtent }
+	SwapChainManager::SwapChainManager(DeviceManager& deviceManager, VkExtent2D windowExtent, int framesInFlight)
+		: deviceManager{ deviceManager }, windowExtent{ windowExtent }, framesInFlight{ framesInFlight }
 	{
 		init();
 	}
@@ -21,11 +21,15 @@ namespace Vulkan3DEngine
 	SwapChainManager::SwapChainManager(
 		DeviceManager& deviceManager, 
 		VkExtent2D windowExtent, 
+		int framesInFlight,
 		std::shared_ptr<SwapChainManager> oldSwapChainManager
-	) : deviceManager{ deviceManager }, windowExtent{ windowExtent }, oldSwapChainManager{ oldSwapChainManager }
+	) : deviceManager{ deviceManager }, windowExtent{ windowExtent }, framesInFlight{ framesInFlight },
+		oldSwapChainManager{ oldSwapChainManager }
 	{
 		init();
-		oldSwapChainManager = nullptr;
+
+		// the old swap chain is destroyed by its owner once no frame in flight uses it anymore
+		this->oldSwapChainManager = nullptr;
 	}
 
 	SwapChainManager::~SwapChainManager()
@@ -44,29 +48,21 @@ namespace Vulkan3DEngine
 
 		for (int i = 0; i < depthImages.size(); i++) {
 			vkDestroyImageView(device, depthImageViews[i], nullptr);
-			vkDestroyImage(device, depthImages[i], nullptr);
-			vkFreeMemory(device, depthImageMemorys[i], nullptr);
-		}
-
-		for (auto framebuffer : swapChainFramebuffers) {
-			vkDestroyFramebuffer(device, framebuffer, nullptr);
+			deviceManager.destroyImage(depthImages[i], depthImageAllocations[i]);
 		}
 
 		vkDestroyRenderPass(device, renderPass, nullptr);
 
-		// cleanup synchronization objects
-		for (size_t i = 0; i < swapChainImages.size(); i++) {
-			vkDestroySemaphore(device, renderFinishedSemaphores[i], nullptr);
+		// cleanup synchronization objects, the per frame ones are gone if a newer swap chain took them over
+		for (auto semaphore : renderFinishedSemaphores) {
+			vkDestroySemaphore(device, semaphore, nullptr);
 		}
-		for (size_t i = 0; i < AppConstants::MAX_FRAMES_IN_FLIGHT; i++) {
-			vkDestroySemaphore(device, imageAvailableSemaphores[i], nullptr);
-			vkDestroyFence(device, inFlightFences[i], nullptr);
+		for (auto semaphore : imageAvailableSemaphores) {
+			vkDestroySemaphore(device, semaphore, nullptr);
+		}
+		for (auto fence : inFlightFences) {
+			vkDestroyFence(device, fence, nullptr);
 		}
-	}
-
-	VkFramebuffer SwapChainManager::getFrameBuffer(int index)
-	{
-		return swapChainFramebuffers[index];
 	}
 
 	VkRenderPass SwapChainManager::getRenderPass()
@@ -79,6 +75,21 @@ namespace Vulkan3DEngine
 		return swapChainImageViews[index];
 	}
 
+	VkImage SwapChainManager::getImage(int index)
+	{
+		return swapChainImages[index];
+	}
+
+	VkImage SwapChainManager::getDepthImage(int frameIndex)
+	{
+		return depthImages[frameIndex];
+	}
+
+	VkImageView SwapChainManager::getDepthImageView(int frameIndex)
+	{
+		return depthImageViews[frameIndex];
+	}
+
 	size_t SwapChainManager::getImageCount()
 	{
 		return swapChainImages.size();
@@ -89,6 +100,11 @@ namespace Vulkan3DEngine
 		return swapChainImageFormat;
 	}
 
+	VkFormat SwapChainManager::getSwapChainDepthFormat()
+	{
+		return swapChainDepthFormat;
+	}
+
 	VkExtent2D SwapChainManager::getSwapChainExtent()
 	{
 		return swapChainExtent;
@@ -109,6 +125,16 @@ namespace Vulkan3DEngine
 		return static_cast<float>(swapChainExtent.width) / static_cast<float>(swapChainExtent.height);
 	}
 
+	VkImageLayout SwapChainManager::getOutputLayout()
+	{
+		return VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	}
+
+	bool SwapChainManager::supportsReadback()
+	{
+		return transferSource;
+	}
+
 	VkFormat SwapChainManager::findDepthFormat()
 	{
 		return deviceManager.findSupportedFormat(
@@ -140,7 +166,11 @@ namespace Vulkan3DEngine
 		return result;
 	}
 
-	VkResult SwapChainManager::submitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex)
+	VkResult SwapChainManager::submitCommandBuffers(
+		const VkCommandBuffer* buffers,
+		uint32_t* imageIndex,
+		const std::vector<VkSemaphore>& uploadSemaphores
+	)
 	{
 		if (imagesInFlight[*imageIndex] != VK_NULL_HANDLE) {
 			vkWaitForFences(deviceManager.getDeviceHandle(), 1, &imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
@@ -150,11 +180,13 @@ namespace Vulkan3DEngine
 		VkSubmitInfo submitInfo = {};
 		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-		VkSemaphore waitSemaphores[] = { imageAvailableSemaphores[currentFrame] };
-		VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-		submitInfo.waitSemaphoreCount = 1;
-		submitInfo.pWaitSemaphores = waitSemaphores;
-		submitInfo.pWaitDstStageMask = waitStages;
+		std::vector<VkSemaphore> waitSemaphores{ imageAvailableSemaphores[currentFrame] };
+		std::vector<VkPipelineStageFlags> waitStages{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+		waitSemaphores.insert(waitSemaphores.end(), uploadSemaphores.begin(), uploadSemaphores.end());
+		waitStages.resize(waitSemaphores.size(), VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+		submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+		submitInfo.pWaitSemaphores = waitSemaphores.data();
+		submitInfo.pWaitDstStageMask = waitStages.data();
 
 		submitInfo.commandBufferCount = 1;
 		submitInfo.pCommandBuffers = buffers;
@@ -187,7 +219,7 @@ namespace Vulkan3DEngine
 
 		auto result = vkQueuePresentKHR(deviceManager.getPresentQueueHandle(), &presentInfo);
 
-		currentFrame = (currentFrame + 1) % AppConstants::MAX_FRAMES_IN_FLIGHT;
+		currentFrame = (currentFrame + 1) % framesInFlight;
 
 		return result;
 	}
@@ -204,7 +236,6 @@ namespace Vulkan3DEngine
 		createImageViews();
 		createRenderPass();
 		createDepthResources();
-		createFramebuffers();
 		createSyncObjects();
 	}
 
@@ -216,7 +247,8 @@ namespace Vulkan3DEngine
 		VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
 		VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities);
 
-		uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
+		// enough images for every frame in flight to hold one, so acquiring does not throttle the pipelining
+		uint32_t imageCount = std::max(swapChainSupport.capabilities.minImageCount + 1, static_cast<uint32_t>(framesInFlight));
 		if (swapChainSupport.capabilities.maxImageCount > 0 &&
 			imageCount > swapChainSupport.capabilities.maxImageCount) {
 			imageCount = swapChainSupport.capabilities.maxImageCount;
@@ -233,6 +265,12 @@ namespace Vulkan3DEngine
 		createInfo.imageArrayLayers = 1;
 		createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
 
+		// lets frames be read back for exporting, where the surface allows it
+		transferSource = (swapChainSupport.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) != 0;
+		if (transferSource) {
+			createInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		}
+
 		QueueFamilyIndices indices = deviceManager.getQueueFamilies();
 		uint32_t queueFamilyIndices[] = { indices.graphicsFamily.value(), indices.presentFamily.value() };
 
@@ -289,15 +327,20 @@ namespace Vulkan3DEngine
 		}
 	}
 
+	/**
+	 * One depth image per frame in flight, since only frames being rendered use depth and its contents
+	 * are never stored. The images are transient attachments in lazily allocated memory where the device
+	 * has it, so tile based GPUs need not back them with memory at all.
+	 */
 	void SwapChainManager::createDepthResources()
 	{
 		VkFormat depthFormat = findDepthFormat();
 		swapChainDepthFormat = depthFormat;
 		VkExtent2D extent = getSwapChainExtent();
 
-		depthImages.resize(getImageCount());
-		depthImageMemorys.resize(getImageCount());
-		depthImageViews.resize(getImageCount());
+		depthImages.resize(framesInFlight);
+		depthImageAllocations.resize(framesInFlight);
+		depthImageViews.resize(framesInFlight);
 
 		for (int i = 0; i < depthImages.size(); i++) {
 			VkImageCreateInfo imageInfo{};
@@ -311,7 +354,7 @@ namespace Vulkan3DEngine
 			imageInfo.format = depthFormat;
 			imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
 			imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-			imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+			imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
 			imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
 			imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 			imageInfo.flags = 0;
@@ -320,7 +363,9 @@ namespace Vulkan3DEngine
 				imageInfo,
 				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 				depthImages[i],
-				depthImageMemorys[i]
+				depthImageAllocations[i],
+				MemoryAllocator::Category::Depth,
+				VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT
 			);
 
 			VkImageViewCreateInfo viewInfo{};
@@ -342,6 +387,16 @@ namespace Vulkan3DEngine
 
 	void SwapChainManager::createRenderPass()
 	{
+		// render systems keep the render pass their pipelines were built against, so it outlives
+		// recreations as long as the formats stay the same
+		if (oldSwapChainManager &&
+			oldSwapChainManager->swapChainImageFormat == swapChainImageFormat &&
+			oldSwapChainManager->swapChainDepthFormat == findDepthFormat()) {
+			renderPass = oldSwapChainManager->renderPass;
+			oldSwapChainManager->renderPass = VK_NULL_HANDLE;
+			return;
+		}
+
 		VkAttachmentDescription depthAttachment{};
 		depthAttachment.format = findDepthFormat();
 		depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
@@ -378,12 +433,13 @@ namespace Vulkan3DEngine
 
 		VkSubpassDependency dependency = {};
 		dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-		dependency.srcAccessMask = 0;
+		// only for compatibility, the frame graph records the barriers of the passes it creates
+		dependency.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 		dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | 
-			VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+			VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
 		dependency.dstSubpass = 0;
 		dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | 
-			VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+			VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
 		dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | 
 			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 
@@ -402,34 +458,14 @@ namespace Vulkan3DEngine
 		}
 	}
 
-	void SwapChainManager::createFramebuffers()
-	{
-		swapChainFramebuffers.resize(getImageCount());
-		for (size_t i = 0; i < getImageCount(); i++) {
-			std::array<VkImageView, 2> attachments = { swapChainImageViews[i], depthImageViews[i] };
-
-			VkExtent2D extent = getSwapChainExtent();
-			VkFramebufferCreateInfo framebufferInfo = {};
-			framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-			framebufferInfo.renderPass = renderPass;
-			framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-			framebufferInfo.pAttachments = attachments.data();
-			framebufferInfo.width = extent.width;
-			framebufferInfo.height = extent.height;
-			framebufferInfo.layers = 1;
-
-			if (vkCreateFramebuffer(deviceManager.getDeviceHandle(), &framebufferInfo, nullptr, &swapChainFramebuffers[i]) 
-				!= VK_SUCCESS) {
-				throw std::runtime_error("Failed to create framebuffer");
-			}
-		}
-	}
-
+	/**
+	 * Render finished semaphores belong to the swap chain images. The per frame fences and acquire
+	 * semaphores are taken over from the old swap chain, whose frames may still be in flight: waiting on
+	 * the same fences keeps the frame pacing going across the recreation without draining the GPU.
+	 */
 	void SwapChainManager::createSyncObjects()
 	{
-		imageAvailableSemaphores.resize(AppConstants::MAX_FRAMES_IN_FLIGHT);
 		renderFinishedSemaphores.resize(swapChainImages.size());
-		inFlightFences.resize(AppConstants::MAX_FRAMES_IN_FLIGHT);
 		imagesInFlight.resize(getImageCount(), VK_NULL_HANDLE);
 
 		VkSemaphoreCreateInfo semaphoreInfo = {};
@@ -439,11 +475,22 @@ namespace Vulkan3DEngine
 		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
 		fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-		for (size_t i = 0; i < AppConstants::MAX_FRAMES_IN_FLIGHT; i++) {
-			if (vkCreateSemaphore(deviceManager.getDeviceHandle(), &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) !=
-				VK_SUCCESS ||
-				vkCreateFence(deviceManager.getDeviceHandle(), &fenceInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS) {
-				throw std::runtime_error("Failed to create synchronization objects");
+		if (oldSwapChainManager) {
+			imageAvailableSemaphores = std::move(oldSwapChainManager->imageAvailableSemaphores);
+			inFlightFences = std::move(oldSwapChainManager->inFlightFences);
+			currentFrame = oldSwapChainManager->currentFrame;
+			oldSwapChainManager->imageAvailableSemaphores.clear();
+			oldSwapChainManager->inFlightFences.clear();
+		}
+		else {
+			imageAvailableSemaphores.resize(framesInFlight);
+			inFlightFences.resize(framesInFlight);
+			for (int i = 0; i < framesInFlight; i++) {
+				if (vkCreateSemaphore(deviceManager.getDeviceHandle(), &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) !=
+					VK_SUCCESS ||
+					vkCreateFence(deviceManager.getDeviceHandle(), &fenceInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS) {
+					throw std::runtime_error("Failed to create synchronization objects");
+				}
 			}
 		}
 		for (size_t i = 0; i < swapChainImages.size(); i++) {
@@ -0,0 +1,55 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace Vulkan3DEngine
+{
+	ThreadPool::ThreadPool(uint32_t threadCount)
+	{
+		threadCount = std::max(threadCount, 1u);
+		for (uint32_t i = 0; i < threadCount; ++i) {
+			workers.emplace_back(&ThreadPool::workerLoop, this);
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			stopping = true;
+		}
+		condition.notify_all();
+		for (auto& worker : workers) {
+			worker.join();
+		}
+	}
+
+	uint32_t ThreadPool::getThreadCount() const
+	{
+		return static_cast<uint32_t>(workers.size());
+	}
+
+	uint32_t ThreadPool::getDefaultThreadCount()
+	{
+		uint32_t hardwareThreads = std::thread::hardware_concurrency();
+		return hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+
+	void ThreadPool::workerLoop()
+	{
+		while (true) {
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock{ mutex };
+				condition.wait(lock, [this]() { return stopping || !tasks.empty(); });
+				if (tasks.empty()) {
+					return;
+				}
+				task = std::move(tasks.front());
+				tasks.pop();
+			}
+			// exceptions are stored in the task's future
+			task();
+		}
+	}
+}
\ No newline at end of file
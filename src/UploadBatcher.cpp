@@ -0,0 +1,214 @@
+#include "UploadBatcher.h"
+
+#include "DeviceManager.h"
+
+#include <stdexcept>
+
+namespace Vulkan3DEngine
+{
+	UploadBatcher::UploadBatcher(DeviceManager& deviceManager, StagingRing& stagingRing, VkQueue queue, uint32_t queueFamilyIndex)
+		: deviceManager{ deviceManager }, stagingRing{ stagingRing }, queue{ queue }
+	{
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = queueFamilyIndex;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+		if (vkCreateCommandPool(deviceManager.getDeviceHandle(), &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create upload command pool");
+		}
+	}
+
+	UploadBatcher::~UploadBatcher()
+	{
+		wait(nextTicket);
+		for (VkSemaphore semaphore : semaphores) {
+			vkDestroySemaphore(deviceManager.getDeviceHandle(), semaphore, nullptr);
+		}
+		vkDestroyCommandPool(deviceManager.getDeviceHandle(), commandPool, nullptr);
+	}
+
+	/**
+	 * Reserves staging memory for data that will be copied with copyBuffer before the next flush.
+	 * Submits the current batch first if it already holds a large share of the staging ring.
+	 */
+	StagingRing::Region UploadBatcher::allocateStaging(VkDeviceSize size, VkDeviceSize alignment)
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+
+		if (!pendingCopies.empty() && pendingStagingBytes + size > stagingRing.getCapacity() / AUTO_FLUSH_DIVISOR) {
+			submitPending();
+		}
+		pendingStagingBytes += size;
+		return stagingRing.allocate(size, alignment);
+	}
+
+	/**
+	 * Queues a buffer copy into the current batch
+	 *
+	 * @return Ticket of the batch, complete once the copy has finished on the GPU
+	 */
+	UploadBatcher::Ticket UploadBatcher::copyBuffer(
+		VkBuffer src,
+		VkBuffer dst,
+		VkDeviceSize size,
+		VkDeviceSize srcOffset,
+		VkDeviceSize dstOffset
+	)
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+
+		VkBufferCopy region{};
+		region.srcOffset = srcOffset;
+		region.dstOffset = dstOffset;
+		region.size = size;
+		pendingCopies.push_back({ src, dst, region });
+		return nextTicket;
+	}
+
+	/**
+	 * Records all queued copies into one command buffer and submits it
+	 *
+	 * @return Ticket of the submitted batch, or of the last batch if nothing was queued
+	 */
+	UploadBatcher::Ticket UploadBatcher::flush()
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		return submitPending();
+	}
+
+	bool UploadBatcher::isComplete(Ticket ticket)
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		retireCompleted();
+		return ticket <= completedTicket;
+	}
+
+	void UploadBatcher::wait(Ticket ticket)
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		if (ticket >= nextTicket) {
+			submitPending();
+		}
+		while (completedTicket < ticket && !submitted.empty()) {
+			stagingRing.wait(submitted.front().stagingSerial);
+			retireCompleted();
+		}
+	}
+
+	/**
+	 * Hands out the semaphores of every batch seen complete so far, see isComplete. The caller's next
+	 * graphics submission has to wait for all of them, so anything drawn with data it observed as
+	 * uploaded reads the transfer queue's writes. Each semaphore is waited for exactly once; give them
+	 * back with recycleSemaphores once that submission has finished.
+	 */
+	std::vector<VkSemaphore> UploadBatcher::takeCompletedSemaphores()
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		retireCompleted();
+		std::vector<VkSemaphore> taken;
+		taken.swap(completedSemaphores);
+		return taken;
+	}
+
+	void UploadBatcher::recycleSemaphores(const std::vector<VkSemaphore>& waitedSemaphores)
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		freeSemaphores.insert(freeSemaphores.end(), waitedSemaphores.begin(), waitedSemaphores.end());
+	}
+
+	UploadBatcher::Ticket UploadBatcher::submitPending()
+	{
+		if (pendingCopies.empty()) {
+			return nextTicket - 1;
+		}
+
+		VkCommandBufferAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandPool = commandPool;
+		allocInfo.commandBufferCount = 1;
+
+		VkCommandBuffer commandBuffer;
+		if (vkAllocateCommandBuffers(deviceManager.getDeviceHandle(), &allocInfo, &commandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to allocate upload command buffer");
+		}
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+		// Consecutive copies between the same pair of buffers go into a single command
+		std::vector<VkBufferCopy> regions;
+		for (size_t i = 0; i < pendingCopies.size(); ++i) {
+			regions.push_back(pendingCopies[i].region);
+			bool lastOfRun = i + 1 == pendingCopies.size() ||
+				pendingCopies[i + 1].src != pendingCopies[i].src ||
+				pendingCopies[i + 1].dst != pendingCopies[i].dst;
+			if (lastOfRun) {
+				vkCmdCopyBuffer(
+					commandBuffer,
+					pendingCopies[i].src,
+					pendingCopies[i].dst,
+					static_cast<uint32_t>(regions.size()),
+					regions.data()
+				);
+				regions.clear();
+			}
+		}
+
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to record upload command buffer");
+		}
+
+		VkSemaphore semaphore = acquireSemaphore();
+		StagingRing::Submission staging = stagingRing.commit();
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffer;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &semaphore;
+
+		if (vkQueueSubmit(queue, 1, &submitInfo, staging.fence) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to submit upload command buffer");
+		}
+
+		submitted.push_back({ nextTicket, staging.serial, commandBuffer, semaphore });
+		pendingCopies.clear();
+		pendingStagingBytes = 0;
+		return nextTicket++;
+	}
+
+	void UploadBatcher::retireCompleted()
+	{
+		while (!submitted.empty() && stagingRing.isComplete(submitted.front().stagingSerial)) {
+			Submission& submission = submitted.front();
+			vkFreeCommandBuffers(deviceManager.getDeviceHandle(), commandPool, 1, &submission.commandBuffer);
+			completedSemaphores.push_back(submission.semaphore);
+			completedTicket = submission.ticket;
+			submitted.pop_front();
+		}
+	}
+
+	VkSemaphore UploadBatcher::acquireSemaphore()
+	{
+		if (!freeSemaphores.empty()) {
+			VkSemaphore semaphore = freeSemaphores.back();
+			freeSemaphores.pop_back();
+			return semaphore;
+		}
+
+		VkSemaphoreCreateInfo semaphoreInfo{};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+		VkSemaphore semaphore;
+		if (vkCreateSemaphore(deviceManager.getDeviceHandle(), &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create upload semaphore");
+		}
+		semaphores.push_back(semaphore);
+		return semaphore;
+	}
+}
\ No newline at end of file
@@ -4,14 +4,17 @@
 
 namespace Vulkan3DEngine
 {
-	WindowManager::WindowManager(int width, int height, std::string windowTitle)
-		: width(width), height(height), windowTitle(windowTitle)
+	WindowManager::WindowManager(int width, int height, std::string windowTitle, bool headless)
+		: width(width), height(height), headless(headless), windowTitle(windowTitle)
 	{
-		initWindow();
+		if (!headless) {
+			initWindow();
+		}
 	}
 
 	WindowManager::~WindowManager()
 	{
+		if (headless) return;
 		glfwDestroyWindow(window);
 		glfwTerminate();
 	}
@@ -21,9 +24,21 @@ namespace Vulkan3DEngine
 		return window;
 	}
 
+	bool WindowManager::isHeadless() const
+	{
+		return headless;
+	}
+
 	bool WindowManager::windowShouldClose() const
 	{
-		return glfwWindowShouldClose(window);
+		return !headless && glfwWindowShouldClose(window);
+	}
+
+	void WindowManager::pollEvents()
+	{
+		if (!headless) {
+			glfwPollEvents();
+		}
 	}
 
 	bool WindowManager::windowWasResized() const
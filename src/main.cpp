@@ -1,14 +1,70 @@
 #include "AppController.h"
+#include "Constants.h"
 
 #include <stdexcept>
 #include <iostream>
 #include <cstdlib>
+#include <cstring>
+#include <string>
 
-int main()
+int main(int argc, char** argv)
 {
+	using Vulkan3DEngine::AppConstants;
+
+	bool benchmarkDescriptors = false;
+	bool headless = false;
+	uint64_t frameLimit = 0;
+	int framesInFlight = AppConstants::DEFAULT_FRAMES_IN_FLIGHT;
+	std::string exportDirectory;
+	auto exportFormat = Vulkan3DEngine::FrameReadback::Format::Png;
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--bench-descriptors") == 0) {
+			benchmarkDescriptors = true;
+		}
+		else if (std::strcmp(argv[i], "--headless") == 0) {
+			headless = true;
+		}
+		else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+			frameLimit = std::strtoull(argv[++i], nullptr, 10);
+		}
+		else if (std::strcmp(argv[i], "--export") == 0 && i + 1 < argc) {
+			exportDirectory = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--export-format") == 0 && i + 1 < argc) {
+			const char* formatName = argv[++i];
+			if (std::strcmp(formatName, "png") == 0) {
+				exportFormat = Vulkan3DEngine::FrameReadback::Format::Png;
+			}
+			else if (std::strcmp(formatName, "raw") == 0) {
+				exportFormat = Vulkan3DEngine::FrameReadback::Format::Raw;
+			}
+			else {
+				std::cerr << "--export-format must be png or raw" << std::endl;
+				exit(EXIT_FAILURE);
+			}
+		}
+		else if (std::strcmp(argv[i], "--frames-in-flight") == 0 && i + 1 < argc) {
+			framesInFlight = std::atoi(argv[++i]);
+			if (framesInFlight < AppConstants::MIN_FRAMES_IN_FLIGHT || framesInFlight > AppConstants::MAX_FRAMES_IN_FLIGHT) {
+				std::cerr << "--frames-in-flight must be between " << AppConstants::MIN_FRAMES_IN_FLIGHT << " and "
+					<< AppConstants::MAX_FRAMES_IN_FLIGHT << std::endl;
+				exit(EXIT_FAILURE);
+			}
+		}
+	}
+
+	if (headless && frameLimit == 0) {
+		frameLimit = AppConstants::DEFAULT_HEADLESS_FRAME_COUNT;
+	}
+
 	try {
-		Vulkan3DEngine::AppController controller{};
-		controller.run();
+		Vulkan3DEngine::AppController controller{ framesInFlight, headless };
+		if (benchmarkDescriptors) {
+			controller.benchmarkDescriptors();
+		}
+		else {
+			controller.run(frameLimit, exportDirectory, exportFormat);
+		}
 	}
 	catch (std::exception& e) {
 		std::cerr << "Exception: " << e.what() << std::endl;